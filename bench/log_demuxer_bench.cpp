@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2025 Nokaji. Tous droits réservés.
+ * Ce fichier fait partie du projet Kernel-James.
+ */
+#include "log_demuxer.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+/*
+ * LogDemuxer throughput: framed (one 8-byte header per line, as the daemon
+ * writes them) and raw (TTY) buffers of 80-byte lines, fed in chunks the size
+ * curl typically hands out. Usage: log_demuxer_bench [MiB] [chunk bytes] [rounds]
+ */
+
+namespace {
+    constexpr size_t LINE_LENGTH = 80;
+
+    std::string makeLine(size_t index) {
+        std::string line = "2024-05-01T12:00:00.000000000Z worker " + std::to_string(index) + " processed request ";
+        line.resize(LINE_LENGTH - 1, 'x');
+        line += '\n';
+        return line;
+    }
+
+    std::string makeRaw(size_t bytes) {
+        std::string buffer;
+        buffer.reserve(bytes + LINE_LENGTH);
+        for (size_t i = 0; buffer.size() < bytes; ++i) buffer += makeLine(i);
+        return buffer;
+    }
+
+    std::string makeFramed(size_t bytes) {
+        std::string buffer;
+        buffer.reserve(bytes + LINE_LENGTH + 8);
+        for (size_t i = 0; buffer.size() < bytes; ++i) {
+            const std::string line = makeLine(i);
+            const auto size = static_cast<uint32_t>(line.size());
+            const char header[8] = {static_cast<char>(i % 2 ? 2 : 1), 0, 0, 0,
+                                    static_cast<char>(size >> 24), static_cast<char>(size >> 16),
+                                    static_cast<char>(size >> 8), static_cast<char>(size)};
+            buffer.append(header, sizeof(header));
+            buffer += line;
+        }
+        return buffer;
+    }
+
+    void run(const char *label, const std::string &buffer, LogDemuxer::Mode mode, size_t chunk, int rounds) {
+        size_t lines = 0;
+        size_t lineBytes = 0;
+        const LogDemuxer::LineCallback count = [&lines, &lineBytes](containerTypes::LogStream, std::string_view line) {
+            ++lines;
+            lineBytes += line.size();
+        };
+
+        double best = 0;
+        for (int round = 0; round < rounds; ++round) {
+            LogDemuxer demuxer(mode);
+            lines = 0;
+            lineBytes = 0;
+            const auto started = std::chrono::steady_clock::now();
+            for (size_t offset = 0; offset < buffer.size(); offset += chunk) {
+                demuxer.feed(buffer.data() + offset, std::min(chunk, buffer.size() - offset), count);
+            }
+            demuxer.flush(count);
+            const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - started;
+            best = std::max(best, static_cast<double>(buffer.size()) / elapsed.count() / 1e9);
+        }
+        std::printf("%-8s %8.1f MiB  %10zu lines  %6.2f GB/s (best of %d)\n", label,
+                    static_cast<double>(buffer.size()) / (1 << 20), lines, best, rounds);
+        if (lineBytes == 0) std::printf("no line decoded\n");
+    }
+}
+
+int main(int argc, char **argv) {
+    const size_t mebibytes = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 256;
+    const size_t chunk = argc > 2 ? std::max<size_t>(1, std::strtoull(argv[2], nullptr, 10)) : 16 * 1024;
+    const int rounds = argc > 3 ? std::max(1, std::atoi(argv[3])) : 5;
+    const size_t bytes = mebibytes << 20;
+
+    std::printf("chunks of %zu bytes, %zu-byte lines\n", chunk, LINE_LENGTH);
+    run("framed", makeFramed(bytes), LogDemuxer::Mode::Framed, chunk, rounds);
+    run("raw", makeRaw(bytes), LogDemuxer::Mode::Raw, chunk, rounds);
+    return 0;
+}
@@ -0,0 +1,360 @@
+/*
+ * Copyright (c) 2025 Nokaji. Tous droits réservés.
+ * Ce fichier fait partie du projet Kernel-James.
+ */
+#include "build_context.h"
+#include "parallel.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace fs = std::filesystem;
+
+namespace {
+    constexpr size_t HASH_CHUNK = 1024 * 1024;
+    constexpr char CACHE_MAGIC[] = "KJBC1\n";
+    // Files modified this recently may change again within the same mtime tick: always rehashed
+    constexpr int64_t RACY_NANOSECONDS = 2'000'000'000;
+
+    uint64_t rotl(uint64_t value, int shift) {
+        return (value << shift) | (value >> (64 - shift));
+    }
+
+    uint64_t mixLane(uint64_t lane) {
+        lane *= 0x87c37b91114253d5ULL;
+        lane = rotl(lane, 31);
+        return lane * 0x4cf5ad432745937fULL;
+    }
+
+    // murmur3-style 64-bit hash, 8 bytes per step
+    uint64_t hashBytes(const void *data, size_t size, uint64_t seed) {
+        const auto *bytes = static_cast<const unsigned char *>(data);
+        uint64_t hash = seed ^ (size * 0x9e3779b97f4a7c15ULL);
+        for (; size >= 8; bytes += 8, size -= 8) {
+            uint64_t lane;
+            std::memcpy(&lane, bytes, 8);
+            hash ^= mixLane(lane);
+            hash = rotl(hash, 27) * 5 + 0x52dce729;
+        }
+        if (size > 0) {
+            uint64_t lane = 0;
+            std::memcpy(&lane, bytes, size);
+            hash ^= mixLane(lane);
+        }
+        hash ^= hash >> 33;
+        hash *= 0xff51afd7ed558ccdULL;
+        hash ^= hash >> 33;
+        hash *= 0xc4ceb9fe1a85ec53ULL;
+        return hash ^ (hash >> 33);
+    }
+
+    uint64_t hashValue(uint64_t value, uint64_t seed) {
+        return hashBytes(&value, sizeof(value), seed);
+    }
+
+    uint64_t hashFile(const fs::path &path) {
+        std::unique_ptr<std::FILE, int (*)(std::FILE *)> file(std::fopen(path.string().c_str(), "rb"), &std::fclose);
+        if (!file) {
+            throw std::runtime_error("Cannot read " + path.string());
+        }
+        std::setvbuf(file.get(), nullptr, _IONBF, 0);
+        std::vector<char> buffer(HASH_CHUNK);
+        uint64_t hash = 0;
+        size_t count;
+        while ((count = std::fread(buffer.data(), 1, buffer.size(), file.get())) > 0) {
+            hash = hashBytes(buffer.data(), count, hash);
+        }
+        if (std::ferror(file.get())) {
+            throw std::runtime_error("Cannot read " + path.string());
+        }
+        return hash;
+    }
+
+    int64_t modificationTime(const fs::path &path) {
+        std::error_code error;
+        const auto time = fs::last_write_time(path, error);
+        if (error) return 0;
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::file_clock::to_sys(time).time_since_epoch()).count();
+    }
+
+    std::string trim(std::string_view text) {
+        const size_t first = text.find_first_not_of(" \t\r\n");
+        if (first == std::string_view::npos) return {};
+        const size_t last = text.find_last_not_of(" \t\r\n");
+        return std::string(text.substr(first, last - first + 1));
+    }
+
+    // '[...]' at pattern[0]; advances pattern past it. False if the class does not match c.
+    bool matchClass(std::string_view &pattern, char c) {
+        size_t i = 1;
+        bool negate = false;
+        if (i < pattern.size() && (pattern[i] == '^' || pattern[i] == '!')) {
+            negate = true;
+            ++i;
+        }
+        bool matched = false;
+        bool first = true;
+        while (i < pattern.size() && (first || pattern[i] != ']')) {
+            first = false;
+            char low = pattern[i];
+            if (low == '\\' && i + 1 < pattern.size()) low = pattern[++i];
+            char high = low;
+            if (i + 2 < pattern.size() && pattern[i + 1] == '-' && pattern[i + 2] != ']') {
+                high = pattern[i + 2];
+                if (high == '\\' && i + 3 < pattern.size()) high = pattern[++i + 2];
+                i += 2;
+            }
+            if (c >= low && c <= high) matched = true;
+            ++i;
+        }
+        pattern.remove_prefix(std::min(i + 1, pattern.size()));
+        return matched != negate;
+    }
+}
+
+DockerIgnore::DockerIgnore(const std::vector<std::string> &patterns) {
+    for (const auto &line : patterns) {
+        std::string pattern = trim(line);
+        if (pattern.empty() || pattern[0] == '#') continue;
+
+        bool exception = false;
+        if (pattern[0] == '!') {
+            exception = true;
+            pattern = trim(std::string_view(pattern).substr(1));
+        }
+        // Rules are relative to the context root whatever their form
+        pattern = fs::path(pattern).lexically_normal().generic_string();
+        while (!pattern.empty() && pattern.front() == '/') pattern.erase(0, 1);
+        while (!pattern.empty() && pattern.back() == '/') pattern.pop_back();
+        if (pattern.empty() || pattern == ".") continue;
+
+        anyException = anyException || exception;
+        rules.push_back({std::move(pattern), exception});
+    }
+}
+
+DockerIgnore DockerIgnore::load(const fs::path &file) {
+    std::ifstream input(file);
+    std::vector<std::string> lines;
+    std::string line;
+    while (std::getline(input, line)) lines.push_back(line);
+    return DockerIgnore(lines);
+}
+
+bool DockerIgnore::match(std::string_view pattern, std::string_view path) {
+    while (!pattern.empty()) {
+        if (pattern.substr(0, 2) == "**") {
+            std::string_view rest = pattern.substr(2);
+            if (!rest.empty() && rest[0] == '/') rest.remove_prefix(1);
+            if (rest.empty()) return true;
+            // Any number of components, including none
+            for (size_t i = 0; i <= path.size(); ++i) {
+                if ((i == 0 || path[i - 1] == '/') && match(rest, path.substr(i))) return true;
+            }
+            return false;
+        }
+
+        const char c = pattern[0];
+        if (c == '*') {
+            pattern.remove_prefix(1);
+            for (size_t i = 0; i <= path.size(); ++i) {
+                if (match(pattern, path.substr(i))) return true;
+                if (i < path.size() && path[i] == '/') break;
+            }
+            return false;
+        }
+        if (path.empty()) return false;
+        if (c == '?') {
+            if (path[0] == '/') return false;
+            pattern.remove_prefix(1);
+        } else if (c == '[') {
+            if (path[0] == '/' || !matchClass(pattern, path[0])) return false;
+        } else {
+            char literal = c;
+            if (c == '\\' && pattern.size() > 1) {
+                literal = pattern[1];
+                pattern.remove_prefix(1);
+            }
+            if (literal != path[0]) return false;
+            pattern.remove_prefix(1);
+        }
+        path.remove_prefix(1);
+    }
+    return path.empty();
+}
+
+bool DockerIgnore::excluded(std::string_view path) const {
+    bool result = false;
+    for (const auto &rule : rules) {
+        // Only rules that would flip the current answer need matching
+        if (rule.exception != result) continue;
+
+        bool matched = match(rule.pattern, path);
+        for (size_t slash = path.find('/'); !matched && slash != std::string_view::npos; slash = path.find('/', slash + 1)) {
+            matched = match(rule.pattern, path.substr(0, slash));
+        }
+        if (matched) result = !rule.exception;
+    }
+    return result;
+}
+
+BuildContext::BuildContext(fs::path contextDirectory, std::string dockerfileName)
+    : directory(std::move(contextDirectory)), dockerfile(std::move(dockerfileName)) {
+    if (!fs::is_directory(directory)) {
+        throw std::runtime_error("Build context is not a directory: " + directory.string());
+    }
+}
+
+const std::vector<BuildContextEntry> &BuildContext::scan() {
+    const DockerIgnore ignore = DockerIgnore::load(directory / ".dockerignore");
+    const std::string dockerfileName = fs::path(dockerfile).lexically_normal().generic_string();
+
+    entries.clear();
+    std::error_code error;
+    fs::recursive_directory_iterator iterator(directory, fs::directory_options::none, error);
+    if (error) {
+        throw std::runtime_error("Cannot read build context " + directory.string() + ": " + error.message());
+    }
+    for (; iterator != fs::recursive_directory_iterator(); iterator.increment(error)) {
+        if (error) {
+            throw std::runtime_error("Cannot read build context " + directory.string() + ": " + error.message());
+        }
+        const fs::path &path = iterator->path();
+        const std::string name = path.lexically_relative(directory).generic_string();
+        const auto status = iterator->symlink_status();
+
+        if (name != dockerfileName && name != ".dockerignore" && ignore.excluded(name)) {
+            if (status.type() == fs::file_type::directory && !ignore.hasExceptions()) {
+                iterator.disable_recursion_pending();
+            }
+            continue;
+        }
+
+        BuildContextEntry entry;
+        entry.name = name;
+        entry.path = path;
+        entry.type = status.type();
+        entry.mode = static_cast<unsigned>(status.permissions()) & 07777;
+        if (entry.type == fs::file_type::regular) entry.size = iterator->file_size();
+        entry.mtime = modificationTime(path);
+        entries.push_back(std::move(entry));
+    }
+
+    // Sorted: the same tree gives the same archive and fingerprint
+    std::sort(entries.begin(), entries.end(), [](const BuildContextEntry &a, const BuildContextEntry &b) {
+        return a.name < b.name;
+    });
+    return entries;
+}
+
+uint64_t BuildContext::fingerprint(size_t concurrency) {
+    scan();
+    const int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+
+    std::vector<size_t> changed;
+    std::vector<uint64_t> hashes(entries.size(), 0);
+    {
+        std::lock_guard lock(cacheMutex);
+        for (size_t i = 0; i < entries.size(); ++i) {
+            const auto &entry = entries[i];
+            if (entry.type != fs::file_type::regular) continue;
+            auto cached = cache.find(entry.name);
+            if (cached != cache.end() && cached->second.size == entry.size && cached->second.mtime == entry.mtime &&
+                now - entry.mtime > RACY_NANOSECONDS) {
+                hashes[i] = cached->second.hash;
+            } else {
+                changed.push_back(i);
+            }
+        }
+    }
+
+    parallelFor(changed.size(), concurrency, [&](size_t index) {
+        hashes[changed[index]] = hashFile(entries[changed[index]].path);
+    });
+
+    std::lock_guard lock(cacheMutex);
+    std::map<std::string, CachedFile> current;
+    uint64_t digest = 0;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        const auto &entry = entries[i];
+        digest = hashBytes(entry.name.data(), entry.name.size(), digest);
+        digest = hashValue((static_cast<uint64_t>(entry.type) << 32) | entry.mode, digest);
+        if (entry.type == fs::file_type::regular) {
+            digest = hashValue(entry.size, digest);
+            digest = hashValue(hashes[i], digest);
+            current.emplace(entry.name, CachedFile{entry.size, entry.mtime, hashes[i]});
+        } else if (entry.type == fs::file_type::symlink) {
+            std::error_code error;
+            const std::string target = fs::read_symlink(entry.path, error).generic_string();
+            digest = hashBytes(target.data(), target.size(), digest);
+        }
+    }
+    // Files gone from the context leave the cache
+    cache = std::move(current);
+    return digest;
+}
+
+std::unique_ptr<TarWriter> BuildContext::archive(size_t readAheadThreads) const {
+    auto writer = std::make_unique<TarWriter>();
+    for (const auto &entry : entries) {
+        writer->addEntry(entry.path, entry.name);
+    }
+    if (readAheadThreads > 0) writer->readAhead(readAheadThreads);
+    return writer;
+}
+
+bool BuildContext::loadCache(const fs::path &file) {
+    std::ifstream input(file, std::ios::binary);
+    char magic[sizeof(CACHE_MAGIC) - 1];
+    if (!input.read(magic, sizeof(magic)) || std::memcmp(magic, CACHE_MAGIC, sizeof(magic)) != 0) return false;
+
+    uint64_t count = 0;
+    if (!input.read(reinterpret_cast<char *>(&count), sizeof(count))) return false;
+    std::map<std::string, CachedFile> loaded;
+    for (uint64_t i = 0; i < count; ++i) {
+        uint32_t length = 0;
+        CachedFile cached{};
+        if (!input.read(reinterpret_cast<char *>(&length), sizeof(length)) || length > 64 * 1024) return false;
+        std::string name(length, '\0');
+        if (!input.read(name.data(), length) ||
+            !input.read(reinterpret_cast<char *>(&cached.size), sizeof(cached.size)) ||
+            !input.read(reinterpret_cast<char *>(&cached.mtime), sizeof(cached.mtime)) ||
+            !input.read(reinterpret_cast<char *>(&cached.hash), sizeof(cached.hash))) {
+            return false;
+        }
+        loaded.emplace(std::move(name), cached);
+    }
+
+    std::lock_guard lock(cacheMutex);
+    cache = std::move(loaded);
+    return true;
+}
+
+void BuildContext::saveCache(const fs::path &file) const {
+    // Written aside and renamed: a crash never leaves a truncated cache
+    const fs::path partial = file.string() + ".part";
+    {
+        std::ofstream output(partial, std::ios::binary | std::ios::trunc);
+        std::lock_guard lock(cacheMutex);
+        output.write(CACHE_MAGIC, sizeof(CACHE_MAGIC) - 1);
+        const uint64_t count = cache.size();
+        output.write(reinterpret_cast<const char *>(&count), sizeof(count));
+        for (const auto &[name, cached] : cache) {
+            const auto length = static_cast<uint32_t>(name.size());
+            output.write(reinterpret_cast<const char *>(&length), sizeof(length));
+            output.write(name.data(), length);
+            output.write(reinterpret_cast<const char *>(&cached.size), sizeof(cached.size));
+            output.write(reinterpret_cast<const char *>(&cached.mtime), sizeof(cached.mtime));
+            output.write(reinterpret_cast<const char *>(&cached.hash), sizeof(cached.hash));
+        }
+        if (!output) {
+            throw std::runtime_error("Failed to write " + partial.string());
+        }
+    }
+    fs::rename(partial, file);
+}
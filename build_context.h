@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2025 Nokaji. Tous droits réservés.
+ * Ce fichier fait partie du projet Kernel-James.
+ */
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "tar_stream.h"
+
+/*
+ * .dockerignore rules: paths relative to the context root, '*' and '?' within
+ * a path component, '**' across components, '[...]' classes, '!' re-includes.
+ * The last matching rule wins, and a rule matching a directory covers what it
+ * contains.
+ */
+class DockerIgnore
+{
+    private:
+        struct Rule {
+            std::string pattern;
+            bool exception;
+        };
+        std::vector<Rule> rules;
+        bool anyException = false;
+
+    public:
+        DockerIgnore() = default;
+        explicit DockerIgnore(const std::vector<std::string> &patterns);
+
+        // Missing file: nothing is ignored
+        static DockerIgnore load(const std::filesystem::path &file);
+
+        // path uses '/' separators, relative to the context root
+        [[nodiscard]] bool excluded(std::string_view path) const;
+
+        // Without '!' rules an excluded directory can be skipped whole
+        [[nodiscard]] bool hasExceptions() const { return anyException; }
+
+        static bool match(std::string_view pattern, std::string_view path);
+};
+
+struct BuildContextEntry {
+    std::string name;                   // relative, '/' separated
+    std::filesystem::path path;
+    std::filesystem::file_type type;
+    uint64_t size = 0;
+    int64_t mtime = 0;                  // nanoseconds
+    unsigned mode = 0;
+};
+
+/*
+ * Build context of a directory: the files Docker would send after applying
+ * .dockerignore (the Dockerfile and .dockerignore are always kept), as a
+ * streaming tar, and a fingerprint of their contents. Content hashes are
+ * cached per file by size and modification time, so fingerprinting an
+ * unchanged context only stats it; the cache can be kept across processes.
+ */
+class BuildContext
+{
+    private:
+        struct CachedFile {
+            uint64_t size;
+            int64_t mtime;
+            uint64_t hash;
+        };
+
+        std::filesystem::path directory;
+        std::string dockerfile;
+        std::vector<BuildContextEntry> entries;
+
+        mutable std::mutex cacheMutex;
+        std::map<std::string, CachedFile> cache;
+
+    public:
+        explicit BuildContext(std::filesystem::path directory, std::string dockerfile = "Dockerfile");
+
+        // Walks the directory again
+        const std::vector<BuildContextEntry> &scan();
+        [[nodiscard]] const std::vector<BuildContextEntry> &getEntries() const { return entries; }
+
+        // 64-bit digest of names, types, modes and contents (not cryptographic).
+        // Only files whose size or mtime changed since the last call are read, with concurrency threads.
+        uint64_t fingerprint(size_t concurrency = 0);
+
+        // Tar of the last scan; small files are read ahead by readAheadThreads threads
+        [[nodiscard]] std::unique_ptr<TarWriter> archive(size_t readAheadThreads = 0) const;
+
+        bool loadCache(const std::filesystem::path &file);
+        void saveCache(const std::filesystem::path &file) const;
+};
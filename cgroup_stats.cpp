@@ -0,0 +1,216 @@
+/*
+ * Copyright (c) 2025 Nokaji. Tous droits réservés.
+ * Ce fichier fait partie du projet Kernel-James.
+ */
+#include "cgroup_stats.h"
+#include "container.h"
+#include "container_stats.h"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    constexpr const char *FILE_NAMES[] = {"cpu.stat", "memory.current", "memory.stat", "io.stat", "pids.current", "memory.max"};
+
+    uint64_t parseNumber(std::string_view text) {
+        uint64_t value = 0;
+        size_t i = 0;
+        while (i < text.size() && text[i] == ' ') ++i;
+        for (; i < text.size() && text[i] >= '0' && text[i] <= '9'; ++i) value = value * 10 + (text[i] - '0');
+        return value;
+    }
+
+    // Value of "key N" in a flat keyed file such as cpu.stat or memory.stat
+    uint64_t keyedValue(std::string_view content, std::string_view key) {
+        size_t position = 0;
+        while (position < content.size()) {
+            size_t end = content.find('\n', position);
+            if (end == std::string_view::npos) end = content.size();
+            std::string_view line = content.substr(position, end - position);
+            if (line.size() > key.size() && line.compare(0, key.size(), key) == 0 && line[key.size()] == ' ') {
+                return parseNumber(line.substr(key.size() + 1));
+            }
+            position = end + 1;
+        }
+        return 0;
+    }
+
+    // Sum of every "name=N" field in io.stat ("8:0 rbytes=... wbytes=... rios=...")
+    uint64_t sumField(std::string_view content, std::string_view name) {
+        uint64_t total = 0;
+        for (size_t found = content.find(name); found != std::string_view::npos; found = content.find(name, found + name.size())) {
+            if (found == 0 || content[found - 1] == ' ') total += parseNumber(content.substr(found + name.size()));
+        }
+        return total;
+    }
+
+    // systemd encodes the slice hierarchy in its name: a-b.slice lives in a.slice/a-b.slice
+    std::string expandSlice(const std::string &slice) {
+        if (slice == "-.slice") return "";
+        const std::string name = slice.substr(0, slice.size() - 6);
+        std::string path;
+        for (size_t dash = name.find('-'); dash != std::string::npos; dash = name.find('-', dash + 1)) {
+            path += name.substr(0, dash) + ".slice/";
+        }
+        return path + slice;
+    }
+
+    int64_t nowNanoseconds() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+}
+
+CgroupStatsReader::Handle::Handle() {
+    fds.fill(-1);
+}
+
+CgroupStatsReader::Handle::~Handle() {
+#ifndef _WIN32
+    for (int fd : fds) {
+        if (fd >= 0) ::close(fd);
+    }
+#endif
+}
+
+CgroupStatsReader::CgroupStatsReader(std::string root) : root(std::move(root)) {
+    onlineCpus = std::max(1u, std::thread::hardware_concurrency());
+}
+
+bool CgroupStatsReader::available() const {
+#ifdef _WIN32
+    return false;
+#else
+    std::error_code error;
+    return std::filesystem::exists(std::filesystem::path(root) / "cgroup.controllers", error);
+#endif
+}
+
+std::string CgroupStatsReader::resolvePath(const std::string &containerId, const std::string &cgroupParent) const {
+    std::vector<std::filesystem::path> candidates;
+    const std::filesystem::path base(root);
+
+    if (cgroupParent.empty()) {
+        candidates.push_back(base / "system.slice" / ("docker-" + containerId + ".scope"));
+        candidates.push_back(base / "docker" / containerId);
+    } else if (cgroupParent.size() > 6 && cgroupParent.ends_with(".slice")) {
+        candidates.push_back(base / expandSlice(cgroupParent) / ("docker-" + containerId + ".scope"));
+    } else {
+        std::string parent = cgroupParent;
+        while (!parent.empty() && parent.front() == '/') parent.erase(0, 1);
+        candidates.push_back(base / parent / containerId);
+    }
+
+    std::error_code error;
+    for (const auto &candidate : candidates) {
+        if (std::filesystem::is_directory(candidate, error)) return candidate.string();
+    }
+    return "";
+}
+
+CgroupStatsReader::Handle *CgroupStatsReader::open(const std::string &containerId, const std::string &cgroupParent) {
+    auto it = handles.find(containerId);
+    if (it != handles.end()) return it->second.get();
+
+#ifdef _WIN32
+    return nullptr;
+#else
+    const std::string path = resolvePath(containerId, cgroupParent);
+    if (path.empty()) return nullptr;
+
+    auto handle = std::make_unique<Handle>();
+    handle->path = path;
+    for (int file = 0; file < FILE_COUNT; ++file) {
+        // Controllers that are not enabled simply have no file: their counters stay at 0
+        handle->fds[file] = ::open((path + "/" + FILE_NAMES[file]).c_str(), O_RDONLY | O_CLOEXEC);
+    }
+    if (handle->fds[CPU_STAT] < 0 || handle->fds[MEMORY_CURRENT] < 0) return nullptr;
+
+    return handles.emplace(containerId, std::move(handle)).first->second.get();
+#endif
+}
+
+bool CgroupStatsReader::read(const Handle &handle, statsTypes::ContainerStatsSample &sample) const {
+#ifdef _WIN32
+    return false;
+#else
+    char buffer[8192];
+    // cgroup files are regenerated on every read from offset 0: no seek, no reopen
+    auto load = [&](File file) -> std::optional<std::string_view> {
+        if (handle.fds[file] < 0) return std::string_view{};
+        ssize_t size = ::pread(handle.fds[file], buffer, sizeof(buffer), 0);
+        if (size < 0) return std::nullopt;
+        return std::string_view(buffer, static_cast<size_t>(size));
+    };
+
+    sample.read = nowNanoseconds();
+
+    auto content = load(CPU_STAT);
+    if (!content) return false; // the cgroup was removed under us
+    sample.cpuTotal = keyedValue(*content, "usage_usec") * 1000;
+
+    if (!(content = load(MEMORY_CURRENT))) return false;
+    sample.memoryUsage = parseNumber(*content);
+
+    if ((content = load(MEMORY_STAT))) sample.memoryInactiveFile = keyedValue(*content, "inactive_file");
+    if ((content = load(IO_STAT))) {
+        sample.blockReadBytes = sumField(*content, "rbytes=");
+        sample.blockWriteBytes = sumField(*content, "wbytes=");
+    }
+    if ((content = load(PIDS_CURRENT))) sample.pids = parseNumber(*content);
+    if ((content = load(MEMORY_MAX)) && !content->starts_with("max")) sample.memoryLimit = parseNumber(*content);
+    return true;
+#endif
+}
+
+std::optional<statsTypes::ContainerStatsSample> CgroupStatsReader::sample(const std::string &containerId, const std::string &cgroupParent) {
+    std::lock_guard lock(mutex);
+    Handle *handle = open(containerId, cgroupParent);
+    if (!handle) return std::nullopt;
+
+    statsTypes::ContainerStatsSample current;
+    if (!read(*handle, current)) {
+        handles.erase(containerId);
+        return std::nullopt;
+    }
+
+    // There is no host-wide counter here: wall time times the CPU count stands in for
+    // system_cpu_usage, so deriveMetrics() gives the same CPU % as docker stats
+    current.onlineCpus = onlineCpus;
+    current.systemCpu = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count()) * onlineCpus;
+    current.previousCpuTotal = handle->previous ? handle->previous->cpuTotal : current.cpuTotal;
+    current.previousSystemCpu = handle->previous ? handle->previous->systemCpu : current.systemCpu;
+    handle->previous = current;
+    return current;
+}
+
+std::optional<statsTypes::ContainerStatsSample> CgroupStatsReader::sample(const Container &container) {
+    return sample(container.getId(), container.getHostConfig().cgroupParent);
+}
+
+std::optional<statsTypes::ContainerMetrics> CgroupStatsReader::metrics(const std::string &containerId, const std::string &cgroupParent) {
+    std::optional<statsTypes::ContainerStatsSample> previous;
+    {
+        std::lock_guard lock(mutex);
+        auto it = handles.find(containerId);
+        if (it != handles.end()) previous = it->second->previous;
+    }
+
+    auto current = sample(containerId, cgroupParent);
+    if (!current) return std::nullopt;
+    return deriveMetrics(*current, previous ? &*previous : nullptr);
+}
+
+void CgroupStatsReader::forget(const std::string &containerId) {
+    std::lock_guard lock(mutex);
+    handles.erase(containerId);
+}
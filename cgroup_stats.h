@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2025 Nokaji. Tous droits réservés.
+ * Ce fichier fait partie du projet Kernel-James.
+ */
+#pragma once
+#include <array>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include "types/stats_types.h"
+
+class Container;
+
+/*
+ * Reads container resource usage straight from the cgroup v2 hierarchy, for
+ * clients running on the Docker host: a sample is five pread() calls on
+ * descriptors kept open between samples, instead of a /stats request that the
+ * daemon answers after a second. Samples use the same struct as /stats so
+ * deriveMetrics() applies; network counters live in the container's network
+ * namespace, not its cgroup, and are left at 0.
+ * root can point to a fake tree laid out like /sys/fs/cgroup.
+ */
+class CgroupStatsReader
+{
+    private:
+        enum File { CPU_STAT, MEMORY_CURRENT, MEMORY_STAT, IO_STAT, PIDS_CURRENT, MEMORY_MAX, FILE_COUNT };
+
+        struct Handle {
+            std::string path;
+            std::array<int, FILE_COUNT> fds;
+            std::optional<statsTypes::ContainerStatsSample> previous;
+
+            Handle();
+            ~Handle();
+            Handle(const Handle &) = delete;
+            Handle &operator=(const Handle &) = delete;
+        };
+
+        std::string root;
+        uint32_t onlineCpus;
+
+        std::mutex mutex;
+        std::unordered_map<std::string, std::unique_ptr<Handle>> handles;
+
+        Handle *open(const std::string &containerId, const std::string &cgroupParent);
+        bool read(const Handle &handle, statsTypes::ContainerStatsSample &sample) const;
+
+    public:
+        explicit CgroupStatsReader(std::string root = "/sys/fs/cgroup");
+
+        // True when root is a cgroup v2 (unified) mount
+        [[nodiscard]] bool available() const;
+
+        // Directory of the container cgroup for the systemd or cgroupfs driver, empty if not found
+        [[nodiscard]] std::string resolvePath(const std::string &containerId, const std::string &cgroupParent = "") const;
+
+        // Raw counters; nullopt when the container has no cgroup (stopped or removed)
+        std::optional<statsTypes::ContainerStatsSample> sample(const std::string &containerId, const std::string &cgroupParent = "");
+        std::optional<statsTypes::ContainerStatsSample> sample(const Container &container);
+
+        // Counters turned into metrics against the previous sample of the same container
+        std::optional<statsTypes::ContainerMetrics> metrics(const std::string &containerId, const std::string &cgroupParent = "");
+
+        // Closes the descriptors kept for a container
+        void forget(const std::string &containerId);
+};
@@ -0,0 +1,312 @@
+/*
+ * Copyright (c) 2025 Nokaji. Tous droits réservés.
+ * Ce fichier fait partie du projet Kernel-James.
+ */
+#include "compose_cache.h"
+#include <fmt/format.h>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <stdexcept>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+namespace {
+    constexpr char SNAPSHOT_MAGIC[] = "KJCC2\n";
+    // Files modified this recently may change again within the same mtime tick: always rehashed
+    constexpr int64_t RACY_NANOSECONDS = 2'000'000'000;
+    // Bounds what a corrupt snapshot can make read() allocate
+    constexpr uint32_t MAX_LENGTH = 16 * 1024 * 1024;
+
+    uint64_t fnv1a(const std::string &data) {
+        uint64_t hash = 0xcbf29ce484222325ULL;
+        for (const unsigned char c : data) {
+            hash ^= c;
+            hash *= 0x100000001b3ULL;
+        }
+        return hash;
+    }
+
+    int64_t toNanoseconds(fs::file_time_type time) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::file_clock::to_sys(time).time_since_epoch()).count();
+    }
+
+    int64_t nowNanoseconds() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    // Native-endian, length-prefixed fields: snapshots are not meant to move between machines
+
+    void writeSize(std::ostream &output, uint32_t value) {
+        output.write(reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+
+    void writeString(std::ostream &output, const std::string &value) {
+        writeSize(output, static_cast<uint32_t>(value.size()));
+        output.write(value.data(), static_cast<std::streamsize>(value.size()));
+    }
+
+    void writeBool(std::ostream &output, bool value) {
+        output.put(value ? 1 : 0);
+    }
+
+    void writeStrings(std::ostream &output, const std::vector<std::string> &values) {
+        writeSize(output, static_cast<uint32_t>(values.size()));
+        for (const auto &value : values) writeString(output, value);
+    }
+
+    void writeMap(std::ostream &output, const std::map<std::string, std::string> &values) {
+        writeSize(output, static_cast<uint32_t>(values.size()));
+        for (const auto &[key, value] : values) {
+            writeString(output, key);
+            writeString(output, value);
+        }
+    }
+
+    bool readSize(std::istream &input, uint32_t &value) {
+        return static_cast<bool>(input.read(reinterpret_cast<char *>(&value), sizeof(value))) && value <= MAX_LENGTH;
+    }
+
+    bool readString(std::istream &input, std::string &value) {
+        uint32_t length = 0;
+        if (!readSize(input, length)) return false;
+        value.resize(length);
+        return static_cast<bool>(input.read(value.data(), length));
+    }
+
+    bool readBool(std::istream &input, bool &value) {
+        const int c = input.get();
+        value = c == 1;
+        return c == 0 || c == 1;
+    }
+
+    bool readStrings(std::istream &input, std::vector<std::string> &values) {
+        uint32_t count = 0;
+        if (!readSize(input, count)) return false;
+        values.resize(count);
+        for (auto &value : values) {
+            if (!readString(input, value)) return false;
+        }
+        return true;
+    }
+
+    bool readMap(std::istream &input, std::map<std::string, std::string> &values) {
+        uint32_t count = 0;
+        if (!readSize(input, count)) return false;
+        for (uint32_t i = 0; i < count; ++i) {
+            std::string key;
+            std::string value;
+            if (!readString(input, key) || !readString(input, value)) return false;
+            values.emplace(std::move(key), std::move(value));
+        }
+        return true;
+    }
+
+}
+
+ComposeCache::ComposeCache(fs::path directory) : snapshotDirectory(std::move(directory)) {
+    if (!snapshotDirectory.empty()) {
+        fs::create_directories(snapshotDirectory);
+    }
+}
+
+ComposeCache &ComposeCache::global() {
+    static ComposeCache cache;
+    return cache;
+}
+
+std::shared_ptr<const ComposeConfig> ComposeCache::load(const std::string &filePath) {
+    const std::string path = fs::absolute(filePath).lexically_normal().string();
+
+    std::error_code error;
+    const uint64_t size = fs::file_size(path, error);
+    if (error) {
+        throw std::runtime_error("Cannot stat compose file " + path + ": " + error.message());
+    }
+    const auto writeTime = fs::last_write_time(path, error);
+    if (error) {
+        throw std::runtime_error("Cannot stat compose file " + path + ": " + error.message());
+    }
+    const int64_t mtime = toNanoseconds(writeTime);
+
+    {
+        std::lock_guard lock(mutex);
+        const auto cached = entries.find(path);
+        if (cached != entries.end() && cached->second.size == size && cached->second.mtime == mtime &&
+            nowNanoseconds() - mtime > RACY_NANOSECONDS) {
+            return cached->second.config;
+        }
+    }
+
+    std::ifstream input(path, std::ios::binary);
+    if (!input) {
+        throw std::runtime_error("Cannot read compose file " + path);
+    }
+    const std::string content((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+    const uint64_t contentHash = fnv1a(content);
+
+    std::shared_ptr<const ComposeConfig> config;
+    {
+        std::lock_guard lock(mutex);
+        auto cached = entries.find(path);
+        if (cached != entries.end() && cached->second.contentHash == contentHash) {
+            // Touched, not changed
+            cached->second.size = size;
+            cached->second.mtime = mtime;
+            return cached->second.config;
+        }
+    }
+
+    if (!snapshotDirectory.empty()) {
+        config = loadSnapshot(path, contentHash);
+    }
+    if (!config) {
+        config = std::make_shared<const ComposeConfig>(parseComposeString(content));
+        if (!snapshotDirectory.empty()) {
+            saveSnapshot(path, contentHash, *config);
+        }
+    }
+
+    std::lock_guard lock(mutex);
+    entries[path] = Entry{size, mtime, contentHash, config};
+    return config;
+}
+
+void ComposeCache::invalidate(const std::string &filePath) {
+    const std::string path = fs::absolute(filePath).lexically_normal().string();
+    std::lock_guard lock(mutex);
+    entries.erase(path);
+}
+
+void ComposeCache::clear() {
+    std::lock_guard lock(mutex);
+    entries.clear();
+}
+
+fs::path ComposeCache::snapshotPath(const std::string &path) const {
+    return snapshotDirectory / fmt::format("{:016x}.kjcc", fnv1a(path));
+}
+
+std::shared_ptr<const ComposeConfig> ComposeCache::loadSnapshot(const std::string &path, uint64_t contentHash) const {
+    std::ifstream input(snapshotPath(path), std::ios::binary);
+    char magic[sizeof(SNAPSHOT_MAGIC) - 1];
+    if (!input.read(magic, sizeof(magic)) || std::memcmp(magic, SNAPSHOT_MAGIC, sizeof(magic)) != 0) return nullptr;
+
+    uint64_t storedHash = 0;
+    if (!input.read(reinterpret_cast<char *>(&storedHash), sizeof(storedHash)) || storedHash != contentHash) return nullptr;
+
+    auto config = std::make_shared<ComposeConfig>();
+    if (!read(input, *config)) return nullptr;
+    return config;
+}
+
+void ComposeCache::saveSnapshot(const std::string &path, uint64_t contentHash, const ComposeConfig &config) const {
+    // Written aside and renamed: a crash never leaves a truncated snapshot. A failure
+    // only costs the next process a parse.
+    const fs::path file = snapshotPath(path);
+    const fs::path partial = fmt::format("{}.{:x}.part", file.string(),
+                                         std::hash<std::thread::id>{}(std::this_thread::get_id()));
+    {
+        std::ofstream output(partial, std::ios::binary | std::ios::trunc);
+        output.write(SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC) - 1);
+        output.write(reinterpret_cast<const char *>(&contentHash), sizeof(contentHash));
+        write(output, config);
+        if (!output) {
+            std::error_code ignored;
+            fs::remove(partial, ignored);
+            return;
+        }
+    }
+    std::error_code ignored;
+    fs::rename(partial, file, ignored);
+}
+
+void ComposeCache::write(std::ostream &output, const ComposeConfig &config) {
+    writeSize(output, static_cast<uint32_t>(config.services.size()));
+    for (const auto &[name, service] : config.services) {
+        writeString(output, name);
+        writeString(output, service.image);
+        writeString(output, service.container_name);
+        writeMap(output, service.environment);
+        writeStrings(output, service.ports);
+        writeString(output, service.restart);
+        writeStrings(output, service.volumes);
+        writeStrings(output, service.networks);
+        writeStrings(output, service.depends_on);
+        writeSize(output, static_cast<uint32_t>(service.replicas));
+    }
+
+    writeSize(output, static_cast<uint32_t>(config.networks.size()));
+    for (const auto &[key, network] : config.networks) {
+        writeString(output, key);
+        writeString(output, network.name);
+        writeString(output, network.driver);
+        writeBool(output, network.internal);
+        writeBool(output, network.attachable);
+        writeBool(output, network.enable_ipv4);
+        writeBool(output, network.enable_ipv6);
+        writeBool(output, network.external);
+        writeString(output, network.ipam.driver);
+        writeSize(output, static_cast<uint32_t>(network.ipam.config.size()));
+        for (const auto &ipam : network.ipam.config) {
+            writeString(output, ipam.subnet);
+            writeString(output, ipam.ip_range);
+            writeString(output, ipam.gateway);
+            writeMap(output, ipam.aux_addresses);
+        }
+        writeMap(output, network.ipam.options);
+        writeMap(output, network.labels);
+        writeMap(output, network.driver_opts);
+    }
+}
+
+bool ComposeCache::read(std::istream &input, ComposeConfig &config) {
+    ComposeConfig loaded;
+    uint32_t count = 0;
+    if (!readSize(input, count)) return false;
+    for (uint32_t i = 0; i < count; ++i) {
+        std::string name;
+        Service service;
+        if (!readString(input, name) || !readString(input, service.image) || !readString(input, service.container_name) ||
+            !readMap(input, service.environment) || !readStrings(input, service.ports) || !readString(input, service.restart) ||
+            !readStrings(input, service.volumes) || !readStrings(input, service.networks) || !readStrings(input, service.depends_on)) {
+            return false;
+        }
+        uint32_t replicas = 0;
+        if (!readSize(input, replicas)) return false;
+        service.replicas = replicas;
+        loaded.services.emplace(std::move(name), std::move(service));
+    }
+
+    if (!readSize(input, count)) return false;
+    for (uint32_t i = 0; i < count; ++i) {
+        std::string key;
+        networkTypes::NetworkCompose network;
+        uint32_t ipamCount = 0;
+        if (!readString(input, key) || !readString(input, network.name) || !readString(input, network.driver) ||
+            !readBool(input, network.internal) || !readBool(input, network.attachable) || !readBool(input, network.enable_ipv4) ||
+            !readBool(input, network.enable_ipv6) || !readBool(input, network.external) ||
+            !readString(input, network.ipam.driver) || !readSize(input, ipamCount)) {
+            return false;
+        }
+        network.ipam.config.resize(ipamCount);
+        for (auto &ipam : network.ipam.config) {
+            if (!readString(input, ipam.subnet) || !readString(input, ipam.ip_range) || !readString(input, ipam.gateway) ||
+                !readMap(input, ipam.aux_addresses)) {
+                return false;
+            }
+        }
+        if (!readMap(input, network.ipam.options) || !readMap(input, network.labels) || !readMap(input, network.driver_opts)) {
+            return false;
+        }
+        loaded.networks.emplace(std::move(key), std::move(network));
+    }
+
+    config = std::move(loaded);
+    return true;
+}
@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2025 Nokaji. Tous droits réservés.
+ * Ce fichier fait partie du projet Kernel-James.
+ */
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <iosfwd>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include "docker_compose_parser.h"
+
+/*
+ * Parsed compose files by path. A load whose file has the size and mtime
+ * seen last time is answered from memory after a single stat; otherwise the
+ * file is read and hashed, and only parsed if its content changed (a touched
+ * but identical file is not). With a snapshot directory, each parse is also
+ * stored there in a binary form keyed by content hash, so another process
+ * loading the same file skips the YAML parse.
+ */
+class ComposeCache
+{
+    private:
+        struct Entry {
+            uint64_t size = 0;
+            int64_t mtime = 0;          // nanoseconds
+            uint64_t contentHash = 0;
+            std::shared_ptr<const ComposeConfig> config;
+        };
+
+        std::filesystem::path snapshotDirectory;
+
+        std::mutex mutex;
+        std::map<std::string, Entry> entries;   // by absolute path
+
+        [[nodiscard]] std::filesystem::path snapshotPath(const std::string &path) const;
+        std::shared_ptr<const ComposeConfig> loadSnapshot(const std::string &path, uint64_t contentHash) const;
+        void saveSnapshot(const std::string &path, uint64_t contentHash, const ComposeConfig &config) const;
+
+    public:
+        // Empty directory: memory only
+        explicit ComposeCache(std::filesystem::path snapshotDirectory = {});
+
+        ComposeCache(const ComposeCache &) = delete;
+        ComposeCache &operator=(const ComposeCache &) = delete;
+
+        // Shared by the library's own compose entry points
+        static ComposeCache &global();
+
+        // Whole file; throws when it cannot be read or parsed
+        std::shared_ptr<const ComposeConfig> load(const std::string &filePath);
+
+        void invalidate(const std::string &filePath);
+        void clear();
+
+        // Binary form used by the snapshots; read returns false on a truncated or foreign stream
+        static void write(std::ostream &output, const ComposeConfig &config);
+        static bool read(std::istream &input, ComposeConfig &config);
+};
@@ -0,0 +1,516 @@
+/*
+ * Copyright (c) 2025 Nokaji. Tous droits réservés.
+ * Ce fichier fait partie du projet Kernel-James.
+ */
+#include "compose_deployer.h"
+#include "compose_cache.h"
+#include "container.h"
+#include "container_manager.h"
+#include "docker.h"
+#include "network_manager.h"
+#include "parallel.h"
+#include "pull_scheduler.h"
+#include "service_rollout.h"
+#include <fmt/format.h>
+#include <fmt/ranges.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <future>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+
+namespace {
+
+    uint64_t fnv1a(const std::string &data) {
+        uint64_t hash = 0xcbf29ce484222325ULL;
+        for (const unsigned char c : data) {
+            hash ^= c;
+            hash *= 0x100000001b3ULL;
+        }
+        return hash;
+    }
+
+    // "80", "8000-8010"
+    std::pair<int, int> parsePortRange(const std::string &text, const std::string &spec) {
+        try {
+            const size_t dash = text.find('-');
+            if (dash == std::string::npos) {
+                const int port = std::stoi(text);
+                return {port, port};
+            }
+            const int first = std::stoi(text.substr(0, dash));
+            const int last = std::stoi(text.substr(dash + 1));
+            if (last < first) throw std::invalid_argument("range");
+            return {first, last};
+        } catch (const std::logic_error &) {
+            throw std::runtime_error("Invalid port specification: " + spec);
+        }
+    }
+
+    // Short compose syntax: [[ip:]hostPort:]containerPort[/protocol], ports may be ranges
+    void addPorts(const std::string &spec, nlohmann::json &exposedPorts, nlohmann::json &portBindings) {
+        std::string mapping = spec;
+        std::string protocol = "tcp";
+        const size_t slash = mapping.find('/');
+        if (slash != std::string::npos) {
+            protocol = mapping.substr(slash + 1);
+            mapping.resize(slash);
+        }
+
+        std::string hostIp;
+        std::string hostPart;
+        std::string containerPart = mapping;
+        const size_t colon = mapping.rfind(':');
+        if (colon != std::string::npos) {
+            containerPart = mapping.substr(colon + 1);
+            hostPart = mapping.substr(0, colon);
+            const size_t ipColon = hostPart.rfind(':');
+            if (ipColon != std::string::npos) {
+                hostIp = hostPart.substr(0, ipColon);
+                hostPart = hostPart.substr(ipColon + 1);
+            }
+        }
+
+        const auto [first, last] = parsePortRange(containerPart, spec);
+        std::pair<int, int> hostRange{0, -1};
+        if (!hostPart.empty()) {
+            hostRange = parsePortRange(hostPart, spec);
+            if (hostRange.second - hostRange.first != last - first) {
+                throw std::runtime_error("Port ranges do not match: " + spec);
+            }
+        }
+
+        for (int port = first; port <= last; ++port) {
+            const std::string key = fmt::format("{}/{}", port, protocol);
+            exposedPorts[key] = nlohmann::json::object();
+            if (colon == std::string::npos) continue;
+
+            std::string hostPort;
+            if (!hostPart.empty()) hostPort = std::to_string(hostRange.first + (port - first));
+            portBindings[key].push_back({{"HostIp", hostIp}, {"HostPort", hostPort}});
+        }
+    }
+
+    // "no", "always", "unless-stopped", "on-failure[:retries]"
+    nlohmann::json restartPolicy(const std::string &restart) {
+        if (restart.empty()) return {{"Name", "no"}};
+        const size_t colon = restart.find(':');
+        if (colon == std::string::npos) return {{"Name", restart}};
+        return {{"Name", restart.substr(0, colon)}, {"MaximumRetryCount", std::stoi(restart.substr(colon + 1))}};
+    }
+
+    // "source:target[:mode]"; a source that is a path (not a volume name) must be absolute for the daemon
+    std::string bindSpec(const std::string &volume, const std::string &baseDir) {
+        const size_t colon = volume.find(':');
+        std::string source = volume.substr(0, colon);
+        if (source.starts_with(".") || source.starts_with("~")) {
+            std::filesystem::path path;
+            if (source.starts_with("~")) {
+                const char *home = std::getenv("HOME");
+                path = std::filesystem::path(home ? home : "") / source.substr(std::min<size_t>(2, source.size()));
+            } else {
+                path = std::filesystem::absolute(baseDir.empty() ? std::filesystem::path(source) : std::filesystem::path(baseDir) / source);
+            }
+            source = path.lexically_normal().string();
+        }
+        return source + volume.substr(colon);
+    }
+
+}
+
+ComposeDeployer::ComposeDeployer(std::shared_ptr<DockerClient> client) : dockerClient(std::move(client)) {
+    if (!dockerClient) {
+        throw std::runtime_error("Docker client is not initialized.");
+    }
+}
+
+std::vector<std::vector<std::string>> ComposeDeployer::levels(const std::map<std::string, Service> &services) {
+    // Kahn's algorithm: a service is placed once all its dependencies are
+    std::map<std::string, size_t> pending;
+    std::map<std::string, std::vector<std::string>> dependents;
+    for (const auto &[name, service] : services) {
+        std::set<std::string> dependencies(service.depends_on.begin(), service.depends_on.end());
+        for (const auto &dependency : dependencies) {
+            if (!services.contains(dependency)) {
+                throw std::runtime_error(fmt::format("Service {} depends on undefined service {}", name, dependency));
+            }
+            dependents[dependency].push_back(name);
+        }
+        pending[name] = dependencies.size();
+    }
+
+    std::vector<std::vector<std::string>> result;
+    std::vector<std::string> current;
+    for (const auto &[name, count] : pending) {
+        if (count == 0) current.push_back(name);
+    }
+    size_t placed = 0;
+    while (!current.empty()) {
+        std::vector<std::string> next;
+        for (const auto &name : current) {
+            for (const auto &dependent : dependents[name]) {
+                if (--pending[dependent] == 0) next.push_back(dependent);
+            }
+        }
+        std::sort(next.begin(), next.end());
+        placed += current.size();
+        result.push_back(std::move(current));
+        current = std::move(next);
+    }
+
+    if (placed != services.size()) {
+        std::vector<std::string> cycle;
+        for (const auto &[name, count] : pending) {
+            if (count > 0) cycle.push_back(name);
+        }
+        throw std::runtime_error(fmt::format("Circular depends_on between services: {}", fmt::join(cycle, ", ")));
+    }
+    return result;
+}
+
+std::string ComposeDeployer::fingerprint(const Service &service) {
+    std::vector<std::string> ports = service.ports;
+    std::vector<std::string> volumes = service.volumes;
+    std::sort(ports.begin(), ports.end());
+    std::sort(volumes.begin(), volumes.end());
+
+    // Object keys are sorted by nlohmann::json: the same service always dumps the same way
+    const nlohmann::json canonical = {
+        {"image", service.image},
+        {"environment", service.environment},
+        {"ports", ports},
+        {"volumes", volumes},
+        {"networks", service.networks},
+        {"restart", service.restart}
+    };
+    return fmt::format("{:016x}", fnv1a(canonical.dump()));
+}
+
+std::string ComposeDeployer::containerName(const std::string &project, const std::string &serviceName, const Service &service,
+                                          size_t number) {
+    if (!service.container_name.empty()) {
+        if (number != 1) {
+            throw std::runtime_error("Service " + serviceName + " sets container_name and cannot have several replicas");
+        }
+        return service.container_name;
+    }
+    if (project.empty()) return number == 1 ? serviceName : fmt::format("{}-{}", serviceName, number);
+    return fmt::format("{}-{}-{}", project, serviceName, number);
+}
+
+nlohmann::json ComposeDeployer::containerConfig(const std::string &project, const std::string &serviceName, const Service &service,
+                                                const std::string &baseDir, size_t number) {
+    nlohmann::json config;
+    config["Image"] = service.image;
+
+    nlohmann::json env = nlohmann::json::array();
+    for (const auto &[key, value] : service.environment) {
+        env.push_back(key + "=" + value);
+    }
+    config["Env"] = env;
+
+    nlohmann::json labels = {
+        {"com.docker.compose.service", serviceName},
+        {"com.docker.compose.container-number", std::to_string(number)}
+    };
+    if (!project.empty()) labels["com.docker.compose.project"] = project;
+    labels[CONFIG_HASH_LABEL] = fingerprint(service);
+    config["Labels"] = labels;
+
+    nlohmann::json hostConfig;
+    nlohmann::json exposedPorts = nlohmann::json::object();
+    nlohmann::json portBindings = nlohmann::json::object();
+    for (const auto &port : service.ports) {
+        addPorts(port, exposedPorts, portBindings);
+    }
+    if (!exposedPorts.empty()) config["ExposedPorts"] = exposedPorts;
+    if (!portBindings.empty()) hostConfig["PortBindings"] = portBindings;
+
+    nlohmann::json binds = nlohmann::json::array();
+    nlohmann::json volumes = nlohmann::json::object();
+    for (const auto &volume : service.volumes) {
+        if (volume.find(':') == std::string::npos) {
+            volumes[volume] = nlohmann::json::object();     // anonymous volume
+        } else {
+            binds.push_back(bindSpec(volume, baseDir));
+        }
+    }
+    if (!binds.empty()) hostConfig["Binds"] = binds;
+    if (!volumes.empty()) config["Volumes"] = volumes;
+
+    hostConfig["RestartPolicy"] = restartPolicy(service.restart);
+
+    // Every network in one create call (API >= 1.44), reachable by service name on each
+    if (!service.networks.empty()) {
+        hostConfig["NetworkMode"] = service.networks.front();
+        nlohmann::json endpoints = nlohmann::json::object();
+        for (const auto &network : service.networks) {
+            endpoints[network] = {{"Aliases", {serviceName}}};
+        }
+        config["NetworkingConfig"] = {{"EndpointsConfig", endpoints}};
+    }
+
+    config["HostConfig"] = hostConfig;
+    return config;
+}
+
+ComposeDeploySummary ComposeDeployer::deploy(const std::string &composeFilePath, const ComposeDeployOptions &options,
+                                             const ProgressCallback &progress) {
+    ComposeDeployOptions fileOptions = options;
+    if (fileOptions.baseDir.empty()) {
+        fileOptions.baseDir = std::filesystem::absolute(composeFilePath).parent_path().string();
+    }
+    const auto compose = ComposeCache::global().load(composeFilePath);
+    return deploy(*compose, fileOptions, progress);
+}
+
+ComposeDeploySummary ComposeDeployer::deploy(const ComposeConfig &compose, const ComposeDeployOptions &options,
+                                             const ProgressCallback &progress) {
+    return execute(compose, levels(compose.services), {}, options, progress);
+}
+
+ComposeDeploySummary ComposeDeployer::reconcile(const std::string &composeFilePath, const ComposeDeployOptions &options,
+                                                const ProgressCallback &progress) {
+    ComposeDeployOptions fileOptions = options;
+    if (fileOptions.baseDir.empty()) {
+        fileOptions.baseDir = std::filesystem::absolute(composeFilePath).parent_path().string();
+    }
+    const auto compose = ComposeCache::global().load(composeFilePath);
+    return reconcile(*compose, fileOptions, progress);
+}
+
+ComposeDeploySummary ComposeDeployer::reconcile(const ComposeConfig &compose, const ComposeDeployOptions &options,
+                                                const ProgressCallback &progress) {
+    if (options.projectName.empty()) {
+        throw std::runtime_error("Reconciling a compose stack requires a project name");
+    }
+    const auto started = std::chrono::steady_clock::now();
+    const auto serviceLevels = levels(compose.services);
+
+    // The only request when nothing changed
+    ContainerManager containerManager(dockerClient);
+    const nlohmann::json filters = {{"label", {"com.docker.compose.project=" + options.projectName}}};
+    const auto containers = containerManager.list(true, 0, false, filters.dump());
+
+    std::map<std::string, std::vector<const ContainerList *>> byService;
+    for (const auto &container : containers) {
+        const auto owner = container.labels.find("com.docker.compose.service");
+        if (owner != container.labels.end()) byService[owner->second].push_back(&container);
+    }
+
+    // Replicas are claimed by service and fingerprint whatever their number: rolling updates
+    // and scaling leave gaps (a 3-replica update ends with {2, 3, 4}), which are not orphans
+    std::map<std::string, std::vector<ServicePlan>> plans;
+    std::set<std::string> claimed;
+    for (const auto &[name, service] : compose.services) {
+        auto candidates = byService[name];
+        std::sort(candidates.begin(), candidates.end(), [](const ContainerList *a, const ContainerList *b) {
+            return ServiceRollout::replicaNumber(*a) < ServiceRollout::replicaNumber(*b);
+        });
+
+        using containerTypes::ContainerStatus;
+        std::vector<const ContainerList *> outdated;
+        std::vector<ServicePlan> &servicePlans = plans[name];
+        std::set<size_t> numbers;
+        for (const ContainerList *container : candidates) {
+            const size_t number = ServiceRollout::replicaNumber(*container);
+            const auto hash = container->labels.find(CONFIG_HASH_LABEL);
+            const bool current = number > 0 && !numbers.contains(number) &&
+                                 hash != container->labels.end() && hash->second == fingerprint(service) &&
+                                 container->name == containerName(options.projectName, name, service, number) &&
+                                 container->state != ContainerStatus::DEAD;
+            if (!current || servicePlans.size() == service.replicas) {
+                outdated.push_back(container);
+                continue;
+            }
+            ServicePlan plan;
+            plan.number = number;
+            plan.containerId = container->id;
+            plan.action = options.startContainers && (container->state == ContainerStatus::CREATED || container->state == ContainerStatus::EXITED)
+                          ? ServicePlan::Action::Start : ServicePlan::Action::Keep;
+            numbers.insert(number);
+            claimed.insert(container->name);
+            servicePlans.push_back(std::move(plan));
+        }
+
+        // Outdated containers are replaced under their own number, the remaining replicas take the lowest free ones
+        for (const ContainerList *container : outdated) {
+            const size_t number = ServiceRollout::replicaNumber(*container);
+            if (servicePlans.size() == service.replicas) break;
+            if (number == 0 || numbers.contains(number) ||
+                (number > 1 && !service.container_name.empty())) continue;
+            ServicePlan plan;
+            plan.action = ServicePlan::Action::Recreate;
+            plan.number = number;
+            plan.containerId = container->id;
+            numbers.insert(number);
+            claimed.insert(container->name);
+            servicePlans.push_back(std::move(plan));
+        }
+        for (size_t number = 1; servicePlans.size() < service.replicas; ++number) {
+            if (numbers.contains(number)) continue;
+            ServicePlan plan;
+            plan.number = number;
+            numbers.insert(number);
+            servicePlans.push_back(std::move(plan));
+        }
+        std::sort(servicePlans.begin(), servicePlans.end(), [](const ServicePlan &a, const ServicePlan &b) {
+            return a.number < b.number;
+        });
+    }
+
+    // Orphans go first: they may hold the names or host ports the new containers need
+    std::vector<const ContainerList *> orphans;
+    for (const auto &container : containers) {
+        if (!claimed.contains(container.name)) orphans.push_back(&container);
+    }
+    std::vector<std::string> orphanErrors(orphans.size());
+    parallelFor(orphans.size(), std::max<size_t>(1, options.concurrency), [&](size_t index) {
+        try {
+            containerManager.remove(orphans[index]->id, true);
+        } catch (const std::exception &e) {
+            orphanErrors[index] = e.what();
+        }
+    });
+
+    ComposeDeploySummary summary = execute(compose, serviceLevels, plans, options, progress);
+    for (size_t i = 0; i < orphans.size(); ++i) {
+        if (orphanErrors[i].empty()) summary.removedOrphans.push_back(orphans[i]->name);
+        else summary.orphanErrors.emplace(orphans[i]->name, orphanErrors[i]);
+    }
+    summary.duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started);
+    return summary;
+}
+
+ComposeDeploySummary ComposeDeployer::execute(const ComposeConfig &compose, const std::vector<std::vector<std::string>> &serviceLevels,
+                                              const std::map<std::string, std::vector<ServicePlan>> &plans,
+                                              const ComposeDeployOptions &options,
+                                              const ProgressCallback &progress) {
+    using Action = ServicePlan::Action;
+    const auto started = std::chrono::steady_clock::now();
+    ComposeDeploySummary summary;
+    summary.levels = serviceLevels.size();
+
+    // One item per replica; services without plans get replicas 1..replicas, all created
+    struct Replica {
+        std::string service;
+        std::string name;
+        ServicePlan plan;
+    };
+    std::vector<std::vector<Replica>> levelReplicas(serviceLevels.size());
+    std::set<std::string> creating;         // services with at least one new container
+    for (size_t level = 0; level < serviceLevels.size(); ++level) {
+        for (const auto &name : serviceLevels[level]) {
+            const Service &service = compose.services.at(name);
+            std::vector<ServicePlan> servicePlans;
+            const auto planned = plans.find(name);
+            if (planned != plans.end()) {
+                servicePlans = planned->second;
+            } else {
+                servicePlans.resize(service.replicas);
+                for (size_t number = 1; number <= service.replicas; ++number) servicePlans[number - 1].number = number;
+            }
+            for (auto &plan : servicePlans) {
+                if (plan.action == Action::Create || plan.action == Action::Recreate) creating.insert(name);
+                std::string replicaName = containerName(options.projectName, name, service, plan.number);
+                levelReplicas[level].push_back({name, std::move(replicaName), std::move(plan)});
+            }
+        }
+    }
+
+    if (options.createNetworks && !creating.empty() && !compose.networks.empty()) {
+        NetworkManager networkManager(dockerClient);
+        summary.networksCreated = networkManager.createFromCompose(compose.networks);
+    }
+
+    // Every pull is queued now, lower levels first: later levels pull while earlier ones start
+    std::unique_ptr<PullScheduler> scheduler;
+    std::map<std::string, std::shared_future<void>> imageReady;
+    if (options.pullImages && !creating.empty()) {
+        scheduler = std::make_unique<PullScheduler>(dockerClient, PullSchedulerOptions{
+            std::max<size_t>(1, options.pullConcurrency), std::max<size_t>(1, options.perRegistryLimit), true});
+        for (size_t level = 0; level < serviceLevels.size(); ++level) {
+            for (const auto &name : serviceLevels[level]) {
+                const Service &service = compose.services.at(name);
+                if (service.image.empty() || !creating.contains(name)) continue;
+                imageReady.emplace(name, scheduler->submit({service.image, static_cast<int>(level), "", ""}));
+            }
+        }
+    }
+
+    ContainerManager containerManager(dockerClient);
+    std::set<std::string> failed;           // failed or skipped, their dependents are skipped
+    std::mutex progressMutex;
+
+    for (size_t level = 0; level < serviceLevels.size(); ++level) {
+        const auto &replicas = levelReplicas[level];
+        std::vector<ServiceDeployResult> results(replicas.size());
+
+        parallelFor(replicas.size(), std::max<size_t>(1, options.concurrency), [&](size_t index) {
+            ServiceDeployResult &result = results[index];
+            const Replica &replica = replicas[index];
+            const Service &service = compose.services.at(replica.service);
+            const ServicePlan &plan = replica.plan;
+            const auto serviceStarted = std::chrono::steady_clock::now();
+            result.service = replica.service;
+            result.replica = plan.number;
+            result.level = level;
+            result.containerName = replica.name;
+            result.containerId = plan.containerId;
+
+            const auto dependency = std::find_if(service.depends_on.begin(), service.depends_on.end(),
+                                                 [&failed](const std::string &name) { return failed.contains(name); });
+            if (plan.action == Action::Keep) {
+                result.unchanged = true;
+            } else if (dependency != service.depends_on.end()) {
+                result.skipped = true;
+                result.error = "Dependency " + *dependency + " failed";
+            } else {
+                try {
+                    if (plan.action == Action::Create || plan.action == Action::Recreate) {
+                        if (service.image.empty()) {
+                            throw std::runtime_error("Service " + result.service + " has no image");
+                        }
+                        const auto image = imageReady.find(result.service);
+                        if (image != imageReady.end()) image->second.get();
+
+                        if (plan.action == Action::Recreate) {
+                            result.recreated = true;
+                            containerManager.remove(plan.containerId, true);
+                            result.containerId.clear();
+                        }
+                        result.containerId = containerManager.createContainer(result.containerName,
+                                containerConfig(options.projectName, result.service, service, options.baseDir, plan.number));
+                    }
+                    if (options.startContainers) {
+                        Container container(dockerClient, nlohmann::json{{"Id", result.containerId}, {"Name", result.containerName}});
+                        container.run();
+                    }
+                } catch (const std::exception &e) {
+                    result.error = e.what();
+                }
+            }
+            result.duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - serviceStarted);
+
+            if (progress) {
+                std::lock_guard lock(progressMutex);
+                progress(result);
+            }
+        });
+
+        for (auto &result : results) {
+            if (result.skipped) ++summary.skipped;
+            else if (result.unchanged) ++summary.unchanged;
+            else if (result.succeeded()) ++summary.succeeded;
+            else ++summary.failed;
+            if (!result.succeeded()) failed.insert(result.service);
+            summary.results.push_back(std::move(result));
+        }
+    }
+
+    summary.duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started);
+    return summary;
+}
@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2025 Nokaji. Tous droits réservés.
+ * Ce fichier fait partie du projet Kernel-James.
+ */
+#pragma once
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "docker_compose_parser.h"
+
+class DockerClient;
+
+struct ComposeDeployOptions {
+    std::string projectName;            // labels the containers; when set, names default to "<project>-<service>-1"
+    size_t concurrency = 16;            // services created and started at once
+    size_t pullConcurrency = 8;         // image pulls in flight
+    size_t perRegistryLimit = 3;        // image pulls in flight against one registry
+    bool pullImages = true;             // images already present are not pulled again
+    bool createNetworks = true;
+    bool startContainers = true;
+    std::string baseDir;                // relative bind sources; the compose file directory when deploying a file
+};
+
+struct ServiceDeployResult {
+    std::string service;
+    std::string containerName;
+    std::string containerId;
+    size_t replica = 1;                 // com.docker.compose.container-number
+    size_t level = 0;                   // longest depends_on chain below the service
+    bool skipped = false;               // a dependency failed, nothing was attempted
+    bool unchanged = false;             // reconcile: the running container already matches, no request was sent
+    bool recreated = false;             // reconcile: an outdated container was replaced
+    std::string error;
+    std::chrono::milliseconds duration{0};  // image wait, create and start
+
+    [[nodiscard]] bool succeeded() const { return error.empty(); }
+};
+
+struct ComposeDeploySummary {
+    std::vector<ServiceDeployResult> results;   // one per container: by level, service name, then replica
+    size_t succeeded = 0;
+    size_t failed = 0;
+    size_t skipped = 0;
+    size_t unchanged = 0;
+    size_t levels = 0;
+    std::vector<std::string> removedOrphans;            // reconcile: containers of the project no service claims
+    std::map<std::string, std::string> orphanErrors;    // container name -> error
+    bool networksCreated = true;
+    std::chrono::milliseconds duration{0};
+};
+
+/*
+ * Brings up the services of a compose file in depends_on order. Services are
+ * grouped by level (0 = no dependencies, n = depends on a service of level
+ * n - 1 at most) and each level is created and started in parallel, a level
+ * starting once the previous one is done. Each replica of a service is a
+ * container of its own, created and started alongside the other containers
+ * of the level (a service with container_name has one replica at most). All
+ * images are pulled upfront, lower levels first, so pulls overlap with the
+ * creation of earlier levels. A failed replica does not stop the deployment:
+ * only the services that depend on its service, directly or not, are skipped.
+ */
+class ComposeDeployer
+{
+    public:
+        // Called once per container as soon as it is up, failed or skipped, one call at a time
+        using ProgressCallback = std::function<void(const ServiceDeployResult &result)>;
+
+    private:
+        // What a deployment does with one replica of a service
+        struct ServicePlan {
+            enum class Action { Create, Recreate, Start, Keep };
+            Action action = Action::Create;
+            size_t number = 1;          // replica number, not necessarily contiguous
+            std::string containerId;    // existing container, except for Create
+        };
+
+        std::shared_ptr<DockerClient> dockerClient;
+
+        ComposeDeploySummary execute(const ComposeConfig &compose, const std::vector<std::vector<std::string>> &serviceLevels,
+                                     const std::map<std::string, std::vector<ServicePlan>> &plans,
+                                     const ComposeDeployOptions &options,
+                                     const ProgressCallback &progress);
+
+    public:
+        explicit ComposeDeployer(std::shared_ptr<DockerClient> client);
+
+        // Services per level; throws on a dependency that is not a service or on a cycle
+        static std::vector<std::vector<std::string>> levels(const std::map<std::string, Service> &services);
+
+        // Name given to replica number of a service
+        static std::string containerName(const std::string &project, const std::string &serviceName, const Service &service,
+                                         size_t number = 1);
+
+        // Label holding fingerprint() on the containers created here
+        static constexpr const char *CONFIG_HASH_LABEL = "com.docker.compose.config-hash";
+
+        // Stable hash (hex) of what the container is created from: image, environment, ports, volumes, networks
+        // and restart policy. The order of ports and volumes does not matter, that of networks does.
+        static std::string fingerprint(const Service &service);
+
+        // /containers/create body for a service: env, published ports, binds, restart policy, networks and labels
+        // (fingerprint and replica number included). Relative bind sources are resolved against baseDir (the current
+        // directory when empty).
+        static nlohmann::json containerConfig(const std::string &project, const std::string &serviceName, const Service &service,
+                                              const std::string &baseDir = "", size_t number = 1);
+
+        ComposeDeploySummary deploy(const ComposeConfig &compose, const ComposeDeployOptions &options = {},
+                                    const ProgressCallback &progress = nullptr);
+
+        ComposeDeploySummary deploy(const std::string &composeFilePath, const ComposeDeployOptions &options = {},
+                                    const ProgressCallback &progress = nullptr);
+
+        /*
+         * Redeploys only what changed, from one list of the project's containers
+         * (options.projectName is required). Each service claims up to replicas
+         * of its containers, by service label, whatever their numbers (rolling
+         * updates leave gaps): those with the expected name and fingerprint are
+         * kept (started if they are not running), outdated ones are replaced under
+         * their number and missing ones created under the lowest free numbers.
+         * Project containers no service claims are removed first. Networks are
+         * provisioned and images pulled only for the services that get a new
+         * container, so an unchanged stack costs the list request alone.
+         */
+        ComposeDeploySummary reconcile(const ComposeConfig &compose, const ComposeDeployOptions &options,
+                                       const ProgressCallback &progress = nullptr);
+
+        ComposeDeploySummary reconcile(const std::string &composeFilePath, const ComposeDeployOptions &options,
+                                       const ProgressCallback &progress = nullptr);
+};
@@ -2,22 +2,14 @@
  * Copyright (c) 2025 Nokaji. Tous droits réservés.
  * Ce fichier fait partie du projet Kernel-James.
  */
-#ifdef _WIN32
-
-#include <winsock2.h>
-#include <ws2tcpip.h>
-
-#else
-#include <arpa/inet.h>
-#include <netinet/in.h>
-#endif
-
 #include "utils/property.h"
 #include <iostream>
 #include "container.h"
 #include <curl/curl.h>
 #include <nlohmann/json.hpp>
 #include "docker.h"
+#include "container_stats.h"
+#include "tar_stream.h"
 #include <utils/curl.h>
 #include <thread>
 #include <fmt/format.h>
@@ -731,22 +723,6 @@ std::string Container::to_string() {
 										 id, name, image, stateToString(state.status), created, driver, restartCount);
 }
 
-inline uint32_t networkToHost32(uint32_t netlong) {
-#ifdef _WIN32
-	// On Windows, we can use the built-in byte swapping
-	return _byteswap_ulong(netlong);
-#elif defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
-	// Little endian system - need to swap bytes
-		return ((netlong & 0xFF000000) >> 24) |
-					 ((netlong & 0x00FF0000) >> 8)  |
-					 ((netlong & 0x0000FF00) << 8)  |
-					 ((netlong & 0x000000FF) << 24);
-#else
-		// Big endian system or unknown - no conversion needed
-		return netlong;
-#endif
-}
-
 std::vector<std::string>
 Container::logs(bool follow, bool capture_stdout, bool capture_stderr, long since, long until, bool timestamps,
 								const std::string &tail) {
@@ -755,15 +731,19 @@ Container::logs(bool follow, bool capture_stdout, bool capture_stderr, long sinc
 	std::vector<std::string> logs;
 
 	ReqUEST request = ReqUEST(dockerClient->getDockerApiUrl() + fmt::format("/containers/{}/logs", id),
-														{
-														// 	CurlParam("follow", follow ? "true" : "false"),
-														//  CurlParam("stdout", capture_stdout ? "true" : "false"),
-														//  CurlParam("stderr", capture_stderr ? "true" : "false"),
-														//  CurlParam("timestamps", timestamps ? "true" : "false"),
-														//  CurlParam("since", std::to_string(since)),
-														//  CurlParam("until", std::to_string(until)),
-														//  CurlParam("tail", tail)
-														});
+														std::vector<CurlParameter>{});
+
+	std::vector<CurlParameter> params{
+			{"follow", follow ? "1" : "0"},
+			{"stdout", capture_stdout ? "1" : "0"},
+			{"stderr", capture_stderr ? "1" : "0"},
+			{"timestamps", timestamps ? "1" : "0"},
+			{"tail", tail}
+	};
+	// 0 veut dire "pas de borne" : le démon refuse since=0 avec until
+	if (since > 0) params.push_back({"since", std::to_string(since)});
+	if (until > 0) params.push_back({"until", std::to_string(until)});
+	request.setParameters(params);
 
 	auto response = request.execute();
 
@@ -773,79 +753,363 @@ Container::logs(bool follow, bool capture_stdout, bool capture_stderr, long sinc
 				"Failed to get logs for container: " + id + " (HTTP " + std::to_string(response->status_code) + ")");
 	}
 
-	// If not in follow mode, parse the response
-	if (!follow && !response->body.empty()) {
-		logs = parseLogsResponse(response->body);
+	// En mode follow la réponse se termine quand le conteneur s'arrête
+	if (!response->body.empty()) {
+		logs = parseLogsResponse(response->body, config.tty);
 	}
 
 	return logs;
 }
 
-// Utility function to parse Docker logs response
-std::vector<std::string> Container::parseLogsResponse(const std::string &response) {
-	std::vector<std::string> logs;
+void Container::logs(const LogDemuxer::LineCallback &callback, bool capture_stdout, bool capture_stderr, long since, long until,
+					 bool timestamps, const std::string &tail, const std::atomic<bool> *stop) {
+	if (!dockerClient) {
+		throw std::runtime_error("dockerClient is null in Container::logs()");
+	}
 
-	// Les logs Docker sont dans un format binaire avec header de 8 bytes
-	size_t pos = 0;
-	while (pos < response.size()) {
-		if (pos + 8 <= response.size()) {
-			// Lire l'header (8 bytes: stream_type + 3 bytes padding + size)
-			// Bytes 0: Stream type (0=stdin, 1=stdout, 2=stderr)
-			// Bytes 1-3: Padding (toujours 0)
-			// Bytes 4-7: Size of following data (big-endian)
-
-			uint8_t stream_type = static_cast<uint8_t>(response[pos]);
-			uint32_t size_be = *reinterpret_cast<const uint32_t *>(response.data() + pos + 4);
-			uint32_t log_size = ntohl(size_be); // Network to host byte order
-
-			pos += 8; // Skip header
-
-			if (pos + log_size <= response.size() && log_size > 0) {
-				std::string log_line(response.data() + pos, log_size);
-
-				// Optional: prefix with stream type
-				std::string prefix;
-				switch (stream_type) {
-					case 0:
-						prefix = "[STDIN] ";
-						break;
-					case 1:
-						prefix = "[STDOUT] ";
-						break;
-					case 2:
-						prefix = "[STDERR] ";
-						break;
-					default:
-						prefix = "[UNKNOWN] ";
-						break;
-				}
+	std::string url = dockerClient->getDockerApiUrl() +
+			fmt::format("/containers/{}/logs?stdout={}&stderr={}&timestamps={}&tail={}",
+						id, capture_stdout ? 1 : 0, capture_stderr ? 1 : 0, timestamps ? 1 : 0, tail);
+	if (since > 0) url += fmt::format("&since={}", since);
+	if (until > 0) url += fmt::format("&until={}", until);
 
-				// Retirer le \n final s'il existe
-				if (!log_line.empty() && log_line.back() == '\n') {
-					log_line.pop_back();
-				}
+	if (stop && stop->load(std::memory_order_relaxed)) return;
+
+	LogDemuxer demuxer(config.tty);
+	DockerStream stream(url);
+	stream.onData([&demuxer, &callback, stop](const char *data, size_t size) {
+		demuxer.feed(data, size, callback);
+		return stop && stop->load(std::memory_order_relaxed) ? DockerStream::Action::Stop : DockerStream::Action::Continue;
+	});
+
+	long status = stream.perform();
+	if (status != 200) {
+		std::cerr << "Error: HTTP " << status << std::endl;
+		throw std::runtime_error(
+				"Failed to get logs for container: " + id + " (HTTP " + std::to_string(status) + ") " + stream.getErrorBody());
+	}
+	if (stop && stop->load(std::memory_order_relaxed)) return;
+	demuxer.flush(callback);
+}
+
+void Container::logsSince(containerTypes::LogCursor &cursor, const LogDemuxer::LineCallback &callback, bool capture_stdout,
+						  bool capture_stderr) {
+	if (!dockerClient) {
+		throw std::runtime_error("dockerClient is null in Container::logsSince()");
+	}
+
+	std::string url = dockerClient->getDockerApiUrl() +
+			fmt::format("/containers/{}/logs?stdout={}&stderr={}&timestamps=1",
+						id, capture_stdout ? 1 : 0, capture_stderr ? 1 : 0);
+	if (cursor.lastTimestamp > 0) {
+		// since accepts <seconds>.<nanoseconds>: the daemon skips everything older without sending it
+		url += fmt::format("&since={}.{:09}", cursor.lastTimestamp / 1000000000, cursor.lastTimestamp % 1000000000);
+	}
+
+	// Lines at the cursor timestamp come back again: skip as many as were already delivered
+	const int64_t resumeAt = cursor.lastTimestamp;
+	size_t toSkip = cursor.seenAtLastTimestamp;
+	auto deliver = [&](containerTypes::LogStream stream, std::string_view line) {
+		std::string_view message;
+		const int64_t timestamp = parseLogTimestamp(line, &message);
+		if (timestamp == 0) {
+			callback(stream, line);
+			return;
+		}
+		if (timestamp < resumeAt) return;
+		if (timestamp == resumeAt && toSkip > 0) {
+			--toSkip;
+			return;
+		}
+		if (timestamp == cursor.lastTimestamp) {
+			++cursor.seenAtLastTimestamp;
+		} else if (timestamp > cursor.lastTimestamp) {
+			cursor.lastTimestamp = timestamp;
+			cursor.seenAtLastTimestamp = 1;
+		}
+		callback(stream, message);
+	};
+
+	LogDemuxer demuxer(config.tty);
+	DockerStream stream(url);
+	stream.onData([&demuxer, &deliver](const char *data, size_t size) {
+		demuxer.feed(data, size, deliver);
+		return DockerStream::Action::Continue;
+	});
+
+	long status = stream.perform();
+	if (status != 200) {
+		throw std::runtime_error(
+				"Failed to get logs for container: " + id + " (HTTP " + std::to_string(status) + ") " + stream.getErrorBody());
+	}
+	demuxer.flush(deliver);
+}
+
+std::vector<std::string> Container::logsSince(containerTypes::LogCursor &cursor) {
+	std::vector<std::string> lines;
+	const bool tty = config.tty;
+	logsSince(cursor, [&lines, tty](containerTypes::LogStream stream, std::string_view line) {
+		if (tty) {
+			lines.emplace_back(line);
+			return;
+		}
+		std::string entry(logStreamPrefix(stream));
+		entry.append(line);
+		lines.push_back(std::move(entry));
+	});
+	return lines;
+}
+
+statsTypes::ContainerStatsSample Container::stats(bool oneShot) {
+	if (!dockerClient) {
+		throw std::runtime_error("dockerClient is null in Container::stats()");
+	}
+
+	ReqUEST request = ReqUEST(dockerClient->getDockerApiUrl() + fmt::format("/containers/{}/stats", id),
+														std::vector<CurlParameter>{});
+	request.setParameters({{"stream", "0"}, {"one-shot", oneShot ? "1" : "0"}});
+
+	auto response = request.execute();
+	if (response->status_code != 200) {
+		throw std::runtime_error(
+				"Failed to get stats for container: " + id + " (HTTP " + std::to_string(response->status_code) + ")");
+	}
+
+	try {
+		return parseStatsSample(nlohmann::json::parse(response->body));
+	} catch (const nlohmann::json::exception &e) {
+		throw std::runtime_error("Failed to parse stats of container " + id + ": " + e.what());
+	}
+}
+
+std::string Container::execCreate(const containerTypes::ExecConfig &execConfig) {
+	if (!dockerClient) {
+		throw std::runtime_error("dockerClient is null in Container::execCreate()");
+	}
+
+	ReqUEST request = ReqUEST(dockerClient->getDockerApiUrl() + fmt::format("/containers/{}/exec", id),
+														std::vector<CurlParameter>{});
+	request.setMethod(method::HttpMethod::_POST);
+	request.setHeader("Content-Type: application/json");
+	request.setBody(execConfig.toJson().dump());
+
+	auto response = request.execute();
+	if (!response) {
+		throw std::runtime_error("Failed to execute exec create request for container: " + id);
+	}
+	if (response->status_code != 201) {
+		throw std::runtime_error(
+				"Failed to create exec in container: " + id + " (HTTP " + std::to_string(response->status_code) + ") " + response->body);
+	}
+
+	try {
+		std::string execId = nlohmann::json::parse(response->body).at("Id").get<std::string>();
+		execIDs.push_back(execId);
+		return execId;
+	} catch (const nlohmann::json::exception &e) {
+		throw std::runtime_error("Failed to parse exec create response for container " + id + ": " + e.what());
+	}
+}
+
+std::unique_ptr<ExecSession> Container::execStart(const std::string &execId, bool tty) {
+	if (!dockerClient) {
+		throw std::runtime_error("dockerClient is null in Container::execStart()");
+	}
+	return std::make_unique<ExecSession>(dockerClient->getDockerApiUrl(), execId, tty);
+}
 
-				logs.push_back(prefix + log_line);
-				pos += log_size;
-			} else {
-				// Corrupted or incomplete data
+containerTypes::ExecInspect Container::execInspect(const std::string &execId) {
+	if (!dockerClient) {
+		throw std::runtime_error("dockerClient is null in Container::execInspect()");
+	}
+
+	ReqUEST request = ReqUEST(dockerClient->getDockerApiUrl() + fmt::format("/exec/{}/json", execId),
+														std::vector<CurlParameter>{});
+
+	auto response = request.execute();
+	if (!response) {
+		throw std::runtime_error("Failed to execute inspect request for exec: " + execId);
+	}
+	if (response->status_code != 200) {
+		throw std::runtime_error(
+				"Failed to inspect exec: " + execId + " (HTTP " + std::to_string(response->status_code) + ")");
+	}
+
+	try {
+		auto json = nlohmann::json::parse(response->body);
+		containerTypes::ExecInspect inspect;
+		inspect.id = json.value("ID", execId);
+		inspect.containerId = json.value("ContainerID", std::string{});
+		inspect.running = json.value("Running", false);
+		inspect.exitCode = json.contains("ExitCode") && json["ExitCode"].is_number() ? json["ExitCode"].get<int>() : -1;
+		inspect.pid = json.value("Pid", 0);
+		inspect.openStdin = json.value("OpenStdin", false);
+		if (json.contains("ProcessConfig") && json["ProcessConfig"].is_object()) {
+			inspect.tty = json["ProcessConfig"].value("tty", false);
+		}
+		return inspect;
+	} catch (const nlohmann::json::exception &e) {
+		throw std::runtime_error("Failed to parse exec inspect response for " + execId + ": " + e.what());
+	}
+}
+
+void Container::execResize(const std::string &execId, int height, int width) {
+	if (!dockerClient) {
+		throw std::runtime_error("dockerClient is null in Container::execResize()");
+	}
+
+	ReqUEST request = ReqUEST(dockerClient->getDockerApiUrl() + fmt::format("/exec/{}/resize", execId),
+														std::vector<CurlParameter>{});
+	request.setMethod(method::HttpMethod::_POST);
+	request.setParameters({{"h", std::to_string(height)}, {"w", std::to_string(width)}});
+
+	auto response = request.execute();
+	if (!response) {
+		throw std::runtime_error("Failed to execute resize request for exec: " + execId);
+	}
+	if (response->status_code != 200 && response->status_code != 201) {
+		throw std::runtime_error(
+				"Failed to resize exec: " + execId + " (HTTP " + std::to_string(response->status_code) + ")");
+	}
+}
+
+containerTypes::ExecResult Container::exec(const std::vector<std::string> &cmd, std::chrono::milliseconds timeout,
+										   size_t maxOutputBytes) {
+	const auto started = std::chrono::steady_clock::now();
+	containerTypes::ExecResult result;
+
+	containerTypes::ExecConfig execConfig;
+	execConfig.cmd = cmd;
+	const std::string execId = execCreate(execConfig);
+
+	auto session = execStart(execId);
+	bool complete = session->pump([&result, maxOutputBytes](containerTypes::LogStream stream, std::string_view data) {
+		std::string &target = stream == containerTypes::LogStream::STDERR ? result.errors : result.output;
+		if (target.size() + data.size() > maxOutputBytes) {
+			data = data.substr(0, maxOutputBytes - std::min(maxOutputBytes, target.size()));
+			result.truncated = true;
+		}
+		target.append(data);
+	}, timeout);
+
+	result.timedOut = !complete;
+	if (complete) {
+		// The stream closes as the process exits; the exit code can lag behind, by much more on a loaded daemon.
+		// Backoff from 5 ms to 200 ms, about 2 s in all before giving up with exitCodeKnown unset.
+		auto delay = std::chrono::milliseconds(5);
+		const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+		while (true) {
+			auto inspect = execInspect(execId);
+			if (!inspect.running) {
+				result.exitCode = inspect.exitCode;
+				result.exitCodeKnown = true;
 				break;
 			}
-		} else {
-			// Header incomplet
-			break;
+			if (std::chrono::steady_clock::now() + delay > deadline) break;
+			std::this_thread::sleep_for(delay);
+			delay = std::min(delay * 2, std::chrono::milliseconds(200));
 		}
 	}
+	result.duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started);
+	return result;
+}
 
-	// Fallback: if binary parsing fails, try simple text parsing
-	if (logs.empty() && !response.empty()) {
-		std::istringstream stream(response);
-		std::string line;
-		while (std::getline(stream, line)) {
-			logs.push_back(line);
-		}
+static std::string escapeQueryValue(const std::string &value) {
+	char *escaped = curl_easy_escape(nullptr, value.c_str(), static_cast<int>(value.size()));
+	if (!escaped) return value;
+	std::string result(escaped);
+	curl_free(escaped);
+	return result;
+}
+
+void Container::archiveGet(const std::string &containerPath, const DockerStream::DataCallback &consumer) {
+	if (!dockerClient) {
+		throw std::runtime_error("dockerClient is null in Container::archiveGet()");
 	}
 
+	DockerStream stream(dockerClient->getDockerApiUrl() +
+			fmt::format("/containers/{}/archive?path={}", id, escapeQueryValue(containerPath)));
+	stream.onData(consumer);
+
+	long status = stream.perform();
+	if (status != 200) {
+		throw std::runtime_error(fmt::format("Failed to get archive {} from container {} (HTTP {}): {}",
+											 containerPath, id, status, stream.getErrorBody()));
+	}
+}
+
+void Container::archivePut(const std::string &containerDir, const DockerStream::BodySource &source, curl_off_t size,
+						   bool noOverwriteDirNonDir) {
+	if (!dockerClient) {
+		throw std::runtime_error("dockerClient is null in Container::archivePut()");
+	}
+
+	DockerStream stream(dockerClient->getDockerApiUrl() +
+			fmt::format("/containers/{}/archive?path={}&noOverwriteDirNonDir={}", id, escapeQueryValue(containerDir),
+						noOverwriteDirNonDir ? 1 : 0));
+	stream.setMethod("PUT")
+			.setHeader("Content-Type: application/x-tar")
+			.setBodySource(source, size);
+
+	long status = stream.perform();
+	if (status != 200) {
+		throw std::runtime_error(fmt::format("Failed to put archive into {} of container {} (HTTP {}): {}",
+											 containerDir, id, status, stream.getErrorBody()));
+	}
+}
+
+uint64_t Container::copyTo(const std::string &localPath, const std::string &containerDir) {
+	// Le tar est produit pendant l'envoi, directement dans le tampon de libcurl
+	TarWriter writer;
+	writer.add(localPath);
+	archivePut(containerDir, [&writer](char *buffer, size_t capacity) {
+		return writer.read(buffer, capacity);
+	});
+	return writer.bytesProduced();
+}
+
+uint64_t Container::copyFrom(const std::string &containerPath, const std::string &localDir) {
+	TarReader reader(localDir);
+	uint64_t received = 0;
+	std::exception_ptr extractError;
+	archiveGet(containerPath, [&reader, &received, &extractError](const char *data, size_t size) {
+		try {
+			reader.feed(data, size);
+		} catch (...) {
+			// Les exceptions ne doivent pas traverser libcurl
+			extractError = std::current_exception();
+			return DockerStream::Action::Stop;
+		}
+		received += size;
+		return DockerStream::Action::Continue;
+	});
+	if (extractError) std::rethrow_exception(extractError);
+	reader.finish();
+	return received;
+}
+
+// Utility function to parse Docker logs response
+std::vector<std::string> Container::parseLogsResponse(const std::string &response, bool tty) {
+	std::vector<std::string> logs;
+
+	// Les logs Docker sont dans un format binaire avec header de 8 bytes (sauf TTY : texte brut).
+	// En cas de doute le demuxer reconnaît le format sur les 8 premiers octets.
+	LogDemuxer demuxer(tty ? LogDemuxer::Mode::Raw : LogDemuxer::Mode::Auto);
+	auto collect = [&logs, &demuxer](containerTypes::LogStream stream, std::string_view line) {
+		if (demuxer.isRaw()) {
+			logs.emplace_back(line);
+			return;
+		}
+		const char *prefix = logStreamPrefix(stream);
+		std::string entry;
+		entry.reserve(std::char_traits<char>::length(prefix) + line.size());
+		entry.append(prefix).append(line);
+		logs.push_back(std::move(entry));
+	};
+
+	demuxer.feed(response.data(), response.size(), collect);
+	demuxer.flush(collect);
+
 	return logs;
 }
 
@@ -855,33 +1119,18 @@ std::vector<std::string> Container::getRecentLogs(int lines) {
 }
 
 // Version pour suivre les logs en temps réel (non-bloquante)
-void Container::followLogsAsync(std::function<void(const std::string &)> callback, int maxDuration) {
-	std::thread logThread([this, callback, maxDuration]() {
-			try {
-				auto start = std::chrono::steady_clock::now();
-
-				// Cette implémentation nécessiterait une approche différente
-				// car curl_easy_perform est bloquant. Pour un vrai streaming,
-				// il faudrait utiliser libcurl multi interface ou une autre approche
-
-				auto logs = this->logs(true, true, true, 0, 0, true, "all");
-
-				for (const auto &log: logs) {
-					callback(log);
-
-					// Vérifier le timeout
-					if (maxDuration > 0) {
-						auto now = std::chrono::steady_clock::now();
-						auto duration = std::chrono::duration_cast<std::chrono::seconds>(now - start);
-						if (duration.count() >= maxDuration) {
-							break;
-						}
-					}
-				}
-			} catch (const std::exception &e) {
-				callback("Error following logs: " + std::string(e.what()));
-			}
-	});
+std::unique_ptr<LogFollower> Container::followLogsAsync(std::function<void(const std::string &)> callback, int maxDuration,
+												 const std::string &tail) {
+	if (!dockerClient) {
+		throw std::runtime_error("dockerClient is null in Container::followLogsAsync()");
+	}
+	if (id.empty()) {
+		throw std::runtime_error("Container id is empty in Container::followLogsAsync()");
+	}
 
-	logThread.detach();
-}
\ No newline at end of file
+	// Le follower ne garde que l'URL : il peut survivre à ce Container
+	std::string url = dockerClient->getDockerApiUrl() +
+			fmt::format("/containers/{}/logs?follow=1&stdout=1&stderr=1&tail={}", id, tail);
+
+	return std::make_unique<LogFollower>(url, config.tty, std::move(callback), maxDuration);
+}
@@ -6,6 +6,7 @@
 
 #include <string>
 #include <any>
+#include <atomic>
 #include <map>
 #include <vector>
 #include <memory>
@@ -13,6 +14,11 @@
 #include <optional>
 #include <nlohmann/json.hpp>
 #include "types/container_types.h"
+#include "types/stats_types.h"
+#include "log_follower.h"
+#include "log_demuxer.h"
+#include "exec_session.h"
+#include "docker_stream.h"
 
 containerTypes::ContainerStatus stringToState(const std::string &status);
 std::string stateToString(containerTypes::ContainerStatus status);
@@ -48,7 +54,7 @@ private:
 	int restartCount;
 	containerTypes::ContainerState state;
 
-	static std::vector<std::string> parseLogsResponse(const std::string &response);
+	static std::vector<std::string> parseLogsResponse(const std::string &response, bool tty);
 		
 public:
 		// Constructor pour créer depuis JSON
@@ -56,7 +62,10 @@ public:
 
 		std::vector<std::string> getRecentLogs(int lines = 100);
 
-		void followLogsAsync(std::function<void(const std::string &)> callback, int maxDuration = 0);
+		// Streams new lines to callback until the container stops, maxDuration (s) elapses
+		// or the returned handle is cancelled/destroyed. Does not capture this.
+		std::unique_ptr<LogFollower> followLogsAsync(std::function<void(const std::string &)> callback, int maxDuration = 0,
+				const std::string &tail = "all");
 
 		// Getters
 		// Getters (optimized, concise, const refs)
@@ -90,14 +99,63 @@ public:
 
 		std::vector<std::string> logs(
 				bool follow = false,
-				bool capture_stdout = false,
-				bool capture_stderr = false,
+				bool capture_stdout = true,
+				bool capture_stderr = true,
 				long since = 0,
 				long until = 0,
 				bool timestamps = false,
 				const std::string &tail = "all"
 		);
 
+		// Same query as logs(), streamed: each line is handed out as a view with its stream
+		// while the response arrives, nothing is buffered or prefixed. The transfer ends
+		// early once stop is set (checked after every chunk received).
+		void logs(const LogDemuxer::LineCallback &callback,
+				bool capture_stdout = true,
+				bool capture_stderr = true,
+				long since = 0,
+				long until = 0,
+				bool timestamps = false,
+				const std::string &tail = "all",
+				const std::atomic<bool> *stop = nullptr);
+
+		// Lines written after the cursor, which is then moved past them: polling
+		// with the same cursor only transfers new output. Lines are given without
+		// the daemon timestamp.
+		void logsSince(containerTypes::LogCursor &cursor, const LogDemuxer::LineCallback &callback,
+				bool capture_stdout = true,
+				bool capture_stderr = true);
+		std::vector<std::string> logsSince(containerTypes::LogCursor &cursor);
+
+		// One /stats sample. The daemon waits about a second to fill precpu_stats so CPU % can be
+		// derived; oneShot skips that wait (no CPU %). For many containers use StatsCollector.
+		statsTypes::ContainerStatsSample stats(bool oneShot = false);
+
+		// Exec: create returns the exec id, start hijacks the connection for stdin/stdout/stderr
+		std::string execCreate(const containerTypes::ExecConfig &execConfig);
+		std::unique_ptr<ExecSession> execStart(const std::string &execId, bool tty = false);
+		containerTypes::ExecInspect execInspect(const std::string &execId);
+		void execResize(const std::string &execId, int height, int width);
+
+		// Runs cmd to completion and collects its output (at most maxOutputBytes per stream).
+		// On timeout the command keeps running in the container and timedOut is set.
+		// exitCodeKnown stays false when the daemon does not report the exit within about 2 s.
+		containerTypes::ExecResult exec(const std::vector<std::string> &cmd,
+				std::chrono::milliseconds timeout = std::chrono::milliseconds(0),
+				size_t maxOutputBytes = 1 << 20);
+
+		// Archive: tar streams of the container filesystem, never held in memory.
+		// archiveGet hands out the tar of containerPath (file or directory) as it arrives,
+		// archivePut extracts the tar produced by source into containerDir, which must exist.
+		void archiveGet(const std::string &containerPath, const DockerStream::DataCallback &consumer);
+		void archivePut(const std::string &containerDir, const DockerStream::BodySource &source, curl_off_t size = -1,
+				bool noOverwriteDirNonDir = false);
+
+		// docker cp in both directions: local files are tarred while uploading, downloads
+		// are extracted while receiving. Both return the tar bytes transferred.
+		uint64_t copyTo(const std::string &localPath, const std::string &containerDir);
+		uint64_t copyFrom(const std::string &containerPath, const std::string &localDir);
+
 		[[nodiscard]] nlohmann::json inspect();
 
 		void stop();
@@ -125,8 +125,49 @@ bool ContainerManager::create(const std::string &name, const nlohmann::json &con
 	}
 }
 
-void ContainerManager::remove(const std::string &containerName) {
+std::string ContainerManager::createContainer(const std::string &name, const nlohmann::json &config) {
+	ReqUEST request(fmt::format("{}/containers/create?name={}", dockerClient->getDockerApiUrl(), name), std::vector<CurlParameter>{});
+	request.setMethod(method::HttpMethod::_POST);
+	request.setHeader("Content-Type: application/json");
+	request.setBody(config.dump());
+
+	std::shared_ptr<CurlResponse> response = request.execute();
+	if (!response) {
+		throw std::runtime_error("Failed to create container " + name + ": no response");
+	}
+	if (response->status_code != 201) {
+		// Le daemon explique l'erreur dans {"message": ...}
+		auto body = nlohmann::json::parse(response->body, nullptr, false);
+		std::string message = body.is_object() && body.contains("message") && body["message"].is_string()
+				? body["message"].get<std::string>() : response->body;
+		throw std::runtime_error(fmt::format("Failed to create container {} (HTTP {}): {}", name, response->status_code, message));
+	}
 
+	auto body = nlohmann::json::parse(response->body, nullptr, false);
+	if (!body.is_object() || !body.contains("Id") || !body["Id"].is_string()) {
+		throw std::runtime_error("Container creation response for " + name + " does not contain an ID");
+	}
+	return body["Id"].get<std::string>();
+}
+
+void ContainerManager::remove(const std::string &containerName, bool force, bool removeVolumes) {
+	if (containerName.empty()) {
+		throw std::runtime_error("Container name cannot be empty");
+	}
+
+	ReqUEST request(fmt::format("{}/containers/{}?force={}&v={}", dockerClient->getDockerApiUrl(), containerName, force, removeVolumes),
+									std::vector<CurlParameter>{});
+	std::shared_ptr<CurlResponse> response = request.setMethod(method::HttpMethod::_DELETE).execute();
+
+	if (!response) {
+		throw std::runtime_error("Failed to execute remove request for container: " + containerName);
+	}
+	if (response->status_code != 204) {
+		auto body = nlohmann::json::parse(response->body, nullptr, false);
+		std::string message = body.is_object() && body.contains("message") && body["message"].is_string()
+				? body["message"].get<std::string>() : response->body;
+		throw std::runtime_error(fmt::format("Failed to remove container {} (HTTP {}): {}", containerName, response->status_code, message));
+	}
 }
 
 /*
@@ -219,13 +260,20 @@ std::vector<ContainerList> ContainerManager::list(bool all, int limit, bool size
 					}
 				}
 
-			   // Network settings
-			   const auto networks = item.value("Networks", nlohmann::json{});
+			   // Network settings (le daemon les range sous NetworkSettings.Networks)
+			   nlohmann::json networks = nlohmann::json::object();
+			   if (item.contains("NetworkSettings") && item["NetworkSettings"].is_object() &&
+				   item["NetworkSettings"].contains("Networks") && item["NetworkSettings"]["Networks"].is_object()) {
+				   networks = item["NetworkSettings"]["Networks"];
+			   }
 			   for (const auto &network : networks.items()) {
+				   if (!network.value().is_object()) continue;
 				   ContainerList::NetworkInfo net_info;
 				   net_info.ipAddress = network.value().value("IPAddress", "");
 				   net_info.gateway = network.value().value("Gateway", "");
 				   net_info.macAddress = network.value().value("MacAddress", "");
+				   net_info.networkId = network.value().value("NetworkID", "");
+				   net_info.endpointId = network.value().value("EndpointID", "");
 				   container.networks[network.key()] = net_info;
 			   }
 
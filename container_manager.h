@@ -37,6 +37,8 @@ struct ContainerList {
 				std::string ipAddress;
 				std::string gateway;
 				std::string macAddress;
+				std::string networkId;
+				std::string endpointId;
 		};
 		std::map<std::string, NetworkInfo> networks;
 
@@ -58,12 +60,15 @@ public:
 		
 		bool create(const std::string &name, const nlohmann::json &config);
 
+		// Same request as create(), for callers that need the new id: throws with the daemon's message on failure
+		std::string createContainer(const std::string &name, const nlohmann::json &config);
+
 		bool exists(const std::string &containerName);
 
 		nlohmann::json inspect(const std::string &id = "");
 
-		// Function to remove a container
-		void remove(const std::string &containerName);
+		// Function to remove a container; force kills it first if it is running
+		void remove(const std::string &containerName, bool force = false, bool removeVolumes = false);
 
 		std::vector<ContainerList> list(bool all = false, int limit = 0, bool size = false,
 																const std::string &filters = "");
@@ -0,0 +1,211 @@
+/*
+ * Copyright (c) 2025 Nokaji. Tous droits réservés.
+ * Ce fichier fait partie du projet Kernel-James.
+ */
+#include "container_stats.h"
+#include "container_manager.h"
+#include "docker.h"
+#include "docker_event_loop.h"
+#include "docker_stream.h"
+#include "log_demuxer.h"
+#include <fmt/format.h>
+#include <algorithm>
+#include <cctype>
+#include <iostream>
+
+namespace {
+    uint64_t counter(const nlohmann::json &object, const char *key) {
+        if (!object.is_object()) return 0;
+        auto it = object.find(key);
+        return it != object.end() && it->is_number() ? it->get<uint64_t>() : 0;
+    }
+
+    const nlohmann::json &child(const nlohmann::json &object, const char *key) {
+        static const nlohmann::json empty = nlohmann::json::object();
+        if (!object.is_object()) return empty;
+        auto it = object.find(key);
+        return it != object.end() ? *it : empty;
+    }
+
+    double perSecond(uint64_t current, uint64_t previous, double seconds) {
+        // Counters reset when the container restarts
+        return current >= previous ? static_cast<double>(current - previous) / seconds : 0.0;
+    }
+}
+
+statsTypes::ContainerStatsSample parseStatsSample(const nlohmann::json &json) {
+    statsTypes::ContainerStatsSample sample;
+    sample.read = json.contains("read") && json["read"].is_string() ? parseLogTimestamp(json["read"].get<std::string>()) : 0;
+
+    const auto &cpu = child(json, "cpu_stats");
+    const auto &precpu = child(json, "precpu_stats");
+    sample.cpuTotal = counter(child(cpu, "cpu_usage"), "total_usage");
+    sample.systemCpu = counter(cpu, "system_cpu_usage");
+    sample.previousCpuTotal = counter(child(precpu, "cpu_usage"), "total_usage");
+    sample.previousSystemCpu = counter(precpu, "system_cpu_usage");
+    sample.onlineCpus = static_cast<uint32_t>(counter(cpu, "online_cpus"));
+    if (sample.onlineCpus == 0) {
+        const auto &perCpu = child(child(cpu, "cpu_usage"), "percpu_usage");
+        sample.onlineCpus = perCpu.is_array() ? static_cast<uint32_t>(perCpu.size()) : 1;
+    }
+
+    const auto &memory = child(json, "memory_stats");
+    sample.memoryUsage = counter(memory, "usage");
+    sample.memoryLimit = counter(memory, "limit");
+    // cgroup v2 reports inactive_file, v1 total_inactive_file
+    const auto &memoryStats = child(memory, "stats");
+    sample.memoryInactiveFile = memoryStats.contains("inactive_file") ? counter(memoryStats, "inactive_file")
+                                                                      : counter(memoryStats, "total_inactive_file");
+
+    for (const auto &[name, network] : child(json, "networks").items()) {
+        sample.networkRxBytes += counter(network, "rx_bytes");
+        sample.networkTxBytes += counter(network, "tx_bytes");
+    }
+
+    // Ops are "Read"/"Write" on cgroup v1, "read"/"write" on v2
+    const auto &io = child(child(json, "blkio_stats"), "io_service_bytes_recursive");
+    if (io.is_array()) {
+        for (const auto &entry : io) {
+            std::string op = entry.value("op", std::string{});
+            std::transform(op.begin(), op.end(), op.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+            if (op == "read") sample.blockReadBytes += counter(entry, "value");
+            else if (op == "write") sample.blockWriteBytes += counter(entry, "value");
+        }
+    }
+
+    sample.pids = counter(child(json, "pids_stats"), "current");
+    return sample;
+}
+
+statsTypes::ContainerMetrics deriveMetrics(const statsTypes::ContainerStatsSample &current,
+                                           const statsTypes::ContainerStatsSample *previous) {
+    statsTypes::ContainerMetrics metrics;
+    metrics.timestamp = current.read;
+    metrics.pids = current.pids;
+
+    // Same formula as `docker stats`
+    if (current.cpuTotal > current.previousCpuTotal && current.systemCpu > current.previousSystemCpu) {
+        const double cpuDelta = static_cast<double>(current.cpuTotal - current.previousCpuTotal);
+        const double systemDelta = static_cast<double>(current.systemCpu - current.previousSystemCpu);
+        metrics.cpuPercent = cpuDelta / systemDelta * current.onlineCpus * 100.0;
+    }
+
+    metrics.memoryWorkingSet = current.memoryUsage > current.memoryInactiveFile ? current.memoryUsage - current.memoryInactiveFile : 0;
+    if (current.memoryLimit > 0) {
+        metrics.memoryPercent = static_cast<double>(metrics.memoryWorkingSet) / static_cast<double>(current.memoryLimit) * 100.0;
+    }
+
+    if (previous && current.read > previous->read) {
+        const double seconds = static_cast<double>(current.read - previous->read) / 1e9;
+        metrics.networkRxRate = perSecond(current.networkRxBytes, previous->networkRxBytes, seconds);
+        metrics.networkTxRate = perSecond(current.networkTxBytes, previous->networkTxBytes, seconds);
+        metrics.blockReadRate = perSecond(current.blockReadBytes, previous->blockReadBytes, seconds);
+        metrics.blockWriteRate = perSecond(current.blockWriteBytes, previous->blockWriteBytes, seconds);
+    }
+    return metrics;
+}
+
+StatsCollector::StatsCollector(std::shared_ptr<DockerClient> client, SampleCallback callback, std::shared_ptr<DockerEventLoop> loop)
+    : dockerClient(std::move(client)), loop(std::move(loop)), ownsLoop(!this->loop), state(std::make_shared<State>()) {
+    if (!dockerClient) {
+        throw std::runtime_error("Docker client is not initialized.");
+    }
+    if (ownsLoop) this->loop = std::make_shared<DockerEventLoop>();
+    state->callback = std::move(callback);
+}
+
+StatsCollector::~StatsCollector() {
+    stop();
+}
+
+void StatsCollector::attachOnLoop(const std::shared_ptr<State> &state, const std::shared_ptr<DockerEventLoop> &loop,
+                                  const std::string &url, const std::string &containerId) {
+    if (state->stopped || state->followers.count(containerId)) return;
+
+    auto stream = std::make_shared<DockerStream>(url);
+    std::weak_ptr<State> weakState = state;
+    stream->onData([weakState, containerId](const char *data, size_t size) {
+        auto state = weakState.lock();
+        if (!state || state->stopped) return DockerStream::Action::Stop;
+        auto it = state->followers.find(containerId);
+        if (it == state->followers.end()) return DockerStream::Action::Stop;
+
+        // One JSON document per line
+        Follower &follower = it->second;
+        follower.buffer.append(data, size);
+        const size_t consumed = splitLines(follower.buffer.data(), follower.buffer.size(), [&](std::string_view line) {
+            if (line.empty()) return;
+            try {
+                auto sample = parseStatsSample(nlohmann::json::parse(line));
+                auto metrics = deriveMetrics(sample, follower.previous ? &*follower.previous : nullptr);
+                follower.previous = sample;
+                {
+                    std::lock_guard lock(state->mutex);
+                    state->latest[containerId] = metrics;
+                }
+                if (state->callback) state->callback(containerId, sample, metrics);
+            } catch (const nlohmann::json::exception &e) {
+                std::cerr << "Ignoring malformed stats sample of " << containerId << ": " << e.what() << std::endl;
+            }
+        });
+        follower.buffer.erase(0, consumed);
+        return DockerStream::Action::Continue;
+    });
+
+    state->followers[containerId].stream = stream;
+    loop->add(stream, [weakState, containerId, stream](long status, const std::string &error) {
+        auto state = weakState.lock();
+        if (!state) return;
+        if (status != 200 && !state->stopped && !stream->isCancelled()) {
+            std::cerr << "Stats stream of " << containerId << " ended with HTTP " << status << " " << error << std::endl;
+        }
+        // Only forget the follower this stream belongs to, a new one may have been added since
+        auto it = state->followers.find(containerId);
+        if (it != state->followers.end() && it->second.stream == stream) state->followers.erase(it);
+    });
+}
+
+void StatsCollector::add(const std::string &containerId) {
+    if (!loop) throw std::runtime_error("StatsCollector is stopped");
+    const std::string url = fmt::format("{}/containers/{}/stats?stream=1", dockerClient->getDockerApiUrl(), containerId);
+    loop->post([state = state, loop = loop, url, containerId] { attachOnLoop(state, loop, url, containerId); });
+}
+
+void StatsCollector::remove(const std::string &containerId) {
+    if (!loop) return;
+    loop->post([state = state, containerId] {
+        auto it = state->followers.find(containerId);
+        if (it != state->followers.end() && it->second.stream) it->second.stream->cancel();
+        std::lock_guard lock(state->mutex);
+        state->latest.erase(containerId);
+    });
+}
+
+void StatsCollector::addRunning() {
+    ContainerManager containerManager(dockerClient);
+    for (const auto &container : containerManager.list(false)) add(container.id);
+}
+
+void StatsCollector::stop() {
+    if (!loop) return;
+    loop->post([state = state] {
+        state->stopped = true;
+        for (auto &[id, follower] : state->followers) {
+            if (follower.stream) follower.stream->cancel();
+        }
+    });
+    if (ownsLoop) loop->stop();
+    loop.reset();
+}
+
+std::optional<statsTypes::ContainerMetrics> StatsCollector::latest(const std::string &containerId) const {
+    std::lock_guard lock(state->mutex);
+    auto it = state->latest.find(containerId);
+    if (it == state->latest.end()) return std::nullopt;
+    return it->second;
+}
+
+std::unordered_map<std::string, statsTypes::ContainerMetrics> StatsCollector::snapshot() const {
+    std::lock_guard lock(state->mutex);
+    return state->latest;
+}
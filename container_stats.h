@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2025 Nokaji. Tous droits réservés.
+ * Ce fichier fait partie du projet Kernel-James.
+ */
+#pragma once
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "types/stats_types.h"
+
+class DockerClient;
+class DockerEventLoop;
+class DockerStream;
+
+// Decodes one /containers/{id}/stats document (cgroup v1 or v2 layout)
+statsTypes::ContainerStatsSample parseStatsSample(const nlohmann::json &json);
+
+// CPU % comes from the sample alone (the daemon ships its previous reading as
+// precpu_stats); rates need the previous sample and are 0 without it
+statsTypes::ContainerMetrics deriveMetrics(const statsTypes::ContainerStatsSample &current,
+                                           const statsTypes::ContainerStatsSample *previous = nullptr);
+
+/*
+ * Streams /stats for many containers on a DockerEventLoop: the daemon pushes
+ * one sample per second per container and every stream shares the loop thread,
+ * so a thousand containers cost a thousand sockets, not a thousand threads.
+ * Pass a loop to share it with other collectors (e.g. a LogMultiplexer's
+ * neighbours); otherwise the collector runs its own.
+ */
+class StatsCollector
+{
+    public:
+        using SampleCallback = std::function<void(const std::string &containerId,
+                                                  const statsTypes::ContainerStatsSample &sample,
+                                                  const statsTypes::ContainerMetrics &metrics)>;
+
+    private:
+        struct Follower {
+            std::shared_ptr<DockerStream> stream;
+            std::string buffer;
+            std::optional<statsTypes::ContainerStatsSample> previous;
+        };
+
+        // Outlives the collector while the loop may still call back into it
+        struct State {
+            SampleCallback callback;
+            std::mutex mutex;
+            bool stopped = false;
+            std::unordered_map<std::string, statsTypes::ContainerMetrics> latest;
+            std::unordered_map<std::string, Follower> followers; // loop thread only
+        };
+
+        std::shared_ptr<DockerClient> dockerClient;
+        std::shared_ptr<DockerEventLoop> loop;
+        bool ownsLoop;
+        std::shared_ptr<State> state;
+
+        static void attachOnLoop(const std::shared_ptr<State> &state, const std::shared_ptr<DockerEventLoop> &loop,
+                                 const std::string &url, const std::string &containerId);
+
+    public:
+        explicit StatsCollector(std::shared_ptr<DockerClient> client, SampleCallback callback = nullptr,
+                                std::shared_ptr<DockerEventLoop> loop = nullptr);
+        ~StatsCollector();
+
+        StatsCollector(const StatsCollector &) = delete;
+        StatsCollector &operator=(const StatsCollector &) = delete;
+
+        void add(const std::string &containerId);
+        void remove(const std::string &containerId);
+
+        // Follows every running container
+        void addRunning();
+
+        // Cancels every stream; the collector can not be restarted
+        void stop();
+
+        // Last metrics of a container, if a sample arrived
+        [[nodiscard]] std::optional<statsTypes::ContainerMetrics> latest(const std::string &containerId) const;
+        [[nodiscard]] std::unordered_map<std::string, statsTypes::ContainerMetrics> snapshot() const;
+};
@@ -10,6 +10,7 @@
 #include "container_manager.h"
 #include "network_manager.h"
 #include "image_manager.h"
+#include "network_topology.h"
 #include <utils/curl.h>
 
 DockerClient::DockerClient(DockerConfig config) {
@@ -37,6 +38,10 @@ std::unique_ptr<ImageManager> DockerClient::images() {
 	return std::make_unique<ImageManager>(std::shared_ptr<DockerClient>(this, [](DockerClient*){}));
 }
 
+std::unique_ptr<NetworkTopology> DockerClient::networkTopology() {
+	return std::make_unique<NetworkTopology>(std::shared_ptr<DockerClient>(this, [](DockerClient*){}));
+}
+
 bool DockerClient::ping() {
 	std::string url = dockerApiUrl + "/_ping";
 
@@ -10,6 +10,7 @@
 #include "container_manager.h"
 #include "network_manager.h"
 #include "image_manager.h"
+#include "network_topology.h"
 
 struct DockerConfig {
 	std::string dockerHost = "localhost"; // Docker host address
@@ -34,6 +35,7 @@ public:
 	std::unique_ptr<ContainerManager> containers();
 	std::unique_ptr<NetworkManager> networks();
 	std::unique_ptr<ImageManager> images();
+	std::unique_ptr<NetworkTopology> networkTopology();
 
 	~DockerClient() = default;
 
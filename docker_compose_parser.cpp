@@ -10,187 +10,219 @@
 #include "types/network_types.h"
 #include "docker_compose_parser.h"
 
-ComposeConfig parseComposeFile(const std::string& filePath) {
-    YAML::Node config = YAML::LoadFile(filePath);
-    ComposeConfig result;
-    std::map<std::string, Service> services;
-    
-    if (config["services"]) {
-        for (const auto& serviceNode : config["services"]) {
-            std::string serviceName = serviceNode.first.as<std::string>();
-            Service service;
+namespace {
+
+    std::map<std::string, Service> parseServices(const YAML::Node& config) {
+        std::map<std::string, Service> services;
+        if (config["services"]) {
+            for (const auto& serviceNode : config["services"]) {
+                std::string serviceName = serviceNode.first.as<std::string>();
+                Service service;
             
-            auto serviceConfig = serviceNode.second;
+                auto serviceConfig = serviceNode.second;
             
-            if (serviceConfig["image"]) {
-                service.image = serviceConfig["image"].as<std::string>();
-            }
+                if (serviceConfig["image"]) {
+                    service.image = serviceConfig["image"].as<std::string>();
+                }
             
-            if (serviceConfig["ports"]) {
-                for (const auto& port : serviceConfig["ports"]) {
-                    service.ports.push_back(port.as<std::string>());
+                if (serviceConfig["container_name"]) {
+                    service.container_name = serviceConfig["container_name"].as<std::string>();
+                }
+
+                if (serviceConfig["restart"]) {
+                    service.restart = serviceConfig["restart"].as<std::string>();
                 }
-            }
             
-            if (serviceConfig["volumes"]) {
-                for (const auto& volume : serviceConfig["volumes"]) {
-                    service.volumes.push_back(volume.as<std::string>());
+                if (serviceConfig["deploy"] && serviceConfig["deploy"]["replicas"]) {
+                    service.replicas = serviceConfig["deploy"]["replicas"].as<size_t>();
+                } else if (serviceConfig["scale"]) {
+                    service.replicas = serviceConfig["scale"].as<size_t>();
                 }
-            }
 
-            if (serviceConfig["networks"]) {
-                auto networkNode = serviceConfig["networks"];
-                
-                if (networkNode.IsSequence()) {
-                    // Format array: ["network1", "network2"]
-                    for (const auto& network : networkNode) {
-                        service.networks.push_back(network.as<std::string>());
+                if (serviceConfig["ports"]) {
+                    for (const auto& port : serviceConfig["ports"]) {
+                        service.ports.push_back(port.as<std::string>());
                     }
-                } else if (networkNode.IsMap()) {
-                    // Format object: {network1: {}, network2: {}}
-                    for (const auto& network : networkNode) {
-                        service.networks.push_back(network.first.as<std::string>());
+                }
+            
+                if (serviceConfig["volumes"]) {
+                    for (const auto& volume : serviceConfig["volumes"]) {
+                        service.volumes.push_back(volume.as<std::string>());
                     }
                 }
-            }
 
-            if (serviceConfig["depends_on"]) {
-                auto dependsNode = serviceConfig["depends_on"];
+                if (serviceConfig["networks"]) {
+                    auto networkNode = serviceConfig["networks"];
                 
-                if (dependsNode.IsSequence()) {
-                    // Format array: ["service1", "service2"]
-                    for (const auto& dependency : dependsNode) {
-                        service.depends_on.push_back(dependency.as<std::string>());
+                    if (networkNode.IsSequence()) {
+                        // Format array: ["network1", "network2"]
+                        for (const auto& network : networkNode) {
+                            service.networks.push_back(network.as<std::string>());
+                        }
+                    } else if (networkNode.IsMap()) {
+                        // Format object: {network1: {}, network2: {}}
+                        for (const auto& network : networkNode) {
+                            service.networks.push_back(network.first.as<std::string>());
+                        }
                     }
-                } else if (dependsNode.IsMap()) {
-                    // Format object: {service1: {condition: "service_started"}}
-                    for (const auto& dependency : dependsNode) {
-                        service.depends_on.push_back(dependency.first.as<std::string>());
+                }
+
+                if (serviceConfig["depends_on"]) {
+                    auto dependsNode = serviceConfig["depends_on"];
+                
+                    if (dependsNode.IsSequence()) {
+                        // Format array: ["service1", "service2"]
+                        for (const auto& dependency : dependsNode) {
+                            service.depends_on.push_back(dependency.as<std::string>());
+                        }
+                    } else if (dependsNode.IsMap()) {
+                        // Format object: {service1: {condition: "service_started"}}
+                        for (const auto& dependency : dependsNode) {
+                            service.depends_on.push_back(dependency.first.as<std::string>());
+                        }
                     }
                 }
-            }
             
-            if (serviceConfig["environment"]) {
-                auto envNode = serviceConfig["environment"];
-                if (envNode.IsMap()) {
-                    // Format object: {KEY: VALUE, KEY2: VALUE2}
-                    for (const auto& env : envNode) {
-                        std::string key = env.first.as<std::string>();
-                        std::string value = env.second.as<std::string>();
-                        service.environment[key] = value;
+                if (serviceConfig["environment"]) {
+                    auto envNode = serviceConfig["environment"];
+                    if (envNode.IsMap()) {
+                        // Format object: {KEY: VALUE, KEY2: VALUE2}
+                        for (const auto& env : envNode) {
+                            std::string key = env.first.as<std::string>();
+                            std::string value = env.second.as<std::string>();
+                            service.environment[key] = value;
+                        }
                     }
                 }
-            }
             
-            services[serviceName] = service;
+                services[serviceName] = service;
+            }
         }
+        return services;
     }
 
-    if (config["networks"]) {
-        for (const auto& networkNode : config["networks"]) {
-            std::string networkName = networkNode.first.as<std::string>();
-            networkTypes::NetworkCompose network;
-            network.name = networkName;
-            
-            auto networkConfig = networkNode.second;
-            
-            // Parse driver
-            if (networkConfig["driver"]) {
-                network.driver = networkConfig["driver"].as<std::string>();
-            }
+    std::map<std::string, networkTypes::NetworkCompose> parseNetworks(const YAML::Node& config) {
+        std::map<std::string, networkTypes::NetworkCompose> networks;
+        if (config["networks"]) {
+            for (const auto& networkNode : config["networks"]) {
+                std::string networkName = networkNode.first.as<std::string>();
+                networkTypes::NetworkCompose network;
+                network.name = networkName;
+            
+                auto networkConfig = networkNode.second;
+            
+                // Parse driver
+                if (networkConfig["driver"]) {
+                    network.driver = networkConfig["driver"].as<std::string>();
+                }
             
-            // Parse external
-            if (networkConfig["external"]) {
-                network.external = networkConfig["external"].as<bool>();
-            } else {
-                network.external = false; // Default to false if not specified
-            }
+                // Parse external
+                if (networkConfig["external"]) {
+                    network.external = networkConfig["external"].as<bool>();
+                } else {
+                    network.external = false; // Default to false if not specified
+                }
             
-            // Parse IPAM
-            if (networkConfig["ipam"]) {
-                auto ipamNode = networkConfig["ipam"];
+                // Parse IPAM
+                if (networkConfig["ipam"]) {
+                    auto ipamNode = networkConfig["ipam"];
                 
-                if (ipamNode["driver"]) {
-                    network.ipam.driver = ipamNode["driver"].as<std::string>();
-                }
+                    if (ipamNode["driver"]) {
+                        network.ipam.driver = ipamNode["driver"].as<std::string>();
+                    }
 
-                if (ipamNode["config"]) {
-                    for (const auto& config : ipamNode["config"]) {
-                        networkTypes::IPAMConfigNetwork ipamConfig;
-                        if (config["subnet"]) {
-                            ipamConfig.subnet = config["subnet"].as<std::string>();
-                        }
-                        if (config["ip_range"]) {
-                            ipamConfig.ip_range = config["ip_range"].as<std::string>();
-                        }
-                        if (config["gateway"]) {
-                            ipamConfig.gateway = config["gateway"].as<std::string>();
-                        }
-                        if (config["aux_addresses"]) {
-                            for (const auto& aux : config["aux_addresses"]) {
-                                std::string key = aux.first.as<std::string>();
-                                std::string value = aux.second.as<std::string>();
-                                ipamConfig.aux_addresses[key] = value;
+                    if (ipamNode["config"]) {
+                        for (const auto& config : ipamNode["config"]) {
+                            networkTypes::IPAMConfigNetwork ipamConfig;
+                            if (config["subnet"]) {
+                                ipamConfig.subnet = config["subnet"].as<std::string>();
                             }
+                            if (config["ip_range"]) {
+                                ipamConfig.ip_range = config["ip_range"].as<std::string>();
+                            }
+                            if (config["gateway"]) {
+                                ipamConfig.gateway = config["gateway"].as<std::string>();
+                            }
+                            if (config["aux_addresses"]) {
+                                for (const auto& aux : config["aux_addresses"]) {
+                                    std::string key = aux.first.as<std::string>();
+                                    std::string value = aux.second.as<std::string>();
+                                    ipamConfig.aux_addresses[key] = value;
+                                }
+                            }
+                            network.ipam.config.push_back(ipamConfig);
                         }
-                        network.ipam.config.push_back(ipamConfig);
                     }
-                }
                 
-                if (ipamNode["options"]) {
-                    for (const auto& option : ipamNode["options"]) {
-                        std::string key = option.first.as<std::string>();
-                        std::string value = option.second.as<std::string>();
-                        network.ipam.options[key] = value;
+                    if (ipamNode["options"]) {
+                        for (const auto& option : ipamNode["options"]) {
+                            std::string key = option.first.as<std::string>();
+                            std::string value = option.second.as<std::string>();
+                            network.ipam.options[key] = value;
+                        }
                     }
                 }
-            }
             
-            // Parse labels
-            if (networkConfig["labels"]) {
-                for (const auto& label : networkConfig["labels"]) {
-                    std::string key = label.first.as<std::string>();
-                    std::string value = label.second.as<std::string>();
-                    network.labels[key] = value;
+                // Parse labels
+                if (networkConfig["labels"]) {
+                    for (const auto& label : networkConfig["labels"]) {
+                        std::string key = label.first.as<std::string>();
+                        std::string value = label.second.as<std::string>();
+                        network.labels[key] = value;
+                    }
                 }
-            }
             
-            // Parse driver_opts
-            if (networkConfig["driver_opts"]) {
-                for (const auto& opt : networkConfig["driver_opts"]) {
-                    std::string key = opt.first.as<std::string>();
-                    std::string value = opt.second.as<std::string>();
-                    network.driver_opts[key] = value;
+                // Parse driver_opts
+                if (networkConfig["driver_opts"]) {
+                    for (const auto& opt : networkConfig["driver_opts"]) {
+                        std::string key = opt.first.as<std::string>();
+                        std::string value = opt.second.as<std::string>();
+                        network.driver_opts[key] = value;
+                    }
                 }
-            }
             
-            // Parse enable_ipv6
-            if (networkConfig["enable_ipv6"]) {
-                network.enable_ipv6 = networkConfig["enable_ipv6"].as<bool>();
-            }
+                // Parse enable_ipv6
+                if (networkConfig["enable_ipv6"]) {
+                    network.enable_ipv6 = networkConfig["enable_ipv6"].as<bool>();
+                }
             
-            if (networkConfig["enable_ipv4"]) {
-                network.enable_ipv4 = networkConfig["enable_ipv4"].as<bool>();
-            } else {
-                network.enable_ipv4 = true; // Default to true if not specified
-            }
+                if (networkConfig["enable_ipv4"]) {
+                    network.enable_ipv4 = networkConfig["enable_ipv4"].as<bool>();
+                } else {
+                    network.enable_ipv4 = true; // Default to true if not specified
+                }
 
-            // Parse attachable
-            if (networkConfig["attachable"]) {
-                network.attachable = networkConfig["attachable"].as<bool>();
-            }else {
-                network.attachable = false; // Default to false if not specified
-            }
+                // Parse attachable
+                if (networkConfig["attachable"]) {
+                    network.attachable = networkConfig["attachable"].as<bool>();
+                }else {
+                    network.attachable = false; // Default to false if not specified
+                }
             
-            // Parse internal
-            if (networkConfig["internal"]) {
-                network.internal = networkConfig["internal"].as<bool>();
-            } else {
-                network.internal = false; // Default to false if not specified
-            }
+                // Parse internal
+                if (networkConfig["internal"]) {
+                    network.internal = networkConfig["internal"].as<bool>();
+                } else {
+                    network.internal = false; // Default to false if not specified
+                }
             
-            result.networks[networkName] = network;
+                networks[networkName] = network;
+            }
         }
+        return networks;
+    }
+
+}
+
+ComposeConfig parseCompose(const YAML::Node& config, unsigned sections) {
+    ComposeConfig result;
+
+    if (sections & COMPOSE_SERVICES) {
+        result.services = parseServices(config);
+    }
+
+    if (sections & COMPOSE_NETWORKS) {
+        result.networks = parseNetworks(config);
     }
 
     if (config["volumes"]) {
@@ -200,11 +232,19 @@ ComposeConfig parseComposeFile(const std::string& filePath) {
             // Currently, we are not storing volumes in the Service struct
         }
     }
-    
-    result.services = services;
+
     return result;
 }
 
+ComposeConfig parseComposeFile(const std::string& filePath, unsigned sections) {
+    return parseCompose(YAML::LoadFile(filePath), sections);
+}
+
+ComposeConfig parseComposeString(const std::string& content, unsigned sections) {
+    return parseCompose(YAML::Load(content), sections);
+}
+
 std::map<std::string, networkTypes::NetworkCompose> parseComposeNetworks(const std::string& filePath) {
-    return parseComposeFile(filePath).networks;
-}
\ No newline at end of file
+    // Services are not built just to be dropped
+    return parseComposeFile(filePath, COMPOSE_NETWORKS).networks;
+}
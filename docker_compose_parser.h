@@ -20,6 +20,7 @@ struct Service {
     std::vector<std::string> volumes;
     std::vector<std::string> networks;
     std::vector<std::string> depends_on;
+    size_t replicas = 1;                    // deploy.replicas, or the legacy scale
 };
 
 struct ComposeConfig {
@@ -27,5 +28,14 @@ struct ComposeConfig {
     std::map<std::string, networkTypes::NetworkCompose> networks;
 };
     
-ComposeConfig parseComposeFile(const std::string& filePath);
+// Top-level sections to build; the others are left empty
+enum ComposeSection : unsigned {
+    COMPOSE_SERVICES = 1u << 0,
+    COMPOSE_NETWORKS = 1u << 1,
+    COMPOSE_ALL = COMPOSE_SERVICES | COMPOSE_NETWORKS
+};
+
+ComposeConfig parseCompose(const YAML::Node& root, unsigned sections = COMPOSE_ALL);
+ComposeConfig parseComposeFile(const std::string& filePath, unsigned sections = COMPOSE_ALL);
+ComposeConfig parseComposeString(const std::string& content, unsigned sections = COMPOSE_ALL);
 std::map<std::string, networkTypes::NetworkCompose> parseComposeNetworks(const std::string& filePath);
\ No newline at end of file
@@ -0,0 +1,212 @@
+/*
+ * Copyright (c) 2025 Nokaji. Tous droits réservés.
+ * Ce fichier fait partie du projet Kernel-James.
+ */
+#include "docker_event_loop.h"
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+    constexpr int IDLE_POLL_MS = 1000;
+}
+
+DockerEventLoop::DockerEventLoop() {
+    multi = curl_multi_init();
+    if (!multi) {
+        throw std::runtime_error("Failed to initialize curl multi handle for event loop");
+    }
+    thread = std::thread(&DockerEventLoop::run, this);
+}
+
+DockerEventLoop::~DockerEventLoop() {
+    stop();
+    curl_multi_cleanup(multi);
+}
+
+void DockerEventLoop::add(std::shared_ptr<DockerStream> stream, DoneCallback done) {
+    if (!stream) return;
+    // Wake-ups for this stream must now reach our poll, not its private one
+    stream->wakeMulti.store(multi);
+    post([this, stream = std::move(stream), done = std::move(done)]() mutable {
+        stream->statusCode = 0;
+        stream->errorBody.clear();
+        stream->dataError = nullptr;
+        // Also covers streams whose task is drained after shutdown
+        if (stream->isCancelled() || stopping.load()) {
+            if (done) done(0, "");
+            return;
+        }
+        CURL *handle = stream->curl;
+        curl_multi_add_handle(multi, handle);
+        active.emplace(handle, Entry{std::move(stream), std::move(done)});
+    });
+}
+
+bool DockerEventLoop::post(Task task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (closed) return false;
+        posted.push_back(std::move(task));
+    }
+    curl_multi_wakeup(multi);
+    return true;
+}
+
+void DockerEventLoop::every(std::chrono::milliseconds interval, Task task) {
+    post([this, interval, task = std::move(task)]() mutable {
+        timers.push_back(Timer{std::chrono::steady_clock::now() + interval, interval, std::move(task)});
+    });
+}
+
+void DockerEventLoop::onIteration(Task task) {
+    post([this, task = std::move(task)]() mutable {
+        iterationHooks.push_back(std::move(task));
+    });
+}
+
+void DockerEventLoop::stop() {
+    if (stopping.exchange(true)) {
+        if (thread.joinable() && !inLoopThread()) thread.join();
+        return;
+    }
+    curl_multi_wakeup(multi);
+    if (thread.joinable() && !inLoopThread()) thread.join();
+}
+
+void DockerEventLoop::runPosted() {
+    std::vector<Task> tasks;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.swap(posted);
+    }
+    for (auto &task : tasks) {
+        try {
+            task();
+        } catch (const std::exception &e) {
+            std::cerr << "Event loop task failed: " << e.what() << std::endl;
+        }
+    }
+}
+
+void DockerEventLoop::runTimers(std::chrono::steady_clock::time_point now) {
+    for (size_t i = 0; i < timers.size(); ++i) {
+        if (timers[i].next > now) continue;
+        timers[i].next = now + timers[i].interval;
+        // The task may add timers, do not hold a reference across the call
+        Task task = timers[i].task;
+        try {
+            task();
+        } catch (const std::exception &e) {
+            std::cerr << "Event loop timer failed: " << e.what() << std::endl;
+        }
+    }
+}
+
+int DockerEventLoop::nextTimeoutMs(std::chrono::steady_clock::time_point now) const {
+    auto next = now + std::chrono::milliseconds(IDLE_POLL_MS);
+    for (const auto &timer : timers) next = std::min(next, timer.next);
+    for (const auto &[handle, entry] : active) next = std::min(next, entry.stream->deadline);
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(next - now).count();
+    return static_cast<int>(std::clamp<long long>(ms + 1, 0, IDLE_POLL_MS));
+}
+
+void DockerEventLoop::finish(CURL *handle, CURLcode result) {
+    auto it = active.find(handle);
+    if (it == active.end()) return;
+
+    Entry entry = std::move(it->second);
+    active.erase(it);
+    curl_multi_remove_handle(multi, handle);
+
+    DockerStream &stream = *entry.stream;
+    if (stream.statusCode == 0) {
+        curl_easy_getinfo(handle, CURLINFO_RESPONSE_CODE, &stream.statusCode);
+    }
+
+    std::string error;
+    const bool interrupted = stream.isCancelled() || stream.stoppedByCallback || stream.deadlineReached;
+    if (stream.dataError) {
+        try {
+            std::rethrow_exception(stream.dataError);
+        } catch (const std::exception &e) {
+            error = e.what();
+        } catch (...) {
+            error = "Stream data callback failed";
+        }
+    } else if (result != CURLE_OK && !interrupted) {
+        error = curl_easy_strerror(result);
+    } else if (stream.statusCode >= 400) {
+        error = stream.errorBody;
+    }
+
+    if (entry.done) {
+        try {
+            entry.done(stream.statusCode, error);
+        } catch (const std::exception &e) {
+            std::cerr << "Event loop completion callback failed: " << e.what() << std::endl;
+        }
+    }
+}
+
+void DockerEventLoop::run() {
+    while (!stopping.load()) {
+        runPosted();
+
+        auto now = std::chrono::steady_clock::now();
+        std::vector<CURL *> interrupted;
+        for (auto &[handle, entry] : active) {
+            DockerStream &stream = *entry.stream;
+            if (stream.isCancelled()) {
+                interrupted.push_back(handle);
+            } else if (now >= stream.deadline) {
+                stream.deadlineReached = true;
+                interrupted.push_back(handle);
+            } else if (stream.paused && stream.resumeRequested.exchange(false)) {
+                stream.paused = false;
+                curl_easy_pause(handle, CURLPAUSE_CONT);
+            }
+        }
+        for (CURL *handle : interrupted) finish(handle, CURLE_OK);
+
+        int running = 0;
+        curl_multi_perform(multi, &running);
+
+        int queued = 0;
+        while (CURLMsg *message = curl_multi_info_read(multi, &queued)) {
+            if (message->msg == CURLMSG_DONE) {
+                finish(message->easy_handle, message->data.result);
+            }
+        }
+
+        for (auto &hook : iterationHooks) {
+            try {
+                hook();
+            } catch (const std::exception &e) {
+                std::cerr << "Event loop iteration hook failed: " << e.what() << std::endl;
+            }
+        }
+
+        now = std::chrono::steady_clock::now();
+        runTimers(now);
+
+        curl_multi_poll(multi, nullptr, 0, nextTimeoutMs(now), nullptr);
+    }
+
+    // Shutdown: every remaining stream completes as cancelled
+    std::vector<CURL *> remaining;
+    remaining.reserve(active.size());
+    for (auto &[handle, entry] : active) {
+        entry.stream->cancelRequested.store(true);
+        remaining.push_back(handle);
+    }
+    for (CURL *handle : remaining) finish(handle, CURLE_OK);
+
+    // Tasks posted before the loop closed still run, later ones are refused
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+    }
+    runPosted();
+}
@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2025 Nokaji. Tous droits réservés.
+ * Ce fichier fait partie du projet Kernel-James.
+ */
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <curl/curl.h>
+#include "docker_stream.h"
+
+/*
+ * One thread driving many DockerStreams through a single curl multi handle.
+ * Data and completion callbacks, posted tasks and timers all run on the loop
+ * thread, so code scheduled on the loop needs no locking of its own.
+ */
+class DockerEventLoop
+{
+    public:
+        // status is the HTTP status (0 if none), error is empty unless the transfer failed
+        using DoneCallback = std::function<void(long status, const std::string &error)>;
+        using Task = std::function<void()>;
+
+    private:
+        struct Entry {
+            std::shared_ptr<DockerStream> stream;
+            DoneCallback done;
+        };
+
+        struct Timer {
+            std::chrono::steady_clock::time_point next;
+            std::chrono::milliseconds interval;
+            Task task;
+        };
+
+        CURLM *multi = nullptr;
+        std::thread thread;
+        std::atomic<bool> stopping{false};
+
+        std::mutex mutex;
+        std::vector<Task> posted;
+        bool closed = false;            // run() has returned, posted tasks would never run
+
+        // Loop thread only
+        std::unordered_map<CURL *, Entry> active;
+        std::vector<Timer> timers;
+        std::vector<Task> iterationHooks;
+
+        void run();
+        void runPosted();
+        void runTimers(std::chrono::steady_clock::time_point now);
+        void finish(CURL *handle, CURLcode result);
+        int nextTimeoutMs(std::chrono::steady_clock::time_point now) const;
+
+    public:
+        DockerEventLoop();
+        ~DockerEventLoop();
+
+        DockerEventLoop(const DockerEventLoop &) = delete;
+        DockerEventLoop &operator=(const DockerEventLoop &) = delete;
+
+        // Start the transfer on the loop; done is called once, on the loop thread
+        void add(std::shared_ptr<DockerStream> stream, DoneCallback done = nullptr);
+
+        // Run task on the loop thread; false once the loop has shut down (the task is dropped)
+        bool post(Task task);
+
+        // Run task on the loop thread every interval
+        void every(std::chrono::milliseconds interval, Task task);
+
+        // Run task on the loop thread after each round of transfers
+        void onIteration(Task task);
+
+        // Cancel every stream and join the thread
+        void stop();
+
+        [[nodiscard]] bool inLoopThread() const { return std::this_thread::get_id() == thread.get_id(); }
+};
@@ -0,0 +1,244 @@
+/*
+ * Copyright (c) 2025 Nokaji. Tous droits réservés.
+ * Ce fichier fait partie du projet Kernel-James.
+ */
+#include "docker_stream.h"
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+    constexpr size_t MAX_ERROR_BODY = 64 * 1024;
+    constexpr long UPLOAD_BUFFER = 512 * 1024;
+    constexpr int IDLE_POLL_MS = 1000;
+}
+
+DockerStream::DockerStream(std::string url) : url(std::move(url)) {
+    // No multi handle yet: each one holds a wakeup socketpair, and streams run on a
+    // DockerEventLoop never need their own. perform() creates it on first use.
+    curl = curl_easy_init();
+    if (!curl) {
+        throw std::runtime_error("Failed to initialize curl for stream: " + this->url);
+    }
+
+    curl_easy_setopt(curl, CURLOPT_URL, this->url.c_str());
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, &DockerStream::writeCallback);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, this);
+    curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, &DockerStream::progressCallback);
+    curl_easy_setopt(curl, CURLOPT_XFERINFODATA, this);
+    curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
+}
+
+DockerStream::~DockerStream() {
+    if (multi) {
+        curl_multi_remove_handle(multi, curl);
+        curl_multi_cleanup(multi);
+    }
+    if (curl) curl_easy_cleanup(curl);
+    if (headers) curl_slist_free_all(headers);
+}
+
+DockerStream &DockerStream::setMethod(const std::string &newMethod) {
+    method = newMethod;
+    if (bodySource) {
+        // CURLOPT_UPLOAD is a PUT unless the verb is overridden
+        curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, method.c_str());
+    } else if (method == "GET") {
+        curl_easy_setopt(curl, CURLOPT_HTTPGET, 1L);
+    } else if (method == "POST") {
+        curl_easy_setopt(curl, CURLOPT_POST, 1L);
+        // A POST without body must still send Content-Length: 0 instead of reading stdin
+        if (body.empty()) {
+            curl_easy_setopt(curl, CURLOPT_POSTFIELDS, body.c_str());
+            curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, 0L);
+        }
+    } else {
+        curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, method.c_str());
+    }
+    return *this;
+}
+
+DockerStream &DockerStream::setHeader(const std::string &header) {
+    headers = curl_slist_append(headers, header.c_str());
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+    return *this;
+}
+
+DockerStream &DockerStream::setBody(std::string newBody) {
+    body = std::move(newBody);
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE_LARGE, static_cast<curl_off_t>(body.size()));
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, body.data());
+    return *this;
+}
+
+DockerStream &DockerStream::setBodySource(BodySource source, curl_off_t size) {
+    bodySource = std::move(source);
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, nullptr);
+    curl_easy_setopt(curl, CURLOPT_UPLOAD, 1L);
+    curl_easy_setopt(curl, CURLOPT_INFILESIZE_LARGE, size);
+    curl_easy_setopt(curl, CURLOPT_READFUNCTION, &DockerStream::readCallback);
+    curl_easy_setopt(curl, CURLOPT_READDATA, this);
+    // Larger reads mean fewer callbacks and syscalls per gigabyte
+    curl_easy_setopt(curl, CURLOPT_UPLOAD_BUFFERSIZE, UPLOAD_BUFFER);
+    if (!method.empty()) {
+        curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, method.c_str());
+    }
+    // The daemon accepts the body right away, no need to wait for 100-continue
+    setHeader("Expect:");
+    if (size < 0) setHeader("Transfer-Encoding: chunked");
+    return *this;
+}
+
+DockerStream &DockerStream::setMaxDuration(std::chrono::milliseconds duration) {
+    if (duration.count() > 0) {
+        deadline = std::chrono::steady_clock::now() + duration;
+    }
+    return *this;
+}
+
+DockerStream &DockerStream::onData(DataCallback callback) {
+    dataCallback = std::move(callback);
+    return *this;
+}
+
+size_t DockerStream::writeCallback(char *data, size_t size, size_t nmemb, void *userdata) {
+    auto *self = static_cast<DockerStream *>(userdata);
+    const size_t total = size * nmemb;
+
+    if (self->cancelRequested.load(std::memory_order_relaxed)) {
+        return 0;
+    }
+
+    if (self->statusCode == 0) {
+        curl_easy_getinfo(self->curl, CURLINFO_RESPONSE_CODE, &self->statusCode);
+    }
+    if (self->statusCode >= 400) {
+        // Error responses are small JSON documents, keep them for the caller
+        self->errorBody.append(data, std::min(total, MAX_ERROR_BODY - std::min(MAX_ERROR_BODY, self->errorBody.size())));
+        return total;
+    }
+
+    if (!self->dataCallback) return total;
+
+    Action action;
+    try {
+        action = self->dataCallback(data, total);
+    } catch (...) {
+        // Exceptions must not cross libcurl
+        self->dataError = std::current_exception();
+        return 0;
+    }
+    switch (action) {
+        case Action::Continue:
+            return total;
+        case Action::Pause:
+            self->paused = true;
+            return CURL_WRITEFUNC_PAUSE;
+        case Action::Stop:
+        default:
+            self->stoppedByCallback = true;
+            return 0;
+    }
+}
+
+size_t DockerStream::readCallback(char *buffer, size_t size, size_t nmemb, void *userdata) {
+    auto *self = static_cast<DockerStream *>(userdata);
+    if (self->cancelRequested.load(std::memory_order_relaxed)) {
+        return CURL_READFUNC_ABORT;
+    }
+    try {
+        return self->bodySource(buffer, size * nmemb);
+    } catch (...) {
+        // Exceptions must not cross libcurl
+        self->bodyError = std::current_exception();
+        return CURL_READFUNC_ABORT;
+    }
+}
+
+int DockerStream::progressCallback(void *userdata, curl_off_t, curl_off_t, curl_off_t, curl_off_t) {
+    auto *self = static_cast<DockerStream *>(userdata);
+    return self->cancelRequested.load(std::memory_order_relaxed) ? 1 : 0;
+}
+
+long DockerStream::perform() {
+    statusCode = 0;
+    errorBody.clear();
+    bodyError = nullptr;
+    dataError = nullptr;
+    stoppedByCallback = false;
+    deadlineReached = false;
+
+    if (!multi) {
+        multi = curl_multi_init();
+        if (!multi) {
+            throw std::runtime_error("Failed to initialize curl multi handle for stream: " + url);
+        }
+    }
+    wakeMulti.store(multi);
+    curl_multi_add_handle(multi, curl);
+
+    int running = 1;
+    while (running) {
+        if (cancelRequested.load(std::memory_order_relaxed) || stoppedByCallback) break;
+
+        if (paused && resumeRequested.exchange(false)) {
+            paused = false;
+            curl_easy_pause(curl, CURLPAUSE_CONT);
+        }
+
+        CURLMcode code = curl_multi_perform(multi, &running);
+        if (code != CURLM_OK) {
+            curl_multi_remove_handle(multi, curl);
+            throw std::runtime_error(std::string("Stream error: ") + curl_multi_strerror(code));
+        }
+        if (!running) break;
+
+        auto now = std::chrono::steady_clock::now();
+        if (now >= deadline) {
+            deadlineReached = true;
+            break;
+        }
+
+        int timeoutMs = IDLE_POLL_MS;
+        if (deadline != std::chrono::steady_clock::time_point::max()) {
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count() + 1;
+            timeoutMs = static_cast<int>(std::min<long long>(timeoutMs, left));
+        }
+        // cancel()/resume() interrupt this wait through curl_multi_wakeup
+        curl_multi_poll(multi, nullptr, 0, timeoutMs, nullptr);
+    }
+
+    CURLcode result = CURLE_OK;
+    int queued = 0;
+    while (CURLMsg *message = curl_multi_info_read(multi, &queued)) {
+        if (message->msg == CURLMSG_DONE && message->easy_handle == curl) {
+            result = message->data.result;
+        }
+    }
+
+    if (statusCode == 0) {
+        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &statusCode);
+    }
+    curl_multi_remove_handle(multi, curl);
+
+    if (bodyError) std::rethrow_exception(bodyError);
+    if (dataError) std::rethrow_exception(dataError);
+    const bool interrupted = cancelRequested.load(std::memory_order_relaxed) || stoppedByCallback || deadlineReached;
+    if (result != CURLE_OK && !interrupted) {
+        throw std::runtime_error("Stream failed for " + url + ": " + curl_easy_strerror(result));
+    }
+
+    return statusCode;
+}
+
+void DockerStream::cancel() {
+    cancelRequested.store(true, std::memory_order_relaxed);
+    // Nothing to wake before the stream runs: the flag is checked first
+    if (CURLM *target = wakeMulti.load()) curl_multi_wakeup(target);
+}
+
+void DockerStream::resume() {
+    resumeRequested.store(true);
+    if (CURLM *target = wakeMulti.load()) curl_multi_wakeup(target);
+}
@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2025 Nokaji. Tous droits réservés.
+ * Ce fichier fait partie du projet Kernel-James.
+ */
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <string>
+#include <curl/curl.h>
+
+class DockerEventLoop;
+
+/*
+ * Streaming HTTP request against the Docker daemon.
+ * Unlike ReqUEST, which buffers the whole body, data is handed to onData()
+ * as soon as libcurl receives it. The callback may ask to pause the transfer
+ * (backpressure, resumed with resume()) or to stop it. cancel() and resume()
+ * are safe to call from any thread and take effect immediately.
+ */
+class DockerStream
+{
+    public:
+        enum class Action {
+            Continue,
+            Pause,  // keep the chunk, it will be delivered again after resume()
+            Stop
+        };
+
+        using DataCallback = std::function<Action(const char *data, size_t size)>;
+        // Fills the upload buffer in place and returns the bytes written, 0 at the end of the body
+        using BodySource = std::function<size_t(char *buffer, size_t capacity)>;
+
+    private:
+        friend class DockerEventLoop;
+
+        CURL *curl = nullptr;
+        CURLM *multi = nullptr;     // created by the first perform()
+        // Multi handle to wake on cancel()/resume(): ours, or the event loop's; none until the stream runs
+        std::atomic<CURLM *> wakeMulti{nullptr};
+        curl_slist *headers = nullptr;
+        std::string url;
+        std::string method;
+        std::string body;
+
+        DataCallback dataCallback;
+        BodySource bodySource;
+        std::exception_ptr bodyError;
+        std::exception_ptr dataError;
+        std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+
+        std::atomic<bool> cancelRequested{false};
+        std::atomic<bool> resumeRequested{false};
+        bool paused = false;
+        bool stoppedByCallback = false;
+        bool deadlineReached = false;
+
+        long statusCode = 0;
+        std::string errorBody;
+
+        static size_t writeCallback(char *data, size_t size, size_t nmemb, void *userdata);
+        static size_t readCallback(char *buffer, size_t size, size_t nmemb, void *userdata);
+        static int progressCallback(void *userdata, curl_off_t, curl_off_t, curl_off_t, curl_off_t);
+
+    public:
+        explicit DockerStream(std::string url);
+        ~DockerStream();
+
+        DockerStream(const DockerStream &) = delete;
+        DockerStream &operator=(const DockerStream &) = delete;
+
+        DockerStream &setMethod(const std::string &method);
+        DockerStream &setHeader(const std::string &header);
+        DockerStream &setBody(std::string body);
+        // Streams the request body from source instead of holding it in memory; with an
+        // unknown size (-1) it is sent chunked. Exceptions thrown by source abort the
+        // transfer and are rethrown by perform().
+        DockerStream &setBodySource(BodySource source, curl_off_t size = -1);
+        DockerStream &setMaxDuration(std::chrono::milliseconds duration);
+        // Exceptions thrown by callback abort the transfer and are rethrown by perform()
+        // (reported as the error of DockerEventLoop::add's completion otherwise)
+        DockerStream &onData(DataCallback callback);
+
+        // Blocks until the stream ends, is stopped, cancelled or times out.
+        // Returns the HTTP status; throws on transport errors.
+        // Streams shared by many callers go through DockerEventLoop::add() instead.
+        long perform();
+
+        void cancel();
+        void resume();
+
+        [[nodiscard]] bool isCancelled() const { return cancelRequested.load(std::memory_order_relaxed); }
+        [[nodiscard]] bool timedOut() const { return deadlineReached; }
+        [[nodiscard]] long getStatusCode() const { return statusCode; }
+        // Body of a >= 400 response (truncated), for error messages
+        [[nodiscard]] const std::string &getErrorBody() const { return errorBody; }
+};
@@ -0,0 +1,231 @@
+/*
+ * Copyright (c) 2025 Nokaji. Tous droits réservés.
+ * Ce fichier fait partie du projet Kernel-James.
+ */
+#include "exec_session.h"
+#include <fmt/format.h>
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#else
+#include <cerrno>
+#include <poll.h>
+#include <sys/socket.h>
+#endif
+
+namespace {
+    constexpr size_t RECEIVE_BUFFER = 32 * 1024;
+    constexpr size_t MAX_HEADER_BYTES = 16 * 1024;
+
+    // Scheme, host and port to connect to, and the path prefix (API version) of apiUrl
+    std::pair<std::string, std::string> splitApiUrl(const std::string &apiUrl, std::string &host) {
+        CURLU *url = curl_url();
+        if (!url || curl_url_set(url, CURLUPART_URL, apiUrl.c_str(), 0) != CURLUE_OK) {
+            if (url) curl_url_cleanup(url);
+            throw std::runtime_error("Invalid Docker API URL: " + apiUrl);
+        }
+        auto part = [url](CURLUPart which, unsigned flags = 0) {
+            char *value = nullptr;
+            std::string result;
+            if (curl_url_get(url, which, &value, flags) == CURLUE_OK && value) result = value;
+            curl_free(value);
+            return result;
+        };
+        const std::string scheme = part(CURLUPART_SCHEME);
+        host = part(CURLUPART_HOST);
+        const std::string port = part(CURLUPART_PORT, CURLU_DEFAULT_PORT);
+        std::string path = part(CURLUPART_PATH);
+        curl_url_cleanup(url);
+
+        while (!path.empty() && path.back() == '/') path.pop_back();
+        return {fmt::format("{}://{}:{}", scheme, host, port), path};
+    }
+
+    int remainingMs(std::chrono::steady_clock::time_point deadline) {
+        if (deadline == std::chrono::steady_clock::time_point::max()) return -1;
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+        return static_cast<int>(std::clamp<long long>(left, 0, 60 * 60 * 1000));
+    }
+}
+
+ExecSession::ExecSession(const std::string &apiUrl, std::string id, bool tty, std::chrono::milliseconds timeout)
+    : execId(std::move(id)), demuxer(tty) {
+    demuxer.passChunks();
+
+    std::string host;
+    auto [base, pathPrefix] = splitApiUrl(apiUrl, host);
+
+    curl = curl_easy_init();
+    if (!curl) {
+        throw std::runtime_error("Failed to initialize curl for exec " + execId);
+    }
+    curl_easy_setopt(curl, CURLOPT_URL, base.c_str());
+    curl_easy_setopt(curl, CURLOPT_CONNECT_ONLY, 1L);
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT_MS, static_cast<long>(timeout.count()));
+
+    CURLcode result = curl_easy_perform(curl);
+    if (result == CURLE_OK) result = curl_easy_getinfo(curl, CURLINFO_ACTIVESOCKET, &socket);
+    if (result != CURLE_OK || socket == CURL_SOCKET_BAD) {
+        curl_easy_cleanup(curl);
+        throw std::runtime_error(fmt::format("Failed to connect for exec {}: {}", execId, curl_easy_strerror(result)));
+    }
+
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    const std::string body = nlohmann::json{{"Detach", false}, {"Tty", tty}}.dump();
+    const std::string request = fmt::format(
+            "POST {}/exec/{}/start HTTP/1.1\r\n"
+            "Host: {}\r\n"
+            "Content-Type: application/json\r\n"
+            "Connection: Upgrade\r\n"
+            "Upgrade: tcp\r\n"
+            "Content-Length: {}\r\n"
+            "\r\n"
+            "{}",
+            pathPrefix, execId, host, body.size(), body);
+
+    try {
+        sendAll(request, deadline);
+        readHeaders(deadline);
+    } catch (...) {
+        curl_easy_cleanup(curl);
+        throw;
+    }
+}
+
+ExecSession::~ExecSession() {
+    if (curl) curl_easy_cleanup(curl);
+}
+
+bool ExecSession::waitSocket(bool forWrite, int timeoutMs) const {
+#ifdef _WIN32
+    WSAPOLLFD descriptor{};
+    descriptor.fd = socket;
+    descriptor.events = forWrite ? POLLWRNORM : POLLRDNORM;
+    return WSAPoll(&descriptor, 1, timeoutMs) > 0;
+#else
+    pollfd descriptor{socket, static_cast<short>(forWrite ? POLLOUT : POLLIN), 0};
+    int ready;
+    do {
+        ready = ::poll(&descriptor, 1, timeoutMs);
+    } while (ready < 0 && errno == EINTR);
+    return ready > 0;
+#endif
+}
+
+void ExecSession::sendAll(std::string_view data, std::chrono::steady_clock::time_point deadline) {
+    while (!data.empty()) {
+        if (cancelled) throw std::runtime_error("Exec " + execId + " was cancelled");
+
+        size_t sent = 0;
+        CURLcode result;
+        {
+            std::lock_guard lock(ioMutex);
+            result = curl_easy_send(curl, data.data(), data.size(), &sent);
+        }
+        if (result == CURLE_AGAIN) {
+            if (!waitSocket(true, remainingMs(deadline)) && remainingMs(deadline) == 0) {
+                throw std::runtime_error("Timed out writing to exec " + execId);
+            }
+            continue;
+        }
+        if (result != CURLE_OK) {
+            throw std::runtime_error(fmt::format("Failed to write to exec {}: {}", execId, curl_easy_strerror(result)));
+        }
+        data.remove_prefix(sent);
+    }
+}
+
+void ExecSession::readHeaders(std::chrono::steady_clock::time_point deadline) {
+    std::string response;
+    char buffer[4096];
+    size_t headerEnd;
+    while ((headerEnd = response.find("\r\n\r\n")) == std::string::npos) {
+        if (response.size() > MAX_HEADER_BYTES) {
+            throw std::runtime_error("Invalid response to exec start " + execId);
+        }
+        if (!waitSocket(false, remainingMs(deadline)) && remainingMs(deadline) == 0) {
+            throw std::runtime_error("Timed out starting exec " + execId);
+        }
+        size_t received = 0;
+        CURLcode result = curl_easy_recv(curl, buffer, sizeof(buffer), &received);
+        if (result == CURLE_AGAIN) continue;
+        if (result != CURLE_OK || received == 0) {
+            throw std::runtime_error("Connection closed while starting exec " + execId);
+        }
+        response.append(buffer, received);
+    }
+
+    // "HTTP/1.1 101 UPGRADED": 101 once hijacked, 200 from daemons that skip the upgrade
+    long status = 0;
+    const size_t space = response.find(' ');
+    if (space != std::string::npos) status = std::strtol(response.c_str() + space + 1, nullptr, 10);
+    if (status != 101 && status != 200) {
+        throw std::runtime_error(fmt::format("Failed to start exec {} (HTTP {}): {}", execId, status, response.substr(headerEnd + 4)));
+    }
+    early = response.substr(headerEnd + 4);
+}
+
+void ExecSession::write(std::string_view data) {
+    sendAll(data, std::chrono::steady_clock::time_point::max());
+}
+
+void ExecSession::closeStdin() {
+#ifdef _WIN32
+    ::shutdown(socket, SD_SEND);
+#else
+    ::shutdown(socket, SHUT_WR);
+#endif
+}
+
+void ExecSession::cancel() {
+    cancelled = true;
+    // Wakes a pump() blocked in poll
+#ifdef _WIN32
+    ::shutdown(socket, SD_BOTH);
+#else
+    ::shutdown(socket, SHUT_RDWR);
+#endif
+}
+
+bool ExecSession::pump(const OutputCallback &callback, std::chrono::milliseconds timeout) {
+    if (finished) return true;
+    if (!early.empty()) {
+        std::string bytes;
+        bytes.swap(early);
+        demuxer.feed(bytes.data(), bytes.size(), callback);
+    }
+
+    const auto deadline = timeout.count() > 0 ? std::chrono::steady_clock::now() + timeout
+                                              : std::chrono::steady_clock::time_point::max();
+    char buffer[RECEIVE_BUFFER];
+    while (!cancelled) {
+        if (!waitSocket(false, remainingMs(deadline))) {
+            if (remainingMs(deadline) == 0) return false;
+            continue;
+        }
+
+        size_t received = 0;
+        CURLcode result;
+        {
+            std::lock_guard lock(ioMutex);
+            result = curl_easy_recv(curl, buffer, sizeof(buffer), &received);
+        }
+        if (result == CURLE_AGAIN) continue;
+        if (result != CURLE_OK) {
+            if (cancelled) break;
+            throw std::runtime_error(fmt::format("Failed to read from exec {}: {}", execId, curl_easy_strerror(result)));
+        }
+        if (received == 0) {
+            // The daemon closes the connection once the process has exited
+            demuxer.flush(callback);
+            finished = true;
+            return true;
+        }
+        demuxer.feed(buffer, received, callback);
+    }
+    return false;
+}
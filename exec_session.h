@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2025 Nokaji. Tous droits réservés.
+ * Ce fichier fait partie du projet Kernel-James.
+ */
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <curl/curl.h>
+#include "log_demuxer.h"
+
+/*
+ * Hijacked connection of POST /exec/{id}/start: after the 101 response the
+ * HTTP connection becomes a raw full-duplex pipe, stdin goes up, framed
+ * stdout/stderr (raw with Tty) comes down. libcurl only opens the connection
+ * (CONNECT_ONLY); the request is written by hand and the socket is then driven
+ * with non-blocking send/recv, so one thread can write stdin while another
+ * pumps the output. Output chunks are handed out as views into the receive
+ * buffer, demultiplexed by LogDemuxer.
+ */
+class ExecSession
+{
+    public:
+        using OutputCallback = std::function<void(containerTypes::LogStream stream, std::string_view data)>;
+
+    private:
+        CURL *curl = nullptr;
+        curl_socket_t socket = CURL_SOCKET_BAD;
+        std::string execId;
+        LogDemuxer demuxer;
+        std::string early;          // stream bytes received together with the response headers
+        std::mutex ioMutex;         // curl_easy_send/recv on the same handle must not overlap
+        std::atomic<bool> cancelled{false};
+        bool finished = false;
+
+        // Waits until the socket is readable (or writable); false on timeout
+        bool waitSocket(bool forWrite, int timeoutMs) const;
+        void sendAll(std::string_view data, std::chrono::steady_clock::time_point deadline);
+        void readHeaders(std::chrono::steady_clock::time_point deadline);
+
+    public:
+        // Connects and starts the exec; throws if the daemon refuses it
+        ExecSession(const std::string &apiUrl, std::string execId, bool tty,
+                    std::chrono::milliseconds timeout = std::chrono::seconds(30));
+        ~ExecSession();
+
+        ExecSession(const ExecSession &) = delete;
+        ExecSession &operator=(const ExecSession &) = delete;
+
+        // stdin of the process (the exec must be created with attachStdin)
+        void write(std::string_view data);
+
+        // Sends EOF on stdin, output can still be read
+        void closeStdin();
+
+        // Delivers output until the process closes its streams (true) or the
+        // timeout expires (false, 0 = no timeout). Can be called again after a timeout.
+        bool pump(const OutputCallback &callback, std::chrono::milliseconds timeout = std::chrono::milliseconds(0));
+
+        // Unblocks pump() and write() from any thread; the process keeps running
+        void cancel();
+
+        [[nodiscard]] const std::string &getExecId() const { return execId; }
+        [[nodiscard]] bool isFinished() const { return finished; }
+};
@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2025 Nokaji. Tous droits réservés.
+ * Ce fichier fait partie du projet Kernel-James.
+ */
+#include "fleet_exec.h"
+#include "container.h"
+#include "docker.h"
+#include "parallel.h"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <mutex>
+
+FleetExec::FleetExec(std::shared_ptr<DockerClient> client) : dockerClient(std::move(client)) {
+    if (!dockerClient) {
+        throw std::runtime_error("Docker client is not initialized.");
+    }
+}
+
+std::vector<ContainerList> FleetExec::select(const ContainerSelector &selector) const {
+    // ids and labels are filtered by the daemon, names exactly here (the daemon's name filter is a regex)
+    nlohmann::json filters = nlohmann::json::object();
+    if (!selector.ids.empty()) filters["id"] = selector.ids;
+    if (!selector.labels.empty()) filters["label"] = selector.labels;
+
+    ContainerManager containerManager(dockerClient);
+    auto containers = containerManager.list(false, 0, false, filters.empty() ? "" : filters.dump());
+    if (!selector.names.empty()) {
+        containers.erase(std::remove_if(containers.begin(), containers.end(), [&selector](const ContainerList &container) {
+            return std::find(selector.names.begin(), selector.names.end(), container.name) == selector.names.end();
+        }), containers.end());
+    }
+    return containers;
+}
+
+FleetExecSummary FleetExec::run(const ContainerSelector &selector, const std::vector<std::string> &cmd,
+                                const FleetExecOptions &options, const ProgressCallback &progress) {
+    return run(select(selector), cmd, options, progress);
+}
+
+FleetExecSummary FleetExec::run(const std::vector<ContainerList> &containers, const std::vector<std::string> &cmd,
+                                const FleetExecOptions &options, const ProgressCallback &progress) {
+    const auto started = std::chrono::steady_clock::now();
+    FleetExecSummary summary;
+    summary.results.resize(containers.size());
+    std::mutex progressMutex;
+
+    parallelFor(containers.size(), std::max<size_t>(1, options.concurrency), [&](size_t index) {
+        FleetExecResult &result = summary.results[index];
+        result.containerId = containers[index].id;
+        result.containerName = containers[index].name;
+        try {
+            Container container(dockerClient, nlohmann::json{{"Id", result.containerId}, {"Name", result.containerName}});
+            result.exec = container.exec(cmd, options.timeout, options.maxOutputBytes);
+        } catch (const std::exception &e) {
+            result.error = e.what();
+        }
+
+        if (progress) {
+            std::lock_guard lock(progressMutex);
+            progress(result);
+        }
+    });
+
+    for (const auto &result : summary.results) {
+        if (result.exec.timedOut) ++summary.timedOut;
+        else if (result.succeeded()) ++summary.succeeded;
+        else ++summary.failed;
+        summary.slowest = std::max(summary.slowest, result.exec.duration);
+    }
+    summary.duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started);
+    return summary;
+}
@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2025 Nokaji. Tous droits réservés.
+ * Ce fichier fait partie du projet Kernel-James.
+ */
+#pragma once
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "container_manager.h"
+#include "types/container_types.h"
+
+class DockerClient;
+
+// Containers a batch applies to; every non-empty criterion must match. Only running containers are selected.
+struct ContainerSelector {
+    std::vector<std::string> ids;       // full ids or prefixes
+    std::vector<std::string> names;     // exact names, without the leading '/'
+    std::vector<std::string> labels;    // "key" or "key=value"
+};
+
+struct FleetExecOptions {
+    size_t concurrency = 32;
+    std::chrono::milliseconds timeout{30000};   // per container, 0 = none
+    size_t maxOutputBytes = 64 * 1024;          // per container and stream
+};
+
+struct FleetExecResult {
+    std::string containerId;
+    std::string containerName;
+    containerTypes::ExecResult exec;
+    std::string error;                  // set when the exec could not be created or started
+
+    [[nodiscard]] bool succeeded() const { return error.empty() && !exec.timedOut && exec.exitCode == 0; }
+};
+
+struct FleetExecSummary {
+    std::vector<FleetExecResult> results; // in selection order
+    size_t succeeded = 0;
+    size_t failed = 0;                  // non-zero exit code or error
+    size_t timedOut = 0;
+    std::chrono::milliseconds duration{0};
+    std::chrono::milliseconds slowest{0};
+};
+
+/*
+ * Runs one command in many containers at once: up to concurrency execs are in
+ * flight, each with its own deadline and bounded output buffers, and the
+ * results are gathered into a summary.
+ */
+class FleetExec
+{
+    public:
+        // Called once per container as soon as its exec is done, one call at a time
+        using ProgressCallback = std::function<void(const FleetExecResult &result)>;
+
+    private:
+        std::shared_ptr<DockerClient> dockerClient;
+
+    public:
+        explicit FleetExec(std::shared_ptr<DockerClient> client);
+
+        [[nodiscard]] std::vector<ContainerList> select(const ContainerSelector &selector) const;
+
+        FleetExecSummary run(const ContainerSelector &selector, const std::vector<std::string> &cmd,
+                             const FleetExecOptions &options = {}, const ProgressCallback &progress = nullptr);
+
+        // Same on an explicit list of containers
+        FleetExecSummary run(const std::vector<ContainerList> &containers, const std::vector<std::string> &cmd,
+                             const FleetExecOptions &options = {}, const ProgressCallback &progress = nullptr);
+};
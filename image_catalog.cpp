@@ -0,0 +1,348 @@
+/*
+ * Copyright (c) 2025 Nokaji. Tous droits réservés.
+ * Ce fichier fait partie du projet Kernel-James.
+ */
+#include "image_catalog.h"
+#include "docker.h"
+#include "image_manager.h"
+#include "container_manager.h"
+#include "utils/curl.h"
+#include <fmt/format.h>
+#include <algorithm>
+#include <iostream>
+#include <mutex>
+
+namespace {
+    constexpr std::string_view ID_PREFIX = "sha256:";
+
+    bool startsWith(std::string_view text, std::string_view prefix) {
+        return text.substr(0, prefix.size()) == prefix;
+    }
+
+    bool isHex(std::string_view text) {
+        return !text.empty() && std::all_of(text.begin(), text.end(), [](char c) {
+            return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f');
+        });
+    }
+
+    // "docker.io/library/nginx:1" -> "nginx:1", the form the daemon lists tags in
+    std::string familiar(std::string reference) {
+        for (std::string_view registry : {"docker.io/", "index.docker.io/"}) {
+            if (startsWith(reference, registry)) {
+                reference.erase(0, registry.size());
+                break;
+            }
+        }
+        if (startsWith(reference, "library/")) reference.erase(0, 8);
+        return reference;
+    }
+
+    std::string withDefaultTag(const std::string &reference) {
+        const size_t slash = reference.rfind('/');
+        const size_t colon = reference.rfind(':');
+        if (colon != std::string::npos && (slash == std::string::npos || colon > slash)) return reference;
+        return reference + ":latest";
+    }
+
+    std::string attribute(const nlohmann::json &actor, const char *key) {
+        if (!actor.contains("Attributes") || !actor["Attributes"].is_object()) return "";
+        const auto &attributes = actor["Attributes"];
+        return attributes.contains(key) && attributes[key].is_string() ? attributes[key].get<std::string>() : "";
+    }
+
+    std::vector<std::string> stringArray(const nlohmann::json &object, const char *key) {
+        std::vector<std::string> values;
+        if (!object.contains(key) || !object[key].is_array()) return values;
+        for (const auto &value : object[key]) {
+            if (value.is_string()) values.push_back(value.get<std::string>());
+        }
+        return values;
+    }
+
+    template <typename Map>
+    void dropOwned(Map &map, const std::vector<std::string> &keys, const std::string &imageId) {
+        for (const auto &key : keys) {
+            auto it = map.find(key);
+            if (it != map.end() && it->second == imageId) map.erase(it);
+        }
+    }
+}
+
+void ImageCatalog::Index::insertImage(CatalogImage image) {
+    eraseImage(image.id);
+
+    auto isNone = [](const std::string &name) { return startsWith(name, "<none>"); };
+    image.repoTags.erase(std::remove_if(image.repoTags.begin(), image.repoTags.end(), isNone), image.repoTags.end());
+    image.repoDigests.erase(std::remove_if(image.repoDigests.begin(), image.repoDigests.end(), isNone), image.repoDigests.end());
+
+    // A tag or digest names one image: take it from whichever image had it
+    auto claim = [&](std::map<std::string, std::string> &map, const std::string &key,
+                     std::vector<std::string> CatalogImage::*names) {
+        auto [it, inserted] = map.try_emplace(key, image.id);
+        if (inserted) return;
+        auto previous = images.find(it->second);
+        if (previous != images.end()) {
+            auto &list = previous->second.*names;
+            list.erase(std::remove(list.begin(), list.end(), key), list.end());
+        }
+        it->second = image.id;
+    };
+    for (const auto &tag : image.repoTags) claim(byTag, tag, &CatalogImage::repoTags);
+    for (const auto &digest : image.repoDigests) claim(byDigest, digest, &CatalogImage::repoDigests);
+
+    ids.insert(image.id);
+    images[image.id] = std::move(image);
+}
+
+void ImageCatalog::Index::eraseImage(const std::string &imageId) {
+    auto it = images.find(imageId);
+    if (it == images.end()) return;
+
+    dropOwned(byTag, it->second.repoTags, imageId);
+    dropOwned(byDigest, it->second.repoDigests, imageId);
+    ids.erase(imageId);
+    images.erase(it);
+    // Containers keep their image id: a forced delete leaves them running on it
+}
+
+void ImageCatalog::Index::insertContainer(const std::string &containerId, const std::string &imageId) {
+    eraseContainer(containerId);
+    if (imageId.empty()) return;
+    imageByContainer[containerId] = imageId;
+    containersByImage[imageId].insert(containerId);
+}
+
+void ImageCatalog::Index::eraseContainer(const std::string &containerId) {
+    auto it = imageByContainer.find(containerId);
+    if (it == imageByContainer.end()) return;
+
+    auto users = containersByImage.find(it->second);
+    if (users != containersByImage.end()) {
+        users->second.erase(containerId);
+        if (users->second.empty()) containersByImage.erase(users);
+    }
+    imageByContainer.erase(it);
+}
+
+std::string ImageCatalog::Index::resolve(const std::string &reference) const {
+    if (reference.empty()) return "";
+    const std::string name = familiar(reference);
+
+    if (startsWith(name, ID_PREFIX)) {
+        if (ids.count(name)) return name;
+    } else if (name.find('@') != std::string::npos) {
+        auto it = byDigest.find(name);
+        if (it != byDigest.end()) return it->second;
+    } else {
+        auto it = byTag.find(withDefaultTag(name));
+        if (it != byTag.end()) return it->second;
+    }
+
+    // Short id, only if no other image id starts the same way
+    const std::string_view hex = startsWith(name, ID_PREFIX) ? std::string_view(name).substr(ID_PREFIX.size()) : name;
+    if (!isHex(hex)) return "";
+    const std::string key = std::string(ID_PREFIX) + std::string(hex);
+    auto it = ids.lower_bound(key);
+    if (it == ids.end() || !startsWith(*it, key)) return "";
+    auto next = std::next(it);
+    return next == ids.end() || !startsWith(*next, key) ? *it : "";
+}
+
+ImageCatalog::ImageCatalog(std::shared_ptr<DockerClient> client) : dockerClient(client) {
+    if (!this->dockerClient) {
+        throw std::runtime_error("Docker client is not initialized.");
+    }
+}
+
+void ImageCatalog::rebuild() {
+    ImageManager imageManager(dockerClient);
+    ContainerManager containerManager(dockerClient);
+
+    auto images = imageManager.list(false, {}, false, true);
+    auto containers = containerManager.list(true);
+
+    // Build the new index outside the lock, readers keep using the old one meanwhile
+    Index fresh;
+    for (auto &image : images) {
+        CatalogImage entry;
+        entry.id = std::move(image.id);
+        entry.repoTags = std::move(image.repoTags);
+        entry.repoDigests = std::move(image.repoDigests);
+        entry.size = image.size;
+        entry.labels = std::move(image.labels);
+        fresh.insertImage(std::move(entry));
+    }
+    for (const auto &container : containers) {
+        fresh.insertContainer(container.id, container.imageId);
+    }
+
+    std::unique_lock lock(mutex);
+    index = std::move(fresh);
+}
+
+void ImageCatalog::refreshImage(const std::string &reference) {
+    // Not ImageManager::inspect(): a missing image is an answer here, not an error
+    ReqUEST request(fmt::format("{}/images/{}/json", dockerClient->getDockerApiUrl(), reference), std::vector<CurlParameter>{});
+    request.setMethod(method::HttpMethod::_GET);
+    std::shared_ptr<CurlResponse> response = request.execute();
+
+    if (response && response->status_code == 404) {
+        std::unique_lock lock(mutex);
+        const std::string imageId = index.resolve(reference);
+        if (!imageId.empty()) index.eraseImage(imageId);
+        return;
+    }
+    if (!response || response->status_code != 200) {
+        throw std::runtime_error("Failed to refresh image " + reference + ": " + (response ? response->error_message : "no response"));
+    }
+
+    auto inspect = nlohmann::json::parse(response->body, nullptr, false);
+    if (inspect.is_discarded() || !inspect.is_object() || !inspect.contains("Id")) {
+        throw std::runtime_error("Failed to parse image inspect response for " + reference);
+    }
+
+    CatalogImage image;
+    image.id = inspect["Id"].get<std::string>();
+    image.repoTags = stringArray(inspect, "RepoTags");
+    image.repoDigests = stringArray(inspect, "RepoDigests");
+    image.size = inspect.value("Size", int64_t{0});
+    if (inspect.contains("Config") && inspect["Config"].is_object() &&
+        inspect["Config"].contains("Labels") && inspect["Config"]["Labels"].is_object()) {
+        for (const auto &[key, value] : inspect["Config"]["Labels"].items()) {
+            if (value.is_string()) image.labels[key] = value.get<std::string>();
+        }
+    }
+
+    std::unique_lock lock(mutex);
+    index.insertImage(std::move(image));
+}
+
+bool ImageCatalog::applyEvent(const nlohmann::json &event) {
+    if (!event.is_object()) return false;
+
+    const std::string type = event.value("Type", std::string{});
+    const std::string action = event.value("Action", std::string{});
+    if (!event.contains("Actor") || !event["Actor"].is_object()) return false;
+    const auto &actor = event["Actor"];
+    const std::string actorId = actor.value("ID", std::string{});
+    if (actorId.empty()) return false;
+
+    if (type == "image") {
+        if (action == "delete") {
+            std::unique_lock lock(mutex);
+            const std::string imageId = index.resolve(actorId);
+            if (imageId.empty()) return false;
+            index.eraseImage(imageId);
+            return true;
+        }
+        // The event does not say which names changed: read the image back
+        if (action == "pull" || action == "tag" || action == "untag" || action == "load" || action == "import") {
+            try {
+                refreshImage(actorId);
+                return true;
+            } catch (const std::exception &e) {
+                std::cerr << "Failed to refresh image " << actorId << " after " << action << ": " << e.what() << std::endl;
+                return false;
+            }
+        }
+        return false;
+    }
+
+    if (type == "container") {
+        if (action == "create") {
+            const std::string reference = attribute(actor, "image");
+            {
+                std::unique_lock lock(mutex);
+                const std::string imageId = index.resolve(reference);
+                if (!imageId.empty()) {
+                    index.insertContainer(actorId, imageId);
+                    return true;
+                }
+            }
+            // Image pulled or built without us seeing it
+            try {
+                refreshImage(reference);
+            } catch (const std::exception &e) {
+                std::cerr << "Failed to refresh image " << reference << " for container " << actorId << ": " << e.what() << std::endl;
+                return false;
+            }
+            std::unique_lock lock(mutex);
+            const std::string imageId = index.resolve(reference);
+            if (imageId.empty()) return false;
+            index.insertContainer(actorId, imageId);
+            return true;
+        }
+        if (action == "destroy") {
+            std::unique_lock lock(mutex);
+            index.eraseContainer(actorId);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+std::optional<CatalogImage> ImageCatalog::find(const std::string &reference) const {
+    std::shared_lock lock(mutex);
+    const std::string imageId = index.resolve(reference);
+    if (imageId.empty()) return std::nullopt;
+    return index.images.at(imageId);
+}
+
+std::string ImageCatalog::resolveId(const std::string &reference) const {
+    std::shared_lock lock(mutex);
+    return index.resolve(reference);
+}
+
+std::vector<std::string> ImageCatalog::resolveIds(const std::vector<std::string> &references) const {
+    std::vector<std::string> result;
+    result.reserve(references.size());
+    std::shared_lock lock(mutex);
+    for (const auto &reference : references) {
+        result.push_back(index.resolve(reference));
+    }
+    return result;
+}
+
+std::vector<CatalogImage> ImageCatalog::findByPrefix(const std::string &prefix, size_t limit) const {
+    std::shared_lock lock(mutex);
+    std::vector<CatalogImage> result;
+    std::unordered_set<std::string> seen;
+    auto add = [&](const std::string &imageId) {
+        if (limit > 0 && result.size() >= limit) return false;
+        if (seen.insert(imageId).second) result.push_back(index.images.at(imageId));
+        return true;
+    };
+
+    const std::string name = familiar(prefix);
+    const std::string idKey = startsWith(name, ID_PREFIX) || !isHex(name) ? name : std::string(ID_PREFIX) + name;
+    for (auto it = index.ids.lower_bound(idKey); it != index.ids.end() && startsWith(*it, idKey); ++it) {
+        if (!add(*it)) return result;
+    }
+    for (const auto *map : {&index.byTag, &index.byDigest}) {
+        for (auto it = map->lower_bound(name); it != map->end() && startsWith(it->first, name); ++it) {
+            if (!add(it->second)) return result;
+        }
+    }
+    return result;
+}
+
+std::vector<std::string> ImageCatalog::containersOf(const std::string &reference) const {
+    std::shared_lock lock(mutex);
+    // Containers can outlive their image (forced delete): a bare id is looked up as is
+    const std::string imageId = index.resolve(reference);
+    auto it = index.containersByImage.find(imageId.empty() ? reference : imageId);
+    if (it == index.containersByImage.end()) return {};
+    return {it->second.begin(), it->second.end()};
+}
+
+std::string ImageCatalog::imageOf(const std::string &containerId) const {
+    std::shared_lock lock(mutex);
+    auto it = index.imageByContainer.find(containerId);
+    return it != index.imageByContainer.end() ? it->second : "";
+}
+
+size_t ImageCatalog::size() const {
+    std::shared_lock lock(mutex);
+    return index.images.size();
+}
@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2025 Nokaji. Tous droits réservés.
+ * Ce fichier fait partie du projet Kernel-James.
+ */
+#pragma once
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <optional>
+#include <set>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+// Forward declaration
+class DockerClient;
+
+struct CatalogImage {
+    std::string id;                         // "sha256:..."
+    std::vector<std::string> repoTags;      // "nginx:latest", no "<none>" entries
+    std::vector<std::string> repoDigests;   // "nginx@sha256:..."
+    int64_t size = 0;
+    std::map<std::string, std::string> labels;
+};
+
+/*
+ * Local images indexed by id, tag and digest, with the containers using each.
+ * Built from one image listing and one container listing, then kept up to date
+ * through refreshImage() and the daemon events passed to applyEvent().
+ * Ids, tags and digests are kept sorted, so exact lookups and prefix searches
+ * are logarithmic; safe to call from any thread.
+ *
+ * References are taken in any of the forms Docker accepts: full or short id,
+ * "name[:tag]" (":latest" implied), "name@digest", with or without the
+ * "docker.io/library/" prefix of official images.
+ */
+class ImageCatalog
+{
+    private:
+        std::shared_ptr<DockerClient> dockerClient;
+
+        struct Index {
+            std::unordered_map<std::string, CatalogImage> images;  // by id
+            std::set<std::string> ids;
+            std::map<std::string, std::string> byTag;               // tag -> id
+            std::map<std::string, std::string> byDigest;            // name@digest -> id
+
+            std::unordered_map<std::string, std::unordered_set<std::string>> containersByImage;
+            std::unordered_map<std::string, std::string> imageByContainer;
+
+            void insertImage(CatalogImage image);
+            void eraseImage(const std::string &imageId);
+            void insertContainer(const std::string &containerId, const std::string &imageId);
+            void eraseContainer(const std::string &containerId);
+
+            // Image id for a reference, empty if unknown or an ambiguous short id
+            [[nodiscard]] std::string resolve(const std::string &reference) const;
+        };
+
+        mutable std::shared_mutex mutex;
+        Index index;
+
+    public:
+        explicit ImageCatalog(std::shared_ptr<DockerClient> client);
+
+        // Full rebuild: one image listing and one container listing
+        void rebuild();
+
+        // Re-inspect a single image and replace its entry; the entry is dropped if the
+        // image no longer exists
+        void refreshImage(const std::string &reference);
+
+        // Apply one decoded /events message; returns true if the index changed
+        bool applyEvent(const nlohmann::json &event);
+
+        [[nodiscard]] std::optional<CatalogImage> find(const std::string &reference) const;
+        [[nodiscard]] std::string resolveId(const std::string &reference) const;
+        [[nodiscard]] bool contains(const std::string &reference) const { return !resolveId(reference).empty(); }
+
+        // Resolves many references under one lock; unknown ones map to ""
+        [[nodiscard]] std::vector<std::string> resolveIds(const std::vector<std::string> &references) const;
+
+        // Images with an id, tag or digest starting with prefix, each once (limit 0 = all)
+        [[nodiscard]] std::vector<CatalogImage> findByPrefix(const std::string &prefix, size_t limit = 0) const;
+
+        // Containers (running or not) created from the image
+        [[nodiscard]] std::vector<std::string> containersOf(const std::string &reference) const;
+        [[nodiscard]] std::string imageOf(const std::string &containerId) const;
+
+        [[nodiscard]] size_t size() const;
+};
@@ -0,0 +1,252 @@
+/*
+ * Copyright (c) 2025 Nokaji. Tous droits réservés.
+ * Ce fichier fait partie du projet Kernel-James.
+ */
+#include "image_gc.h"
+#include "container_manager.h"
+#include "docker.h"
+#include "image_manager.h"
+#include "log_demuxer.h"
+#include "parallel.h"
+#include <algorithm>
+#include <functional>
+#include <set>
+#include <unordered_map>
+
+namespace {
+    int64_t nowSeconds() {
+        return std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    uint64_t chainOf(uint64_t parent, const std::string &diffId) {
+        const uint64_t layer = std::hash<std::string>{}(diffId);
+        return layer ^ (parent + 0x9e3779b97f4a7c15ULL + (parent << 6) + (parent >> 2));
+    }
+
+    std::vector<std::string> realTags(const std::vector<std::string> &repoTags) {
+        std::vector<std::string> tags;
+        for (const auto &tag : repoTags) {
+            if (tag != "<none>:<none>") tags.push_back(tag);
+        }
+        return tags;
+    }
+}
+
+ImageGC::ImageGC(std::shared_ptr<DockerClient> client, ImageGcOptions gcOptions)
+    : dockerClient(std::move(client)), options(std::move(gcOptions)) {
+    if (!dockerClient) {
+        throw std::runtime_error("Docker client is not initialized.");
+    }
+}
+
+void ImageGC::recordUse(const std::string &imageId, int64_t timestamp) {
+    if (timestamp == 0) timestamp = nowSeconds();
+    std::lock_guard lock(mutex);
+    int64_t &last = lastUsed[imageId];
+    last = std::max(last, timestamp);
+}
+
+bool ImageGC::isKept(const std::vector<std::string> &repoTags) const {
+    for (const auto &tag : repoTags) {
+        const std::string repository = tag.substr(0, tag.rfind(':'));
+        for (const auto &pattern : options.keep) {
+            if (pattern == tag || pattern == repository) return true;
+        }
+    }
+    return false;
+}
+
+ImageGC::LayerInfo ImageGC::loadLayers(const std::string &imageId) const {
+    ImageManager images(dockerClient);
+    LayerInfo info;
+    try {
+        const auto inspect = images.inspect(imageId);
+        // Zero time ("0001-01-01T00:00:00Z") when the image was never tagged on this daemon
+        if (inspect.contains("Metadata") && inspect["Metadata"].is_object() && inspect["Metadata"].contains("LastTagTime") &&
+            inspect["Metadata"]["LastTagTime"].is_string()) {
+            const auto tagTime = inspect["Metadata"]["LastTagTime"].get<std::string>();
+            if (!tagTime.starts_with("0001-")) info.lastTagTime = parseLogTimestamp(tagTime) / 1000000000;
+        }
+        const auto history = images.history(imageId);
+        if (!inspect.contains("RootFS") || !inspect["RootFS"].contains("Layers") || !history.is_array()) return info;
+        const auto &diffIds = inspect["RootFS"]["Layers"];
+
+        // History is newest first; only entries that created a layer have a size, and a
+        // layer of 0 bytes is indistinguishable from an empty step
+        std::vector<int64_t> all;
+        std::vector<int64_t> nonEmpty;
+        for (auto entry = history.rbegin(); entry != history.rend(); ++entry) {
+            const int64_t size = entry->value("Size", int64_t{0});
+            all.push_back(size);
+            if (size > 0) nonEmpty.push_back(size);
+        }
+        const std::vector<int64_t> *sizes = all.size() == diffIds.size() ? &all
+                                          : nonEmpty.size() == diffIds.size() ? &nonEmpty : nullptr;
+        if (!sizes) return info;
+
+        uint64_t chain = 0;
+        for (size_t i = 0; i < diffIds.size(); ++i) {
+            chain = chainOf(chain, diffIds[i].get<std::string>());
+            info.layers.push_back({chain, (*sizes)[i]});
+        }
+        info.known = true;
+    } catch (const std::exception &) {
+        // Image removed meanwhile or unreadable: accounted from list() sizes
+    }
+    return info;
+}
+
+ImageGcPlan ImageGC::plan() {
+    ImageManager imageManager(dockerClient);
+    ContainerManager containerManager(dockerClient);
+    const auto images = imageManager.list(false, {}, true);
+    const auto containers = containerManager.list(true);
+    const int64_t now = nowSeconds();
+
+    // Any container, even stopped, pins its image
+    std::set<std::string> referenced;
+    for (const auto &container : containers) {
+        referenced.insert(container.imageId);
+        recordUse(container.imageId, container.state == containerTypes::ContainerStatus::RUNNING ? now : container.created);
+    }
+
+    std::vector<std::string> missing;
+    {
+        std::lock_guard lock(mutex);
+        for (const auto &image : images) {
+            if (!layerCache.count(image.id)) missing.push_back(image.id);
+        }
+    }
+    std::vector<LayerInfo> loaded(missing.size());
+    parallelFor(missing.size(), options.concurrency, [&](size_t index) {
+        loaded[index] = loadLayers(missing[index]);
+    });
+
+    std::lock_guard lock(mutex);
+    for (size_t i = 0; i < missing.size(); ++i) {
+        layerCache[missing[i]] = std::move(loaded[i]);
+    }
+    // Forget images that no longer exist
+    std::set<std::string> present;
+    for (const auto &image : images) present.insert(image.id);
+    for (auto it = layerCache.begin(); it != layerCache.end();) {
+        it = present.count(it->first) ? std::next(it) : layerCache.erase(it);
+    }
+
+    // Disk usage: every layer once, plus what list() reports as unique for opaque images
+    std::unordered_map<uint64_t, std::pair<int64_t, size_t>> layers; // chain -> size, images using it
+    int64_t usage = 0;
+    auto uniqueSize = [](const imageTypes::ImageConfig &image) {
+        return image.size - std::max<int64_t>(image.sharedSize, 0);
+    };
+    for (const auto &image : images) {
+        const LayerInfo &info = layerCache[image.id];
+        if (!info.known) {
+            usage += uniqueSize(image);
+            continue;
+        }
+        for (const auto &layer : info.layers) {
+            auto [entry, inserted] = layers.try_emplace(layer.chain, layer.size, 0);
+            if (inserted) usage += layer.size;
+            ++entry->second.second;
+        }
+    }
+
+    ImageGcPlan result;
+    result.usageBytes = static_cast<uint64_t>(std::max<int64_t>(usage, 0));
+    result.budgetBytes = options.budgetBytes;
+
+    std::vector<ImageGcEntry> candidates;
+    for (const auto &image : images) {
+        const auto tags = realTags(image.repoTags);
+        if (referenced.count(image.id) || isKept(tags)) continue;
+        // An old build pulled a minute ago is about to be used: age counts from the pull
+        const int64_t pulled = std::max<int64_t>(image.created, layerCache[image.id].lastTagTime);
+        if (now - pulled < options.minAge.count()) continue;
+
+        ImageGcEntry entry;
+        entry.id = image.id;
+        entry.repoTags = tags;
+        entry.size = image.size;
+        auto used = lastUsed.find(image.id);
+        entry.lastUsed = used != lastUsed.end() ? std::max<int64_t>(used->second, pulled) : pulled;
+        candidates.push_back(std::move(entry));
+    }
+    std::sort(candidates.begin(), candidates.end(), [](const ImageGcEntry &a, const ImageGcEntry &b) {
+        return a.lastUsed != b.lastUsed ? a.lastUsed < b.lastUsed : a.id < b.id;
+    });
+
+    std::unordered_map<std::string, const imageTypes::ImageConfig *> byId;
+    for (const auto &image : images) byId.emplace(image.id, &image);
+
+    for (auto &candidate : candidates) {
+        if (static_cast<uint64_t>(std::max<int64_t>(usage, 0)) <= options.budgetBytes) break;
+
+        const LayerInfo &info = layerCache[candidate.id];
+        if (info.known) {
+            // Only layers no remaining image uses come off the disk
+            for (const auto &layer : info.layers) {
+                auto &[size, users] = layers[layer.chain];
+                if (--users == 0) candidate.freedBytes += size;
+            }
+        } else {
+            candidate.freedBytes = uniqueSize(*byId[candidate.id]);
+        }
+        usage -= candidate.freedBytes;
+        result.evictions.push_back(std::move(candidate));
+    }
+    result.projectedBytes = static_cast<uint64_t>(std::max<int64_t>(usage, 0));
+    return result;
+}
+
+ImageGcResult ImageGC::collect(const ImageGcPlan &plan) {
+    ImageGcResult result;
+
+    auto removeAll = [&](const std::vector<const ImageGcEntry *> &entries) {
+        std::vector<std::string> errors(entries.size());
+        parallelFor(entries.size(), options.concurrency, [&](size_t index) {
+            const ImageGcEntry &entry = *entries[index];
+            ImageManager images(dockerClient);
+            try {
+                // Deleting an id with several tags needs force; untagging removes the image with its last tag
+                if (entry.repoTags.empty()) {
+                    images.remove(entry.id);
+                } else {
+                    for (const auto &tag : entry.repoTags) images.remove(tag);
+                }
+            } catch (const std::exception &e) {
+                errors[index] = e.what();
+            }
+        });
+
+        std::vector<const ImageGcEntry *> failed;
+        for (size_t i = 0; i < entries.size(); ++i) {
+            if (errors[i].empty()) {
+                result.removed.push_back(entries[i]->id);
+                result.freedBytes += static_cast<uint64_t>(std::max<int64_t>(entries[i]->freedBytes, 0));
+            } else {
+                result.failed[entries[i]->id] = errors[i];
+                failed.push_back(entries[i]);
+            }
+        }
+        return failed;
+    };
+
+    std::vector<const ImageGcEntry *> entries;
+    entries.reserve(plan.evictions.size());
+    for (const auto &entry : plan.evictions) entries.push_back(&entry);
+
+    // A parent deleted alongside its child can fail first: one more pass once the children are gone
+    auto failed = removeAll(entries);
+    if (!failed.empty() && failed.size() < entries.size()) {
+        for (const auto *entry : failed) result.failed.erase(entry->id);
+        removeAll(failed);
+    }
+
+    std::lock_guard lock(mutex);
+    for (const auto &id : result.removed) {
+        layerCache.erase(id);
+        lastUsed.erase(id);
+    }
+    return result;
+}
@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2025 Nokaji. Tous droits réservés.
+ * Ce fichier fait partie du projet Kernel-James.
+ */
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class DockerClient;
+
+struct ImageGcOptions {
+    uint64_t budgetBytes = 0;               // images are evicted until their disk usage fits
+    std::vector<std::string> keep;          // never evicted: "repo:tag", or "repo" for all its tags
+    std::chrono::seconds minAge{3600};      // images pulled more recently are left alone
+    size_t concurrency = 8;                 // inspections and deletions in flight
+};
+
+struct ImageGcEntry {
+    std::string id;
+    std::vector<std::string> repoTags;
+    int64_t lastUsed = 0;                   // unix seconds: last container seen using it, else pull (or creation)
+    int64_t size = 0;                       // with the layers it shares
+    int64_t freedBytes = 0;                 // disk actually released, given the evictions before it
+};
+
+struct ImageGcPlan {
+    uint64_t usageBytes = 0;                // all images, each layer counted once
+    uint64_t projectedBytes = 0;            // after the evictions
+    uint64_t budgetBytes = 0;
+    std::vector<ImageGcEntry> evictions;    // in eviction order
+};
+
+struct ImageGcResult {
+    std::vector<std::string> removed;
+    std::map<std::string, std::string> failed;  // image id -> error
+    uint64_t freedBytes = 0;
+};
+
+/*
+ * Size-budgeted image garbage collector. Usage is computed per layer (from
+ * each image's rootfs and history, cached by image id since images are
+ * immutable), so evicting an image only counts the layers no remaining image
+ * uses. Images used by any container are kept; the others go least recently
+ * used first, "used" meaning the latest time a container was seen on them by
+ * this collector, or the time the image was pulled or tagged on this daemon
+ * (its build time when the daemon does not say) before that. Images whose layer sizes
+ * cannot be matched fall back to size - sharedSize.
+ */
+class ImageGC
+{
+    private:
+        struct Layer {
+            uint64_t chain;                 // identifies the layer with its parents, as on disk
+            int64_t size;
+        };
+        struct LayerInfo {
+            bool known = false;
+            std::vector<Layer> layers;
+            int64_t lastTagTime = 0;        // unix seconds, Metadata.LastTagTime: pulled, loaded or tagged here
+        };
+
+        std::shared_ptr<DockerClient> dockerClient;
+        ImageGcOptions options;
+
+        std::mutex mutex;
+        std::map<std::string, LayerInfo> layerCache;
+        std::map<std::string, int64_t> lastUsed;
+
+        LayerInfo loadLayers(const std::string &imageId) const;
+        [[nodiscard]] bool isKept(const std::vector<std::string> &repoTags) const;
+
+    public:
+        ImageGC(std::shared_ptr<DockerClient> client, ImageGcOptions options);
+
+        // Records a use the collector cannot see through containers (unix seconds, 0 = now)
+        void recordUse(const std::string &imageId, int64_t timestamp = 0);
+
+        // What collect() would remove; nothing is deleted (dry run)
+        ImageGcPlan plan();
+
+        // Deletes the planned images in parallel. Images that fail because a child
+        // image was still present are retried once after the others.
+        ImageGcResult collect(const ImageGcPlan &plan);
+
+        ImageGcResult run() { return collect(plan()); }
+};
@@ -4,12 +4,15 @@
  */
 #pragma once
 #include "types/image_types.h"
+#include <functional>
+#include <memory>
 #include <string>
 #include <map>
 #include <vector>
 #include <nlohmann/json.hpp>
 
 class DockerClient;
+class BuildContext;
 
 class ImageManager
 {
@@ -17,13 +20,18 @@ class ImageManager
         std::shared_ptr<DockerClient> dockerClient;
 
     public:
+        using TransferCallback = std::function<void(const imageTypes::TransferProgress& progress)>;
+        using PullCallback = std::function<void(const imageTypes::PullEvent& event, const imageTypes::PullProgress& progress)>;
+        using BuildCallback = std::function<void(const imageTypes::BuildEvent& event)>;
+
         explicit ImageManager(std::shared_ptr<DockerClient> dockerClient);
 
         std::vector<imageTypes::ImageConfig> list(bool all = false, std::map<std::string, std::string> filters = {}, bool sharedSize = false, bool digests = false, bool manifests = false);
 
         bool exists(const std::string& name);
 
-        // Pull or import an image
+        // Pull or import an image. Progress messages are decoded as they arrive and handed
+        // to progress with the running totals; returns the final status line.
         std::string pull(const std::string& fromImage, 
                         const std::string& fromSrc = "", 
                         const std::string& repo = "",
@@ -31,12 +39,14 @@ class ImageManager
                         const std::string& message = "",
                         const std::vector<std::string>& changes = {},
                         const std::string& platform = "",
-                        const std::string& registryAuth = "");
+                        const std::string& registryAuth = "",
+                        const PullCallback& progress = nullptr);
                         
         // Download an image if it does not exist
         std::string download(const std::string& name, 
                              const std::string& tag = "latest",
-                             const std::string& registryAuth = "");
+                             const std::string& registryAuth = "",
+                             const PullCallback& progress = nullptr);
 
         // Remove an image
         void remove(const std::string& name, bool force = false, bool noprune = false);
@@ -45,5 +55,23 @@ class ImageManager
         nlohmann::json inspect(const std::string& name);
         nlohmann::json history(const std::string& name);
 
+        // Export images (with their tags) into one tarball at path, streamed to disk as it
+        // arrives; the file only appears once complete. Returns the bytes written.
+        uint64_t save(const std::vector<std::string>& names, const std::string& path,
+                      const TransferCallback& progress = nullptr);
+
+        // Import a tarball made by save or docker save, streamed from disk. It may be
+        // gzip, bzip2 or xz compressed: the daemon decompresses it. Returns the loaded images.
+        std::vector<std::string> load(const std::string& path, const TransferCallback& progress = nullptr);
+
+        // Build an image from a context directory, honouring its .dockerignore. The context
+        // is packed while it uploads, never staged in memory or on disk. Returns the image id.
+        std::string build(const std::string& contextDirectory, const imageTypes::BuildOptions& options = {},
+                          const BuildCallback& callback = nullptr);
+
+        // Same with an already scanned context, e.g. after comparing its fingerprint
+        std::string build(const BuildContext& context, const imageTypes::BuildOptions& options = {},
+                          const BuildCallback& callback = nullptr);
+
         ~ImageManager() = default;
 };
\ No newline at end of file
@@ -0,0 +1,270 @@
+/*
+ * Copyright (c) 2025 Nokaji. Tous droits réservés.
+ * Ce fichier fait partie du projet Kernel-James.
+ */
+#include "log_demuxer.h"
+#include <algorithm>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace {
+    inline unsigned lowestBit(uint64_t mask) {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward64(&index, mask);
+        return static_cast<unsigned>(index);
+#else
+        return static_cast<unsigned>(__builtin_ctzll(mask));
+#endif
+    }
+
+    // Bit i set when block[i] == '\n'
+    inline uint64_t newlineMask64(const char *block) {
+#if defined(__AVX2__)
+        const __m256i newline = _mm256_set1_epi8('\n');
+        uint32_t low = static_cast<uint32_t>(_mm256_movemask_epi8(
+                _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(block)), newline)));
+        uint32_t high = static_cast<uint32_t>(_mm256_movemask_epi8(
+                _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(block + 32)), newline)));
+        return uint64_t(low) | (uint64_t(high) << 32);
+#elif defined(__SSE2__) || defined(_M_X64)
+        const __m128i newline = _mm_set1_epi8('\n');
+        uint64_t mask = 0;
+        for (int i = 0; i < 4; ++i) {
+            __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block + 16 * i));
+            mask |= uint64_t(static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline)))) << (16 * i);
+        }
+        return mask;
+#else
+        // SWAR fallback: 8 bytes per step
+        uint64_t mask = 0;
+        for (int i = 0; i < 8; ++i) {
+            uint64_t word;
+            std::memcpy(&word, block + 8 * i, sizeof(word));
+            word ^= 0x0A0A0A0A0A0A0A0AULL;
+            uint64_t zero = (word - 0x0101010101010101ULL) & ~word & 0x8080808080808080ULL;
+            while (zero) {
+                unsigned byte = lowestBit(zero) / 8;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+                byte = 7 - byte;
+#endif
+                if (block[8 * i + byte] == '\n') mask |= uint64_t(1) << (8 * i + byte);
+                zero &= zero - 1;
+            }
+        }
+        return mask;
+#endif
+    }
+
+    // Calls onNewline(pointer to '\n') for every newline, in order
+    template <typename F>
+    inline void forEachNewline(const char *data, size_t size, F &&onNewline) {
+        const char *p = data;
+        const char *end = data + size;
+        while (end - p >= 64) {
+            uint64_t mask = newlineMask64(p);
+            while (mask) {
+                onNewline(p + lowestBit(mask));
+                mask &= mask - 1;
+            }
+            p += 64;
+        }
+        while (p < end) {
+            const char *newline = static_cast<const char *>(std::memchr(p, '\n', end - p));
+            if (!newline) return;
+            onNewline(newline);
+            p = newline + 1;
+        }
+    }
+}
+
+const char *logStreamPrefix(containerTypes::LogStream stream) {
+    switch (stream) {
+        case containerTypes::LogStream::STDIN: return "[STDIN] ";
+        case containerTypes::LogStream::STDOUT: return "[STDOUT] ";
+        case containerTypes::LogStream::STDERR: return "[STDERR] ";
+        default: return "[UNKNOWN] ";
+    }
+}
+
+namespace {
+    bool readDigits(std::string_view text, size_t position, size_t count, int64_t &value) {
+        if (position + count > text.size()) return false;
+        value = 0;
+        for (size_t i = position; i < position + count; ++i) {
+            if (text[i] < '0' || text[i] > '9') return false;
+            value = value * 10 + (text[i] - '0');
+        }
+        return true;
+    }
+
+    // Days since 1970-01-01 for a proleptic Gregorian date (H. Hinnant's algorithm)
+    int64_t daysFromCivil(int64_t year, int64_t month, int64_t day) {
+        year -= month <= 2;
+        const int64_t era = (year >= 0 ? year : year - 399) / 400;
+        const int64_t yearOfEra = year - era * 400;
+        const int64_t dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+        const int64_t dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+        return era * 146097 + dayOfEra - 719468;
+    }
+}
+
+int64_t parseLogTimestamp(std::string_view line, std::string_view *message) {
+    int64_t year, month, day, hour, minute, second;
+    if (line.size() < 20 || line[4] != '-' || line[7] != '-' || line[10] != 'T' || line[13] != ':' || line[16] != ':' ||
+        !readDigits(line, 0, 4, year) || !readDigits(line, 5, 2, month) || !readDigits(line, 8, 2, day) ||
+        !readDigits(line, 11, 2, hour) || !readDigits(line, 14, 2, minute) || !readDigits(line, 17, 2, second)) {
+        return 0;
+    }
+
+    size_t position = 19;
+    int64_t nanoseconds = 0;
+    if (position < line.size() && line[position] == '.') {
+        ++position;
+        int64_t scale = 100000000;
+        while (position < line.size() && line[position] >= '0' && line[position] <= '9') {
+            nanoseconds += (line[position] - '0') * scale;
+            scale /= 10;
+            ++position;
+        }
+    }
+
+    int64_t offsetSeconds = 0;
+    if (position < line.size() && line[position] == 'Z') {
+        ++position;
+    } else if (position < line.size() && (line[position] == '+' || line[position] == '-')) {
+        int64_t offsetHours, offsetMinutes;
+        if (!readDigits(line, position + 1, 2, offsetHours) || position + 3 >= line.size() || line[position + 3] != ':' ||
+            !readDigits(line, position + 4, 2, offsetMinutes)) {
+            return 0;
+        }
+        offsetSeconds = (offsetHours * 3600 + offsetMinutes * 60) * (line[position] == '+' ? 1 : -1);
+        position += 6;
+    } else {
+        return 0;
+    }
+
+    if (message) {
+        *message = line.substr(position < line.size() && line[position] == ' ' ? position + 1 : position);
+    }
+
+    const int64_t seconds = daysFromCivil(year, month, day) * 86400 + hour * 3600 + minute * 60 + second - offsetSeconds;
+    return seconds * 1000000000 + nanoseconds;
+}
+
+size_t splitLines(const char *data, size_t size, const std::function<void(std::string_view line)> &onLine) {
+    const char *lineStart = data;
+    forEachNewline(data, size, [&](const char *newline) {
+        onLine(std::string_view(lineStart, newline - lineStart));
+        lineStart = newline + 1;
+    });
+    return static_cast<size_t>(lineStart - data);
+}
+
+void LogDemuxer::emitLines(containerTypes::LogStream stream, const char *data, size_t size, const LineCallback &callback) {
+    if (!lineMode) {
+        if (size > 0) callback(stream, std::string_view(data, size));
+        return;
+    }
+
+    std::string &carry = partial[static_cast<size_t>(stream)];
+    const char *lineStart = data;
+
+    forEachNewline(data, size, [&](const char *newline) {
+        if (carry.empty()) {
+            callback(stream, std::string_view(lineStart, newline - lineStart));
+        } else {
+            // Line started in an earlier chunk or frame
+            carry.append(lineStart, newline - lineStart);
+            callback(stream, carry);
+            carry.clear();
+        }
+        lineStart = newline + 1;
+    });
+
+    carry.append(lineStart, data + size - lineStart);
+}
+
+void LogDemuxer::feedFramed(const char *data, size_t size, const LineCallback &callback) {
+    while (size > 0) {
+        if (payloadLeft == 0) {
+            size_t take = std::min(size, header.size() - headerFill);
+            std::memcpy(header.data() + headerFill, data, take);
+            headerFill += take;
+            data += take;
+            size -= take;
+            if (headerFill < header.size()) return;
+
+            // Byte 0: stream, bytes 1-3: padding, bytes 4-7: payload size (big-endian)
+            current = header[0] <= 2 ? static_cast<containerTypes::LogStream>(header[0]) : containerTypes::LogStream::STDOUT;
+            payloadLeft = (uint32_t(header[4]) << 24) | (uint32_t(header[5]) << 16) |
+                          (uint32_t(header[6]) << 8) | uint32_t(header[7]);
+            headerFill = 0;
+            continue;
+        }
+
+        size_t take = std::min<size_t>(size, payloadLeft);
+        emitLines(current, data, take, callback);
+        payloadLeft -= static_cast<uint32_t>(take);
+        data += take;
+        size -= take;
+    }
+}
+
+void LogDemuxer::feed(const char *data, size_t size, const LineCallback &callback) {
+    if (mode == Mode::Auto) {
+        // Buffer the first 8 bytes to tell a frame header from raw text
+        size_t take = std::min(size, header.size() - headerFill);
+        std::memcpy(header.data() + headerFill, data, take);
+        headerFill += take;
+        data += take;
+        size -= take;
+        if (headerFill < header.size()) return;
+
+        const bool framed = header[0] <= 2 && header[1] == 0 && header[2] == 0 && header[3] == 0;
+        mode = framed ? Mode::Framed : Mode::Raw;
+        std::array<unsigned char, 8> first = header;
+        headerFill = 0;
+        if (framed) {
+            feedFramed(reinterpret_cast<const char *>(first.data()), first.size(), callback);
+        } else {
+            emitLines(containerTypes::LogStream::STDOUT, reinterpret_cast<const char *>(first.data()), first.size(), callback);
+        }
+    }
+
+    if (mode == Mode::Raw) {
+        emitLines(containerTypes::LogStream::STDOUT, data, size, callback);
+    } else {
+        feedFramed(data, size, callback);
+    }
+}
+
+void LogDemuxer::flush(const LineCallback &callback) {
+    if (mode == Mode::Auto && headerFill > 0) {
+        // Fewer than 8 bytes in the whole stream: only raw text can be that short
+        partial[static_cast<size_t>(containerTypes::LogStream::STDOUT)].append(reinterpret_cast<const char *>(header.data()), headerFill);
+        headerFill = 0;
+    }
+    for (size_t stream = 0; stream < partial.size(); ++stream) {
+        if (partial[stream].empty()) continue;
+        callback(static_cast<containerTypes::LogStream>(stream), partial[stream]);
+        partial[stream].clear();
+    }
+}
+
+void LogDemuxer::reset() {
+    mode = initialMode;
+    headerFill = 0;
+    payloadLeft = 0;
+    current = containerTypes::LogStream::STDOUT;
+    for (auto &carry : partial) carry.clear();
+}
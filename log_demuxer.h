@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2025 Nokaji. Tous droits réservés.
+ * Ce fichier fait partie du projet Kernel-James.
+ */
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include "types/container_types.h"
+
+/*
+ * Incremental decoder for /containers/{id}/logs and attach streams.
+ * Chunks may split a frame header, a payload or a line anywhere: the state is
+ * kept between feed() calls. Raw streams (containers created with Tty) have no
+ * frame headers and every line is reported as STDOUT; Auto decides from the
+ * first 8 bytes. Lines are located 64 bytes at a time with SIMD compares and
+ * handed out as views into the chunk, only lines spanning two chunks are copied.
+ */
+class LogDemuxer
+{
+    public:
+        enum class Mode {
+            Framed,
+            Raw,
+            Auto
+        };
+
+        using LineCallback = std::function<void(containerTypes::LogStream stream, std::string_view line)>;
+
+    private:
+        Mode initialMode;
+        Mode mode;
+        std::array<unsigned char, 8> header{};
+        size_t headerFill = 0;
+        uint32_t payloadLeft = 0;
+        containerTypes::LogStream current = containerTypes::LogStream::STDOUT;
+        std::array<std::string, 3> partial; // stdin, stdout, stderr
+        bool lineMode = true;
+
+        void emitLines(containerTypes::LogStream stream, const char *data, size_t size, const LineCallback &callback);
+        void feedFramed(const char *data, size_t size, const LineCallback &callback);
+
+    public:
+        explicit LogDemuxer(Mode mode = Mode::Framed) : initialMode(mode), mode(mode) {}
+        explicit LogDemuxer(bool raw) : LogDemuxer(raw ? Mode::Raw : Mode::Framed) {}
+
+        // Lines are reported without their trailing '\n'; the view is only valid during the callback
+        void feed(const char *data, size_t size, const LineCallback &callback);
+
+        // Report lines left without a trailing newline at end of stream
+        void flush(const LineCallback &callback);
+
+        void reset();
+
+        // Report payload bytes as they arrive instead of whole lines (exec sessions, binary output)
+        LogDemuxer &passChunks(bool enabled = true) { lineMode = !enabled; return *this; }
+
+        [[nodiscard]] bool isRaw() const { return mode == Mode::Raw; }
+        [[nodiscard]] Mode getMode() const { return mode; }
+};
+
+const char *logStreamPrefix(containerTypes::LogStream stream);
+
+// Calls onLine for every '\n'-terminated line of [data, data + size) and returns
+// the number of bytes consumed (everything up to and including the last '\n')
+size_t splitLines(const char *data, size_t size, const std::function<void(std::string_view line)> &onLine);
+
+// Splits the RFC 3339 timestamp the daemon prepends with timestamps=1
+// ("2024-05-01T12:00:00.123456789Z message"). Returns nanoseconds since epoch
+// and sets message to the rest of the line, or returns 0 if there is no timestamp.
+int64_t parseLogTimestamp(std::string_view line, std::string_view *message = nullptr);
@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2025 Nokaji. Tous droits réservés.
+ * Ce fichier fait partie du projet Kernel-James.
+ */
+#include "log_follower.h"
+#include "log_demuxer.h"
+#include <utility>
+
+LogFollower::LogFollower(const std::string &url, bool tty, LineCallback callback, int maxDuration, size_t maxBufferedBytes)
+    : stream(url), callback(std::move(callback)), tty(tty), maxBufferedBytes(maxBufferedBytes) {
+    if (maxDuration > 0) {
+        stream.setMaxDuration(std::chrono::seconds(maxDuration));
+    }
+    dispatcher = std::thread(&LogFollower::dispatchLoop, this);
+    reader = std::thread(&LogFollower::readLoop, this);
+}
+
+LogFollower::~LogFollower() {
+    cancel();
+    join();
+}
+
+void LogFollower::push(std::deque<std::string> &lines) {
+    if (lines.empty()) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto &line : lines) {
+            pendingBytes += line.size();
+            pending.push_back(std::move(line));
+        }
+    }
+    lines.clear();
+    cv.notify_one();
+}
+
+void LogFollower::readLoop() {
+    LogDemuxer demuxer(tty);
+    std::deque<std::string> lines;
+
+    // Keep the "[STDOUT] line" format of Container::logs, raw TTY lines are not prefixed
+    const LogDemuxer::LineCallback collect = [this, &lines](containerTypes::LogStream streamType, std::string_view line) {
+        std::string text = tty ? std::string() : std::string(logStreamPrefix(streamType));
+        text.append(line);
+        lines.push_back(std::move(text));
+    };
+
+    stream.onData([this, &demuxer, &lines, &collect](const char *data, size_t size) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (pendingBytes >= maxBufferedBytes) {
+                // The dispatcher will resume() the transfer once it drained the queue
+                return DockerStream::Action::Pause;
+            }
+        }
+        demuxer.feed(data, size, collect);
+        push(lines);
+        return DockerStream::Action::Continue;
+    });
+
+    try {
+        long status = stream.perform();
+        if (status != 200 && !stream.isCancelled()) {
+            lines.push_back("Error following logs: HTTP " + std::to_string(status) + " " + stream.getErrorBody());
+        }
+    } catch (const std::exception &e) {
+        lines.push_back("Error following logs: " + std::string(e.what()));
+    }
+
+    if (!stream.isCancelled()) {
+        demuxer.flush(collect);
+        push(lines);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        readerDone = true;
+    }
+    cv.notify_one();
+}
+
+void LogFollower::dispatchLoop() {
+    std::deque<std::string> batch;
+    while (true) {
+        bool wasFull;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [this] { return !pending.empty() || readerDone; });
+            if (pending.empty() && readerDone) break;
+
+            wasFull = pendingBytes >= maxBufferedBytes;
+            batch.swap(pending);
+            pendingBytes = 0;
+        }
+        if (wasFull) stream.resume();
+
+        for (const auto &line : batch) {
+            if (stream.isCancelled()) break;
+            callback(line);
+        }
+        batch.clear();
+    }
+    running.store(false);
+}
+
+void LogFollower::cancel() {
+    stream.cancel();
+}
+
+void LogFollower::join() {
+    if (reader.joinable() && reader.get_id() != std::this_thread::get_id()) reader.join();
+    if (dispatcher.joinable() && dispatcher.get_id() != std::this_thread::get_id()) dispatcher.join();
+}
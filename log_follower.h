@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2025 Nokaji. Tous droits réservés.
+ * Ce fichier fait partie du projet Kernel-James.
+ */
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "docker_stream.h"
+
+/*
+ * Handle on a running `docker logs --follow`.
+ * One thread reads and demultiplexes the stream as bytes arrive, a second one
+ * delivers lines to the callback. At most maxBufferedBytes of lines wait for the
+ * callback; past that the HTTP transfer is paused until the callback catches up.
+ * Destroying the handle cancels the stream and joins both threads.
+ */
+class LogFollower
+{
+    public:
+        using LineCallback = std::function<void(const std::string &)>;
+
+        static constexpr size_t DEFAULT_MAX_BUFFERED_BYTES = 1 << 20;
+
+    private:
+        DockerStream stream;
+        LineCallback callback;
+        bool tty;
+        size_t maxBufferedBytes;
+
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::deque<std::string> pending;
+        size_t pendingBytes = 0;
+        bool readerDone = false;
+
+        std::atomic<bool> running{true};
+        std::thread reader;
+        std::thread dispatcher;
+
+        void readLoop();
+        void dispatchLoop();
+        void push(std::deque<std::string> &lines);
+
+    public:
+        LogFollower(const std::string &url, bool tty, LineCallback callback, int maxDuration = 0,
+                    size_t maxBufferedBytes = DEFAULT_MAX_BUFFERED_BYTES);
+        ~LogFollower();
+
+        LogFollower(const LogFollower &) = delete;
+        LogFollower &operator=(const LogFollower &) = delete;
+
+        // Stop following; pending lines are dropped
+        void cancel();
+        // Wait for the stream to end (container stopped, maxDuration or cancel)
+        void join();
+
+        [[nodiscard]] bool isRunning() const { return running.load(); }
+};
@@ -0,0 +1,319 @@
+/*
+ * Copyright (c) 2025 Nokaji. Tous droits réservés.
+ * Ce fichier fait partie du projet Kernel-James.
+ */
+#include "log_multiplexer.h"
+#include "docker.h"
+#include "container_manager.h"
+#include <fmt/format.h>
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <cmath>
+#include <future>
+#include <iostream>
+
+namespace {
+    constexpr auto REFILL_INTERVAL = std::chrono::milliseconds(20);
+
+    std::string urlEncode(const std::string &value) {
+        char *escaped = curl_easy_escape(nullptr, value.c_str(), static_cast<int>(value.size()));
+        if (!escaped) return value;
+        std::string result(escaped);
+        curl_free(escaped);
+        return result;
+    }
+}
+
+LogMultiplexer::LogMultiplexer(std::shared_ptr<DockerClient> client, LineCallback callback, LogMultiplexerOptions options)
+    : dockerClient(std::move(client)), callback(std::move(callback)), options(std::move(options)) {
+    if (!dockerClient) {
+        throw std::runtime_error("Docker client is not initialized.");
+    }
+    if (this->options.quantum == 0) this->options.quantum = 1;
+}
+
+LogMultiplexer::~LogMultiplexer() {
+    stop();
+}
+
+void LogMultiplexer::start() {
+    if (loop) return;
+    loop = std::make_unique<DockerEventLoop>();
+    loop->onIteration([this] { drain(); });
+    if (options.linesPerSecond > 0) {
+        // Rate-limited queues need a clock even when no data arrives
+        loop->every(REFILL_INTERVAL, [this] { drain(); });
+    }
+
+    // Subscribe first so a container starting during the listing is not missed
+    if (options.autoAttach) {
+        loop->post([this] { subscribeEvents(); });
+    }
+
+    std::string filters;
+    if (!options.labels.empty()) {
+        filters = nlohmann::json{{"label", options.labels}}.dump();
+    }
+    ContainerManager containerManager(dockerClient);
+    for (const auto &container : containerManager.list(false, 0, false, filters)) {
+        loop->post([this, id = container.id, name = container.name] { attachOnLoop(id, name); });
+    }
+}
+
+void LogMultiplexer::stop() {
+    if (!loop) return;
+    loop->post([this] {
+        if (events) events->cancel();
+        for (auto &[id, follower] : followers) {
+            if (follower.stream) follower.stream->cancel();
+        }
+    });
+    loop->stop();
+    loop.reset();
+    followers.clear();
+    order.clear();
+    events.reset();
+}
+
+void LogMultiplexer::attach(const std::string &containerId) {
+    if (!loop) throw std::runtime_error("LogMultiplexer is not started");
+    loop->post([this, containerId] { attachOnLoop(containerId, ""); });
+}
+
+void LogMultiplexer::detach(const std::string &containerId) {
+    if (!loop) return;
+    loop->post([this, containerId] { detachOnLoop(containerId); });
+}
+
+std::vector<std::string> LogMultiplexer::followed() {
+    auto collect = [this] {
+        std::vector<std::string> ids;
+        for (const auto &[id, follower] : followers) {
+            if (!follower.finished && !follower.detached) ids.push_back(id);
+        }
+        return ids;
+    };
+    if (!loop) return {};
+    if (loop->inLoopThread()) return collect();
+
+    std::promise<std::vector<std::string>> result;
+    auto future = result.get_future();
+    // Refused once the loop has shut down: nothing would ever answer
+    if (!loop->post([&result, &collect] { result.set_value(collect()); })) return {};
+    return future.get();
+}
+
+bool LogMultiplexer::matchesLabels(const std::map<std::string, std::string> &labels) const {
+    for (const auto &filter : options.labels) {
+        auto equal = filter.find('=');
+        auto it = labels.find(filter.substr(0, equal));
+        if (it == labels.end()) return false;
+        if (equal != std::string::npos && it->second != filter.substr(equal + 1)) return false;
+    }
+    return true;
+}
+
+void LogMultiplexer::attachOnLoop(const std::string &containerId, const std::string &name) {
+    // A restarted container may still have a finished follower draining its queue: it is reused below
+    auto existing = followers.find(containerId);
+    if (existing != followers.end() && !existing->second.finished && !existing->second.detached) return;
+
+    // The stream format (framed or raw) depends on Config.Tty: inspect without blocking the loop
+    auto body = std::make_shared<std::string>();
+    auto inspect = std::make_shared<DockerStream>(fmt::format("{}/containers/{}/json", dockerClient->getDockerApiUrl(), containerId));
+    inspect->onData([body](const char *data, size_t size) {
+        body->append(data, size);
+        return DockerStream::Action::Continue;
+    });
+
+    loop->add(inspect, [this, containerId, name, body](long status, const std::string &error) {
+        if (status != 200) {
+            std::cerr << "Cannot follow logs of " << containerId << ": inspect failed (HTTP " << status << ") " << error << std::endl;
+            return;
+        }
+        try {
+            auto json = nlohmann::json::parse(*body);
+            bool tty = json.contains("Config") && json["Config"].is_object() && json["Config"].value("Tty", false);
+            std::string fullName = json.value("Name", name);
+            if (!fullName.empty() && fullName[0] == '/') fullName = fullName.substr(1);
+
+            auto it = followers.find(containerId);
+            if (it != followers.end() && !it->second.finished && !it->second.detached) return;
+            if (it == followers.end()) {
+                it = followers.try_emplace(containerId).first;
+                order.push_back(containerId);
+            }
+            Follower &follower = it->second;
+            follower.id = containerId;
+            follower.name = fullName;
+            follower.demuxer = LogDemuxer(tty);
+            follower.tokens = options.burst;
+            follower.lastRefill = std::chrono::steady_clock::now();
+            follower.paused = false;
+            follower.finished = false;
+            follower.detached = false;
+            openLogs(containerId);
+        } catch (const nlohmann::json::exception &e) {
+            std::cerr << "Cannot follow logs of " << containerId << ": " << e.what() << std::endl;
+        }
+    });
+}
+
+void LogMultiplexer::openLogs(const std::string &containerId) {
+    auto stream = std::make_shared<DockerStream>(fmt::format(
+            "{}/containers/{}/logs?follow=1&stdout=1&stderr=1&tail={}&timestamps={}",
+            dockerClient->getDockerApiUrl(), containerId, urlEncode(options.tail), options.timestamps ? 1 : 0));
+
+    stream->onData([this, containerId](const char *data, size_t size) {
+        auto it = followers.find(containerId);
+        if (it == followers.end() || it->second.detached) return DockerStream::Action::Stop;
+
+        Follower &follower = it->second;
+        if (follower.queue.size() >= options.maxQueuedLines) {
+            follower.paused = true;
+            return DockerStream::Action::Pause;
+        }
+        follower.demuxer.feed(data, size, [&follower](containerTypes::LogStream stream, std::string_view line) {
+            follower.queue.push_back(PendingLine{stream, std::string(line)});
+        });
+        return DockerStream::Action::Continue;
+    });
+
+    followers[containerId].stream = stream;
+
+    loop->add(stream, [this, containerId](long status, const std::string &error) {
+        auto it = followers.find(containerId);
+        if (it == followers.end()) return;
+        Follower &follower = it->second;
+        if (status != 200 && !follower.detached) {
+            std::cerr << "Log stream of " << containerId << " ended with HTTP " << status << " " << error << std::endl;
+        }
+        follower.demuxer.flush([&follower](containerTypes::LogStream stream, std::string_view line) {
+            follower.queue.push_back(PendingLine{stream, std::string(line)});
+        });
+        follower.finished = true;
+        follower.stream.reset();
+    });
+}
+
+void LogMultiplexer::detachOnLoop(const std::string &containerId) {
+    auto it = followers.find(containerId);
+    if (it == followers.end()) return;
+    it->second.detached = true;
+    it->second.queue.clear();
+    if (it->second.stream) it->second.stream->cancel();
+}
+
+void LogMultiplexer::subscribeEvents() {
+    nlohmann::json filters = {
+        {"type", {"container"}},
+        {"event", {"start", "destroy"}}
+    };
+    if (!options.labels.empty()) {
+        filters["label"] = options.labels;
+    }
+
+    events = std::make_shared<DockerStream>(fmt::format("{}/events?filters={}", dockerClient->getDockerApiUrl(), urlEncode(filters.dump())));
+    eventBuffer.clear();
+    events->onData([this](const char *data, size_t size) {
+        eventBuffer.append(data, size);
+        size_t start = 0;
+        for (size_t newline = eventBuffer.find('\n'); newline != std::string::npos; newline = eventBuffer.find('\n', start)) {
+            handleEvent(eventBuffer.substr(start, newline - start));
+            start = newline + 1;
+        }
+        eventBuffer.erase(0, start);
+        return DockerStream::Action::Continue;
+    });
+
+    loop->add(events, [](long status, const std::string &error) {
+        if (status != 200) {
+            std::cerr << "Container event stream ended with HTTP " << status << " " << error << std::endl;
+        }
+    });
+}
+
+void LogMultiplexer::handleEvent(const std::string &line) {
+    if (line.empty()) return;
+    try {
+        auto event = nlohmann::json::parse(line);
+        if (event.value("Type", std::string{}) != "container") return;
+        if (!event.contains("Actor") || !event["Actor"].is_object()) return;
+
+        const auto &actor = event["Actor"];
+        const std::string id = actor.value("ID", std::string{});
+        const std::string action = event.value("Action", std::string{});
+
+        std::map<std::string, std::string> attributes;
+        if (actor.contains("Attributes") && actor["Attributes"].is_object()) {
+            for (const auto &[key, value] : actor["Attributes"].items()) {
+                if (value.is_string()) attributes[key] = value.get<std::string>();
+            }
+        }
+
+        if (action == "start" && matchesLabels(attributes)) {
+            attachOnLoop(id, attributes["name"]);
+        } else if (action == "destroy") {
+            detachOnLoop(id);
+        }
+        // "die" needs nothing: the follow stream ends by itself once the container stops
+    } catch (const nlohmann::json::exception &e) {
+        std::cerr << "Ignoring malformed event: " << e.what() << std::endl;
+    }
+}
+
+void LogMultiplexer::refill(Follower &follower, std::chrono::steady_clock::time_point now) {
+    if (options.linesPerSecond <= 0) return;
+    std::chrono::duration<double> elapsed = now - follower.lastRefill;
+    follower.tokens = std::min(options.burst, follower.tokens + elapsed.count() * options.linesPerSecond);
+    follower.lastRefill = now;
+}
+
+void LogMultiplexer::drain() {
+    if (order.empty()) return;
+    const auto now = std::chrono::steady_clock::now();
+    const bool limited = options.linesPerSecond > 0;
+
+    for (auto &id : order) refill(followers[id], now);
+
+    // Deficit-free round robin: every container gets up to quantum lines per round
+    bool progressed = true;
+    while (progressed) {
+        progressed = false;
+        for (size_t n = 0; n < order.size(); ++n) {
+            Follower &follower = followers[order[(cursor + n) % order.size()]];
+            size_t budget = options.quantum;
+            if (limited) budget = std::min(budget, static_cast<size_t>(std::floor(follower.tokens)));
+
+            size_t sent = 0;
+            while (sent < budget && !follower.queue.empty()) {
+                const PendingLine &pending = follower.queue.front();
+                callback(MultiplexedLogLine{follower.id, follower.name, pending.stream, pending.text});
+                follower.queue.pop_front();
+                ++sent;
+            }
+            if (limited) follower.tokens -= static_cast<double>(sent);
+            if (sent > 0) progressed = true;
+
+            if (follower.paused && follower.stream && follower.queue.size() <= options.maxQueuedLines / 2) {
+                follower.paused = false;
+                follower.stream->resume();
+            }
+        }
+        cursor = (cursor + 1) % order.size();
+    }
+
+    // Forget followers whose stream ended and whose lines were all delivered
+    order.erase(std::remove_if(order.begin(), order.end(), [this](const std::string &id) {
+        auto it = followers.find(id);
+        if (it == followers.end()) return true;
+        const Follower &follower = it->second;
+        if ((follower.finished && follower.queue.empty()) || (follower.detached && !follower.stream)) {
+            followers.erase(it);
+            return true;
+        }
+        return false;
+    }), order.end());
+    if (!order.empty()) cursor %= order.size();
+    else cursor = 0;
+}
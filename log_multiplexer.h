@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2025 Nokaji. Tous droits réservés.
+ * Ce fichier fait partie du projet Kernel-James.
+ */
+#pragma once
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "docker_event_loop.h"
+#include "log_demuxer.h"
+#include "types/container_types.h"
+
+class DockerClient;
+
+struct MultiplexedLogLine {
+    std::string_view containerId;
+    std::string_view containerName;
+    containerTypes::LogStream stream;
+    std::string_view text;
+};
+
+struct LogMultiplexerOptions {
+    // Per-container token bucket, 0 disables rate limiting
+    double linesPerSecond = 0;
+    double burst = 1000;
+    // Lines one container may deliver before the next one gets its turn
+    size_t quantum = 64;
+    // Queued lines above which a container's transfer is paused
+    size_t maxQueuedLines = 10000;
+    // Passed to /logs when a follower attaches ("0" = only new lines)
+    std::string tail = "0";
+    bool timestamps = false;
+    // Follow containers as they start/stop, using the /events stream
+    bool autoAttach = true;
+    // Label filters ("key" or "key=value") selecting the containers to follow
+    std::vector<std::string> labels;
+};
+
+/*
+ * Follows the logs of many containers on one DockerEventLoop thread.
+ * Lines are delivered on the loop thread, tagged with container and stream,
+ * round-robin between containers (quantum lines per turn, within each
+ * container's rate limit). A container that cannot keep up has its transfer
+ * paused instead of growing its queue.
+ */
+class LogMultiplexer
+{
+    public:
+        using LineCallback = std::function<void(const MultiplexedLogLine &line)>;
+
+    private:
+        struct PendingLine {
+            containerTypes::LogStream stream;
+            std::string text;
+        };
+
+        struct Follower {
+            std::string id;
+            std::string name;
+            LogDemuxer demuxer;
+            std::shared_ptr<DockerStream> stream;
+            std::deque<PendingLine> queue;
+            double tokens = 0;
+            std::chrono::steady_clock::time_point lastRefill;
+            bool paused = false;
+            bool finished = false;
+            bool detached = false;
+        };
+
+        std::shared_ptr<DockerClient> dockerClient;
+        LineCallback callback;
+        LogMultiplexerOptions options;
+        std::unique_ptr<DockerEventLoop> loop;
+
+        // Loop thread only
+        std::map<std::string, Follower> followers;
+        std::vector<std::string> order; // round-robin order
+        size_t cursor = 0;
+        std::shared_ptr<DockerStream> events;
+        std::string eventBuffer;
+
+        void attachOnLoop(const std::string &containerId, const std::string &name);
+        void openLogs(const std::string &containerId);
+        void detachOnLoop(const std::string &containerId);
+        void subscribeEvents();
+        void handleEvent(const std::string &line);
+        void drain();
+        void refill(Follower &follower, std::chrono::steady_clock::time_point now);
+        bool matchesLabels(const std::map<std::string, std::string> &labels) const;
+
+    public:
+        LogMultiplexer(std::shared_ptr<DockerClient> client, LineCallback callback, LogMultiplexerOptions options = {});
+        ~LogMultiplexer();
+
+        // Attach every running container matching the labels and, if enabled, watch /events
+        void start();
+        void stop();
+
+        // Thread-safe; the work happens on the loop thread
+        void attach(const std::string &containerId);
+        void detach(const std::string &containerId);
+
+        // Ids of the containers currently followed (waits for the loop)
+        [[nodiscard]] std::vector<std::string> followed();
+};
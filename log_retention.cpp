@@ -0,0 +1,231 @@
+/*
+ * Copyright (c) 2025 Nokaji. Tous droits réservés.
+ * Ce fichier fait partie du projet Kernel-James.
+ */
+#include "log_retention.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+
+namespace {
+    size_t roundUpPowerOfTwo(size_t value) {
+        size_t result = 1;
+        while (result < value) result <<= 1;
+        return result;
+    }
+
+    int64_t nowNanoseconds() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    int64_t steadyNanoseconds() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    constexpr size_t WORD = sizeof(uint64_t);
+}
+
+LogRingBuffer::LogRingBuffer(size_t requested) : lastWrite(steadyNanoseconds()) {
+    if (requested < HEADER_SIZE * 2) {
+        throw std::invalid_argument("Log ring buffer is too small");
+    }
+    capacity = roundUpPowerOfTwo(requested);
+    mask = capacity - 1;
+    // capacity is a power of two >= 32: words never straddle the wrap
+    words = std::make_unique<std::atomic<uint64_t>[]>(capacity / WORD);
+}
+
+void LogRingBuffer::copyOut(uint64_t position, char *out, size_t size) const {
+    size_t done = 0;
+    while (done < size) {
+        const size_t offset = static_cast<size_t>((position + done) & mask);
+        const size_t inWord = offset % WORD;
+        const size_t count = std::min(WORD - inWord, size - done);
+        const uint64_t value = words[offset / WORD].load(std::memory_order_relaxed);
+        char bytes[WORD];
+        std::memcpy(bytes, &value, WORD);
+        std::memcpy(out + done, bytes + inWord, count);
+        done += count;
+    }
+}
+
+void LogRingBuffer::copyIn(uint64_t position, const char *in, size_t size) {
+    size_t done = 0;
+    while (done < size) {
+        const size_t offset = static_cast<size_t>((position + done) & mask);
+        const size_t inWord = offset % WORD;
+        const size_t count = std::min(WORD - inWord, size - done);
+        std::atomic<uint64_t> &word = words[offset / WORD];
+        uint64_t value = 0;
+        // Partial words keep their other bytes; only this (single) writer stores words
+        if (count != WORD) value = word.load(std::memory_order_relaxed);
+        char bytes[WORD];
+        std::memcpy(bytes, &value, WORD);
+        std::memcpy(bytes + inWord, in + done, count);
+        std::memcpy(&value, bytes, WORD);
+        word.store(value, std::memory_order_relaxed);
+        done += count;
+    }
+}
+
+void LogRingBuffer::append(int64_t timestamp, containerTypes::LogStream stream, std::string_view text) {
+    if (text.size() > capacity - HEADER_SIZE) {
+        text = text.substr(0, capacity - HEADER_SIZE);
+    }
+    const uint64_t recordSize = HEADER_SIZE + text.size();
+    const uint64_t currentHead = head.load(std::memory_order_relaxed);
+    uint64_t currentTail = tail.load(std::memory_order_relaxed);
+
+    // Evict whole records until the new one fits; only the writer reads these lengths
+    while (currentHead + recordSize - currentTail > capacity) {
+        uint32_t length;
+        copyOut(currentTail, reinterpret_cast<char *>(&length), sizeof(length));
+        currentTail += HEADER_SIZE + length;
+    }
+
+    // Publish the new tail before touching the bytes readers may be copying
+    tail.store(currentTail, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    char header[HEADER_SIZE] = {};
+    const auto length = static_cast<uint32_t>(text.size());
+    std::memcpy(header, &length, sizeof(length));
+    header[4] = static_cast<char>(stream);
+    std::memcpy(header + 8, &timestamp, sizeof(timestamp));
+
+    copyIn(currentHead, header, HEADER_SIZE);
+    copyIn(currentHead + HEADER_SIZE, text.data(), text.size());
+
+    lastTimestamp.store(timestamp, std::memory_order_relaxed);
+    lastWrite.store(steadyNanoseconds(), std::memory_order_relaxed);
+    head.store(currentHead + recordSize, std::memory_order_release);
+}
+
+std::vector<RetainedLogRecord> LogRingBuffer::parse(const std::vector<char> &bytes, uint64_t base, uint64_t from) const {
+    std::vector<RetainedLogRecord> records;
+    size_t offset = static_cast<size_t>(from - base);
+    while (offset + HEADER_SIZE <= bytes.size()) {
+        uint32_t length;
+        int64_t timestamp;
+        std::memcpy(&length, bytes.data() + offset, sizeof(length));
+        std::memcpy(&timestamp, bytes.data() + offset + 8, sizeof(timestamp));
+        if (offset + HEADER_SIZE + length > bytes.size()) break;
+
+        records.push_back(RetainedLogRecord{
+            base + offset,
+            base + offset + HEADER_SIZE + length,
+            timestamp,
+            static_cast<containerTypes::LogStream>(bytes[offset + 4]),
+            std::string(bytes.data() + offset + HEADER_SIZE, length)
+        });
+        offset += HEADER_SIZE + length;
+    }
+    return records;
+}
+
+std::vector<RetainedLogRecord> LogRingBuffer::readFrom(uint64_t &cursor, bool *dropped) const {
+    const uint64_t currentHead = head.load(std::memory_order_acquire);
+    const uint64_t currentTail = tail.load(std::memory_order_acquire);
+    const uint64_t start = std::max(cursor, currentTail);
+    if (dropped) *dropped = cursor < currentTail && cursor != 0;
+    if (start >= currentHead) {
+        cursor = std::max(cursor, currentHead);
+        return {};
+    }
+
+    std::vector<char> bytes(static_cast<size_t>(currentHead - start));
+    copyOut(start, bytes.data(), bytes.size());
+
+    // Anything below the tail seen now may have been overwritten during the copy;
+    // the tail is always a record boundary, so parsing restarts there
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const uint64_t validFrom = tail.load(std::memory_order_relaxed);
+    if (validFrom > start) {
+        if (dropped) *dropped = true;
+        if (validFrom >= currentHead) {
+            cursor = currentHead;
+            return {};
+        }
+    }
+
+    auto records = parse(bytes, start, std::max(start, validFrom));
+    cursor = currentHead;
+    return records;
+}
+
+std::vector<RetainedLogRecord> LogRingBuffer::snapshot() const {
+    uint64_t cursor = 0;
+    return readFrom(cursor);
+}
+
+std::vector<RetainedLogRecord> LogRingBuffer::tailRecords(size_t count) const {
+    auto records = snapshot();
+    if (records.size() > count) {
+        records.erase(records.begin(), records.end() - static_cast<std::ptrdiff_t>(count));
+    }
+    return records;
+}
+
+LogRetention::LogRetention(size_t totalBytes, size_t bytesPerContainer)
+    : totalBytes(totalBytes), bytesPerContainer(roundUpPowerOfTwo(bytesPerContainer)) {
+    if (this->bytesPerContainer > totalBytes) {
+        throw std::invalid_argument("Per-container log ring is larger than the total log retention budget");
+    }
+}
+
+std::shared_ptr<LogRingBuffer> LogRetention::ringFor(const std::string &containerId) {
+    {
+        std::shared_lock lock(mutex);
+        auto it = rings.find(containerId);
+        if (it != rings.end()) return it->second;
+    }
+
+    std::unique_lock lock(mutex);
+    auto it = rings.find(containerId);
+    if (it != rings.end()) return it->second;
+
+    // Make room for one more ring by dropping the least recently written ones. Fresh rings count
+    // as written when created, so a ring another container just got is not the first to go.
+    while (!rings.empty() && (rings.size() + 1) * bytesPerContainer > totalBytes) {
+        auto oldest = std::min_element(rings.begin(), rings.end(), [](const auto &a, const auto &b) {
+            return a.second->getLastWrite() < b.second->getLastWrite();
+        });
+        rings.erase(oldest);
+    }
+
+    auto ring = std::make_shared<LogRingBuffer>(bytesPerContainer);
+    rings.emplace(containerId, ring);
+    return ring;
+}
+
+void LogRetention::append(const std::string &containerId, containerTypes::LogStream stream, std::string_view text, int64_t timestamp) {
+    ringFor(containerId)->append(timestamp != 0 ? timestamp : nowNanoseconds(), stream, text);
+}
+
+std::shared_ptr<const LogRingBuffer> LogRetention::ring(const std::string &containerId) const {
+    std::shared_lock lock(mutex);
+    auto it = rings.find(containerId);
+    return it != rings.end() ? it->second : nullptr;
+}
+
+std::vector<std::string> LogRetention::containers() const {
+    std::shared_lock lock(mutex);
+    std::vector<std::string> ids;
+    ids.reserve(rings.size());
+    for (const auto &[id, ring] : rings) ids.push_back(id);
+    return ids;
+}
+
+void LogRetention::drop(const std::string &containerId) {
+    std::unique_lock lock(mutex);
+    rings.erase(containerId);
+}
+
+size_t LogRetention::memoryUsage() const {
+    std::shared_lock lock(mutex);
+    return rings.size() * bytesPerContainer;
+}
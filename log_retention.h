@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2025 Nokaji. Tous droits réservés.
+ * Ce fichier fait partie du projet Kernel-James.
+ */
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "types/container_types.h"
+
+struct RetainedLogRecord {
+    uint64_t position;   // offset of the record in the ring
+    uint64_t next;       // offset past the record: the readFrom() cursor resuming after it
+    int64_t timestamp;   // nanoseconds since epoch
+    containerTypes::LogStream stream;
+    std::string text;
+};
+
+/*
+ * Fixed-size byte ring of length-prefixed log records.
+ * One writer appends, overwriting the oldest records when full. Readers never
+ * lock: they copy the bytes they want, then check that the writer did not
+ * move the tail over them meanwhile (seqlock style) and drop what was lost.
+ */
+class LogRingBuffer
+{
+    private:
+        static constexpr size_t HEADER_SIZE = 16; // u32 length, u8 stream, 3 pad, i64 timestamp
+
+        // Payload as relaxed atomic words: readers may copy bytes the writer is overwriting,
+        // which the fences and the tail check then discard
+        std::unique_ptr<std::atomic<uint64_t>[]> words;
+        size_t capacity;
+        size_t mask;
+
+        // Monotonic byte positions: [tail, head) holds complete records
+        std::atomic<uint64_t> head{0};
+        std::atomic<uint64_t> tail{0};
+        std::atomic<int64_t> lastTimestamp{0};
+        std::atomic<int64_t> lastWrite;            // steady clock, nanoseconds; creation time until the first append
+
+        void copyOut(uint64_t position, char *out, size_t size) const;
+        void copyIn(uint64_t position, const char *in, size_t size);
+        std::vector<RetainedLogRecord> parse(const std::vector<char> &bytes, uint64_t base, uint64_t from) const;
+
+    public:
+        // capacity is rounded up to a power of two
+        explicit LogRingBuffer(size_t capacity);
+
+        // Writer side, single thread. Lines longer than the ring are truncated.
+        void append(int64_t timestamp, containerTypes::LogStream stream, std::string_view text);
+
+        // Everything still retained
+        [[nodiscard]] std::vector<RetainedLogRecord> snapshot() const;
+
+        // Last count records
+        [[nodiscard]] std::vector<RetainedLogRecord> tailRecords(size_t count) const;
+
+        // Records after cursor (0 = from the oldest); cursor is moved past them.
+        // dropped is set when records between the old cursor and the tail were overwritten.
+        [[nodiscard]] std::vector<RetainedLogRecord> readFrom(uint64_t &cursor, bool *dropped = nullptr) const;
+
+        [[nodiscard]] size_t getCapacity() const { return capacity; }
+        [[nodiscard]] size_t usedBytes() const { return static_cast<size_t>(head.load() - tail.load()); }
+        [[nodiscard]] int64_t getLastTimestamp() const { return lastTimestamp.load(std::memory_order_relaxed); }
+        [[nodiscard]] int64_t getLastWrite() const { return lastWrite.load(std::memory_order_relaxed); }
+};
+
+/*
+ * Per-container LogRingBuffers under a global memory budget.
+ * Each container gets a ring of bytesPerContainer; when a new container would
+ * exceed totalBytes, the ring that was written to (or created) least recently
+ * is dropped.
+ * Meant to be fed from LogMultiplexer (one writer thread).
+ */
+class LogRetention
+{
+    private:
+        size_t totalBytes;
+        size_t bytesPerContainer;
+
+        mutable std::shared_mutex mutex;
+        std::unordered_map<std::string, std::shared_ptr<LogRingBuffer>> rings;
+
+        std::shared_ptr<LogRingBuffer> ringFor(const std::string &containerId);
+
+    public:
+        LogRetention(size_t totalBytes, size_t bytesPerContainer);
+
+        // timestamp 0 means now
+        void append(const std::string &containerId, containerTypes::LogStream stream, std::string_view text, int64_t timestamp = 0);
+
+        // Reader access, nullptr if the container has nothing retained
+        [[nodiscard]] std::shared_ptr<const LogRingBuffer> ring(const std::string &containerId) const;
+
+        [[nodiscard]] std::vector<std::string> containers() const;
+
+        void drop(const std::string &containerId);
+
+        [[nodiscard]] size_t memoryUsage() const;
+};
@@ -0,0 +1,234 @@
+/*
+ * Copyright (c) 2025 Nokaji. Tous droits réservés.
+ * Ce fichier fait partie du projet Kernel-James.
+ */
+#include "log_search.h"
+#include "container.h"
+#include "log_demuxer.h"
+#include "log_retention.h"
+#include "log_store.h"
+#include "parallel.h"
+#include <algorithm>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace {
+    inline unsigned lowestBit(uint32_t mask) {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward(&index, mask);
+        return static_cast<unsigned>(index);
+#else
+        return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+    }
+}
+
+size_t findLiteral(const char *data, size_t size, std::string_view needle) {
+    const size_t length = needle.size();
+    if (length == 0) return 0;
+    if (length > size) return std::string_view::npos;
+    if (length == 1) {
+        const void *found = std::memchr(data, needle[0], size);
+        return found ? static_cast<size_t>(static_cast<const char *>(found) - data) : std::string_view::npos;
+    }
+
+    size_t i = 0;
+#if defined(__AVX2__)
+    const __m256i first = _mm256_set1_epi8(needle[0]);
+    const __m256i last = _mm256_set1_epi8(needle[length - 1]);
+    for (; i + length - 1 + 32 <= size; i += 32) {
+        const __m256i blockFirst = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+        const __m256i blockLast = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i + length - 1));
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(
+                _mm256_and_si256(_mm256_cmpeq_epi8(first, blockFirst), _mm256_cmpeq_epi8(last, blockLast))));
+        while (mask) {
+            const unsigned bit = lowestBit(mask);
+            if (std::memcmp(data + i + bit + 1, needle.data() + 1, length - 2) == 0) return i + bit;
+            mask &= mask - 1;
+        }
+    }
+#elif defined(__SSE2__) || defined(_M_X64)
+    const __m128i first = _mm_set1_epi8(needle[0]);
+    const __m128i last = _mm_set1_epi8(needle[length - 1]);
+    for (; i + length - 1 + 16 <= size; i += 16) {
+        const __m128i blockFirst = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+        const __m128i blockLast = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i + length - 1));
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(
+                _mm_and_si128(_mm_cmpeq_epi8(first, blockFirst), _mm_cmpeq_epi8(last, blockLast))));
+        while (mask) {
+            const unsigned bit = lowestBit(mask);
+            if (std::memcmp(data + i + bit + 1, needle.data() + 1, length - 2) == 0) return i + bit;
+            mask &= mask - 1;
+        }
+    }
+#endif
+
+    // Remainder (or no SIMD): the standard search, which jumps between first-byte hits with memchr
+    return std::string_view(data, size).find(needle, i);
+}
+
+LogSearch::LogSearch(LogSearchQuery query) : query(std::move(query)) {
+    if (this->query.regex) {
+        // Throws std::regex_error on an invalid expression, before any search starts
+        pattern = std::make_unique<std::regex>(*this->query.regex, std::regex::ECMAScript | std::regex::optimize);
+    }
+    if (this->query.slicesPerContainer == 0) this->query.slicesPerContainer = 1;
+}
+
+bool LogSearch::matches(std::string_view line, int &patternIndex) const {
+    patternIndex = -1;
+    if (!query.literals.empty()) {
+        for (size_t i = 0; i < query.literals.size(); ++i) {
+            if (findLiteral(line.data(), line.size(), query.literals[i]) != std::string_view::npos) {
+                patternIndex = static_cast<int>(i);
+                break;
+            }
+        }
+        if (patternIndex < 0) return false;
+    }
+    // The regex only runs on lines that passed the cheap literal filter
+    return !pattern || std::regex_search(line.begin(), line.end(), *pattern);
+}
+
+bool LogSearch::inRange(int64_t timestamp, containerTypes::LogStream stream) const {
+    if (query.stream && *query.stream != stream) return false;
+    // Lines without a timestamp cannot be placed: only an unbounded query keeps them
+    if (timestamp == 0) return query.from == INT64_MIN && query.to == INT64_MAX;
+    return timestamp >= query.from && timestamp <= query.to;
+}
+
+bool LogSearch::report(const LogMatch &match, const MatchCallback &callback) {
+    if (stopped.load(std::memory_order_relaxed)) return false;
+    std::lock_guard lock(callbackMutex);
+    if (stopped.load(std::memory_order_relaxed)) return false;
+
+    const size_t count = ++matchCount;
+    if (!callback(match) || (query.maxMatches > 0 && count >= query.maxMatches)) {
+        stopped = true;
+        return false;
+    }
+    return true;
+}
+
+void LogSearch::begin() {
+    stopped = false;
+    matchCount = 0;
+}
+
+size_t LogSearch::search(LogStore &store, const std::vector<std::string> &containerIds, const MatchCallback &callback) {
+    begin();
+
+    struct Slice {
+        const std::string *containerId;
+        int64_t from;
+        int64_t to;
+    };
+
+    // Cut every container's stored span (clamped to the query) into equal time slices
+    std::vector<Slice> slices;
+    for (const auto &containerId : containerIds) {
+        auto [first, last] = store.timeRange(containerId);
+        if (first == 0 && last == 0) continue;
+        const int64_t from = std::max(first, query.from);
+        const int64_t to = std::min(last, query.to);
+        if (from > to) continue;
+
+        const uint64_t span = static_cast<uint64_t>(to - from) + 1;
+        const uint64_t pieces = std::min<uint64_t>(query.slicesPerContainer, span);
+        const uint64_t width = span / pieces;
+        for (uint64_t i = 0; i < pieces; ++i) {
+            const int64_t sliceFrom = from + static_cast<int64_t>(i * width);
+            const int64_t sliceTo = i + 1 == pieces ? to : sliceFrom + static_cast<int64_t>(width) - 1;
+            slices.push_back(Slice{&containerId, sliceFrom, sliceTo});
+        }
+    }
+
+    parallelFor(slices.size(), query.concurrency, [&](size_t index) {
+        const Slice &slice = slices[index];
+        if (stopped) return;
+        store.query(*slice.containerId, slice.from, slice.to, query.stream, [&](const StoredLogRecord &record) {
+            int patternIndex;
+            if (!matches(record.text, patternIndex)) return !stopped.load(std::memory_order_relaxed);
+            return report(LogMatch{*slice.containerId, record.timestamp, record.stream, record.text, patternIndex}, callback);
+        });
+    });
+    return matchCount;
+}
+
+size_t LogSearch::search(const LogRetention &retention, const MatchCallback &callback) {
+    begin();
+    const auto containerIds = retention.containers();
+
+    parallelFor(containerIds.size(), query.concurrency, [&](size_t index) {
+        auto ring = retention.ring(containerIds[index]);
+        if (!ring || stopped) return;
+        for (const auto &record : ring->snapshot()) {
+            int patternIndex;
+            if (!inRange(record.timestamp, record.stream) || !matches(record.text, patternIndex)) continue;
+            if (!report(LogMatch{containerIds[index], record.timestamp, record.stream, record.text, patternIndex}, callback)) return;
+        }
+    });
+    return matchCount;
+}
+
+size_t LogSearch::search(std::vector<Container> &containers, const MatchCallback &callback) {
+    begin();
+
+    // The daemon takes whole seconds: widen the window, lines are filtered exactly below
+    const long since = query.from == INT64_MIN ? 0 : static_cast<long>(std::max<int64_t>(query.from / 1000000000, 0));
+    const long until = query.to == INT64_MAX ? 0 : static_cast<long>(query.to / 1000000000 + 1);
+    const bool captureStdout = !query.stream || *query.stream == containerTypes::LogStream::STDOUT;
+    const bool captureStderr = !query.stream || *query.stream == containerTypes::LogStream::STDERR;
+
+    parallelFor(containers.size(), query.concurrency, [&](size_t index) {
+        Container &container = containers[index];
+        if (stopped) return;
+        const std::string &containerId = container.getId();
+        container.logs([&](containerTypes::LogStream stream, std::string_view line) {
+            if (stopped.load(std::memory_order_relaxed)) return;
+            std::string_view message;
+            const int64_t timestamp = parseLogTimestamp(line, &message);
+            if (timestamp == 0) message = line;
+
+            int patternIndex;
+            if (!inRange(timestamp, stream) || !matches(message, patternIndex)) return;
+            report(LogMatch{containerId, timestamp, stream, message, patternIndex}, callback);
+        }, captureStdout, captureStderr, since, until, true, "all", &stopped);
+    });
+    return matchCount;
+}
+
+size_t LogSearch::search(const std::string &containerId, const std::vector<std::string> &lines, const MatchCallback &callback) {
+    begin();
+
+    // Big batches only: below that, threads cost more than the scan
+    constexpr size_t LINES_PER_TASK = 16384;
+    const size_t tasks = (lines.size() + LINES_PER_TASK - 1) / LINES_PER_TASK;
+
+    parallelFor(tasks, query.concurrency, [&](size_t task) {
+        const size_t end = std::min(lines.size(), (task + 1) * LINES_PER_TASK);
+        for (size_t i = task * LINES_PER_TASK; i < end && !stopped; ++i) {
+            // Container::logs() marks each line with its stream; only the message is searched and reported
+            auto stream = containerTypes::LogStream::STDOUT;
+            std::string_view message = lines[i];
+            if (message.starts_with(logStreamPrefix(containerTypes::LogStream::STDERR))) stream = containerTypes::LogStream::STDERR;
+            const std::string_view prefix = logStreamPrefix(stream);
+            if (message.starts_with(prefix)) message.remove_prefix(prefix.size());
+
+            int patternIndex;
+            if (!inRange(0, stream) || !matches(message, patternIndex)) continue;
+            if (!report(LogMatch{containerId, 0, stream, message, patternIndex}, callback)) return;
+        }
+    });
+    return matchCount;
+}
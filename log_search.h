@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2025 Nokaji. Tous droits réservés.
+ * Ce fichier fait partie du projet Kernel-James.
+ */
+#pragma once
+#include <atomic>
+#include <climits>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "types/container_types.h"
+
+class Container;
+class LogStore;
+class LogRetention;
+
+struct LogSearchQuery {
+    std::vector<std::string> literals;          // a line matches if it contains any of them
+    std::optional<std::string> regex;           // ECMAScript; if literals are set too, both must match
+    std::optional<containerTypes::LogStream> stream;
+    int64_t from = INT64_MIN;                   // nanoseconds since epoch, inclusive
+    int64_t to = INT64_MAX;
+    size_t maxMatches = 0;                      // stop after this many, 0 = no limit
+    size_t concurrency = 0;                     // worker threads, 0 = hardware concurrency
+    size_t slicesPerContainer = 4;              // time slices searched in parallel in a LogStore
+};
+
+struct LogMatch {
+    std::string_view containerId;
+    int64_t timestamp;                          // 0 when the source has no timestamp
+    containerTypes::LogStream stream;
+    std::string_view line;                      // only valid during the callback
+    int pattern;                                // index in literals, -1 for a regex-only query
+};
+
+// Position of needle in [data, data + size) or std::string_view::npos.
+// Candidates are found 16/32 bytes at a time by comparing the first and last
+// needle bytes, only those are compared in full.
+size_t findLiteral(const char *data, size_t size, std::string_view needle);
+
+/*
+ * Searches captured logs of many containers at once. Sources are split into
+ * independent pieces (containers, time slices) searched by parallelFor; matches
+ * are handed to the callback as soon as they are found, one at a time, in no
+ * particular order across pieces.
+ */
+class LogSearch
+{
+    public:
+        using MatchCallback = std::function<bool(const LogMatch &match)>; // return false to stop the search
+
+    private:
+        LogSearchQuery query;
+        std::unique_ptr<std::regex> pattern;
+
+        std::mutex callbackMutex;
+        std::atomic<bool> stopped{false};
+        std::atomic<size_t> matchCount{0};
+
+        // Literal then regex filter; pattern is set to the matching literal
+        bool matches(std::string_view line, int &patternIndex) const;
+        bool inRange(int64_t timestamp, containerTypes::LogStream stream) const;
+        // false once the search must stop
+        bool report(const LogMatch &match, const MatchCallback &callback);
+        void begin();
+
+    public:
+        explicit LogSearch(LogSearchQuery query);
+
+        // History written by LogStore, each container split into time slices
+        size_t search(LogStore &store, const std::vector<std::string> &containerIds, const MatchCallback &callback);
+
+        // In-memory rings (all containers retained)
+        size_t search(const LogRetention &retention, const MatchCallback &callback);
+
+        // Straight from the daemon: the logs are streamed and searched without being stored,
+        // and every transfer ends as soon as the search stops
+        size_t search(std::vector<Container> &containers, const MatchCallback &callback);
+
+        // Lines already fetched, e.g. the result of Container::logs()
+        size_t search(const std::string &containerId, const std::vector<std::string> &lines, const MatchCallback &callback);
+};
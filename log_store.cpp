@@ -0,0 +1,395 @@
+/*
+ * Copyright (c) 2025 Nokaji. Tous droits réservés.
+ * Ce fichier fait partie du projet Kernel-James.
+ */
+#include "log_store.h"
+#include "container.h"
+#include <fmt/format.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <fstream>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    constexpr size_t HEADER_SIZE = 16;       // u32 length, u8 stream, 3 pad, i64 timestamp
+    constexpr size_t INDEX_ENTRY_SIZE = 16;  // i64 max timestamp of the records before offset, u64 offset
+
+    int64_t nowNanoseconds() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    // Read-only view of a whole file; pages are only read when touched
+    // A segment unlinked by retention or drop() after a query copied the segment list
+    struct SegmentExpired : std::runtime_error {
+        using std::runtime_error::runtime_error;
+    };
+
+    class MappedFile
+    {
+        private:
+            const char *bytes = nullptr;
+            size_t length = 0;
+#ifdef _WIN32
+            std::string buffer; // no mmap here: the file is read in full
+#endif
+
+        public:
+            MappedFile(const std::string &path, size_t size) : length(size) {
+                if (size == 0) return;
+#ifdef _WIN32
+                std::ifstream file(path, std::ios::binary);
+                std::error_code error;
+                if (!file.is_open() && !std::filesystem::exists(path, error)) throw SegmentExpired("Log segment removed: " + path);
+                buffer.resize(size);
+                if (!file.read(buffer.data(), static_cast<std::streamsize>(size))) {
+                    throw std::runtime_error("Cannot read log segment " + path);
+                }
+                bytes = buffer.data();
+#else
+                int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+                if (fd < 0 && errno == ENOENT) throw SegmentExpired("Log segment removed: " + path);
+                if (fd < 0) throw std::runtime_error("Cannot open log segment " + path + ": " + std::strerror(errno));
+                void *mapping = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+                ::close(fd);
+                if (mapping == MAP_FAILED) throw std::runtime_error("Cannot map log segment " + path + ": " + std::strerror(errno));
+                bytes = static_cast<const char *>(mapping);
+#endif
+            }
+
+            ~MappedFile() {
+#ifndef _WIN32
+                if (bytes) ::munmap(const_cast<char *>(bytes), length);
+#endif
+            }
+
+            MappedFile(const MappedFile &) = delete;
+            MappedFile &operator=(const MappedFile &) = delete;
+
+            // The scan moves forward from the index position: let the kernel read ahead
+            void sequentialFrom(size_t offset) const {
+#ifndef _WIN32
+                const size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+                const size_t start = offset / page * page;
+                if (bytes && start < length) {
+                    ::madvise(const_cast<char *>(bytes) + start, length - start, MADV_SEQUENTIAL);
+                }
+#endif
+            }
+
+            [[nodiscard]] const char *data() const { return bytes; }
+            [[nodiscard]] size_t size() const { return length; }
+    };
+
+    bool validContainerId(const std::string &containerId) {
+        return !containerId.empty() && containerId != "." && containerId != ".." &&
+               containerId.find_first_of("/\\") == std::string::npos;
+    }
+}
+
+LogStore::LogStore(std::string directory, LogStoreOptions options)
+    : directory(std::move(directory)), options(options) {
+    if (this->options.indexInterval == 0) this->options.indexInterval = 1;
+    std::filesystem::create_directories(this->directory);
+}
+
+LogStore::~LogStore() {
+    std::lock_guard lock(mutex);
+    for (auto &[id, log] : logs) closeSegment(*log);
+}
+
+LogStore::ContainerLog &LogStore::containerLog(const std::string &containerId) {
+    auto it = logs.find(containerId);
+    if (it != logs.end()) return *it->second;
+
+    if (!validContainerId(containerId)) {
+        throw std::invalid_argument("Invalid container id for the log store: " + containerId);
+    }
+    auto log = std::make_unique<ContainerLog>();
+    log->directory = (std::filesystem::path(directory) / containerId).string();
+    std::filesystem::create_directories(log->directory);
+    loadSegments(*log);
+    return *logs.emplace(containerId, std::move(log)).first->second;
+}
+
+LogStore::ContainerLog *LogStore::findLog(const std::string &containerId) {
+    auto it = logs.find(containerId);
+    if (it != logs.end()) return it->second.get();
+
+    if (!validContainerId(containerId)) return nullptr;
+    const std::string logDirectory = (std::filesystem::path(directory) / containerId).string();
+    std::error_code error;
+    if (!std::filesystem::is_directory(logDirectory, error)) return nullptr;
+    return &containerLog(containerId);
+}
+
+void LogStore::loadSegments(ContainerLog &log) const {
+    for (const auto &entry : std::filesystem::directory_iterator(log.directory)) {
+        if (!entry.is_regular_file() || entry.path().extension() != ".log") continue;
+
+        Segment segment;
+        segment.basePath = (entry.path().parent_path() / entry.path().stem()).string();
+        segment.size = entry.file_size();
+        if (segment.size < HEADER_SIZE) continue;
+
+        // First timestamp from the first record, last one by scanning from the last index entry
+        MappedFile logFile(segment.basePath + ".log", static_cast<size_t>(segment.size));
+        std::memcpy(&segment.firstTimestamp, logFile.data() + 8, sizeof(int64_t));
+
+        uint64_t offset = 0;
+        std::error_code error;
+        const auto indexSize = std::filesystem::file_size(segment.basePath + ".idx", error);
+        if (!error && indexSize >= INDEX_ENTRY_SIZE) {
+            MappedFile indexFile(segment.basePath + ".idx", static_cast<size_t>(indexSize));
+            std::memcpy(&offset, indexFile.data() + (indexSize / INDEX_ENTRY_SIZE - 1) * INDEX_ENTRY_SIZE + 8, sizeof(offset));
+        }
+        segment.lastTimestamp = segment.firstTimestamp;
+        while (offset + HEADER_SIZE <= segment.size) {
+            uint32_t length;
+            int64_t timestamp;
+            std::memcpy(&length, logFile.data() + offset, sizeof(length));
+            std::memcpy(&timestamp, logFile.data() + offset + 8, sizeof(timestamp));
+            if (offset + HEADER_SIZE + length > segment.size) {
+                segment.size = offset; // torn write at the end: ignore it
+                break;
+            }
+            segment.lastTimestamp = std::max(segment.lastTimestamp, timestamp);
+            offset += HEADER_SIZE + length;
+        }
+
+        log.totalBytes += segment.size;
+        log.segments.push_back(std::move(segment));
+    }
+
+    std::sort(log.segments.begin(), log.segments.end(), [](const Segment &a, const Segment &b) {
+        return a.firstTimestamp < b.firstTimestamp;
+    });
+}
+
+void LogStore::openSegment(ContainerLog &log, int64_t firstTimestamp) {
+    // Name by first timestamp; a suffix keeps names unique when two segments start in the same nanosecond
+    std::string basePath = fmt::format("{}/{:020}", log.directory, firstTimestamp);
+    for (int suffix = 1; std::filesystem::exists(basePath + ".log"); ++suffix) {
+        basePath = fmt::format("{}/{:020}-{}", log.directory, firstTimestamp, suffix);
+    }
+
+    log.logFile = std::fopen((basePath + ".log").c_str(), "wb");
+    log.indexFile = log.logFile ? std::fopen((basePath + ".idx").c_str(), "wb") : nullptr;
+    if (!log.logFile || !log.indexFile) {
+        if (log.logFile) std::fclose(log.logFile);
+        log.logFile = nullptr;
+        throw std::runtime_error("Cannot create log segment " + basePath + ": " + std::strerror(errno));
+    }
+
+    Segment segment;
+    segment.basePath = std::move(basePath);
+    segment.firstTimestamp = firstTimestamp;
+    segment.lastTimestamp = firstTimestamp;
+    log.segments.push_back(std::move(segment));
+    log.lastIndexedOffset = 0;
+    log.maxTimestamp = INT64_MIN;
+    log.openedAt = std::chrono::steady_clock::now();
+}
+
+void LogStore::closeSegment(ContainerLog &log) {
+    if (log.logFile) std::fclose(log.logFile);
+    if (log.indexFile) std::fclose(log.indexFile);
+    log.logFile = nullptr;
+    log.indexFile = nullptr;
+}
+
+void LogStore::enforceRetention(ContainerLog &log) {
+    if (options.maxBytesPerContainer == 0) return;
+    // Never delete the active segment
+    const size_t sealed = log.logFile ? log.segments.size() - 1 : log.segments.size();
+    size_t removed = 0;
+    while (removed < sealed && log.totalBytes > options.maxBytesPerContainer) {
+        const Segment &oldest = log.segments[removed];
+        std::error_code error;
+        std::filesystem::remove(oldest.basePath + ".log", error);
+        std::filesystem::remove(oldest.basePath + ".idx", error);
+        log.totalBytes -= oldest.size;
+        ++removed;
+    }
+    log.segments.erase(log.segments.begin(), log.segments.begin() + static_cast<std::ptrdiff_t>(removed));
+}
+
+void LogStore::append(const std::string &containerId, containerTypes::LogStream stream, std::string_view text, int64_t timestamp) {
+    if (timestamp == 0) timestamp = nowNanoseconds();
+    if (text.size() > UINT32_MAX) text = text.substr(0, UINT32_MAX);
+
+    std::lock_guard lock(mutex);
+    ContainerLog &log = containerLog(containerId);
+
+    if (log.logFile) {
+        const Segment &active = log.segments.back();
+        if (active.size >= options.maxSegmentBytes ||
+            std::chrono::steady_clock::now() - log.openedAt >= options.maxSegmentAge) {
+            closeSegment(log);
+            enforceRetention(log);
+        }
+    }
+    if (!log.logFile) openSegment(log, timestamp);
+
+    Segment &active = log.segments.back();
+    if (active.size == 0 || active.size - log.lastIndexedOffset >= options.indexInterval) {
+        char entry[INDEX_ENTRY_SIZE];
+        std::memcpy(entry, &log.maxTimestamp, sizeof(int64_t));
+        std::memcpy(entry + 8, &active.size, sizeof(uint64_t));
+        std::fwrite(entry, 1, sizeof(entry), log.indexFile);
+        log.lastIndexedOffset = active.size;
+    }
+
+    char header[HEADER_SIZE] = {};
+    const auto length = static_cast<uint32_t>(text.size());
+    std::memcpy(header, &length, sizeof(length));
+    header[4] = static_cast<char>(stream);
+    std::memcpy(header + 8, &timestamp, sizeof(timestamp));
+    if (std::fwrite(header, 1, HEADER_SIZE, log.logFile) != HEADER_SIZE ||
+        std::fwrite(text.data(), 1, text.size(), log.logFile) != text.size()) {
+        throw std::runtime_error("Cannot write log segment " + active.basePath + ": " + std::strerror(errno));
+    }
+
+    active.size += HEADER_SIZE + text.size();
+    active.lastTimestamp = std::max(active.lastTimestamp, timestamp);
+    log.maxTimestamp = std::max(log.maxTimestamp, timestamp);
+    log.totalBytes += HEADER_SIZE + text.size();
+}
+
+size_t LogStore::ingest(Container &container, containerTypes::LogCursor &cursor) {
+    size_t stored = 0;
+    const std::string &containerId = container.getId();
+    container.logsSince(cursor, [this, &containerId, &cursor, &stored](containerTypes::LogStream stream, std::string_view line) {
+        append(containerId, stream, line, cursor.lastTimestamp);
+        ++stored;
+    });
+    return stored;
+}
+
+void LogStore::flush() {
+    std::lock_guard lock(mutex);
+    for (auto &[id, log] : logs) {
+        if (log->logFile) std::fflush(log->logFile);
+        if (log->indexFile) std::fflush(log->indexFile);
+    }
+}
+
+bool LogStore::querySegment(const Segment &segment, int64_t from, int64_t to,
+                            std::optional<containerTypes::LogStream> stream, const RecordCallback &callback, size_t &count) const {
+    uint64_t start = 0;
+    std::error_code error;
+    const auto indexSize = std::filesystem::file_size(segment.basePath + ".idx", error);
+    if (!error && indexSize >= INDEX_ENTRY_SIZE) {
+        // Entries hold the running maximum timestamp, so they are sorted: the last entry
+        // whose maximum is still below from is the latest safe place to start scanning
+        MappedFile index(segment.basePath + ".idx", static_cast<size_t>(indexSize));
+        size_t low = 0;
+        size_t high = static_cast<size_t>(indexSize / INDEX_ENTRY_SIZE);
+        while (low < high) {
+            size_t middle = (low + high) / 2;
+            int64_t maxBefore;
+            std::memcpy(&maxBefore, index.data() + middle * INDEX_ENTRY_SIZE, sizeof(maxBefore));
+            if (maxBefore < from) low = middle + 1;
+            else high = middle;
+        }
+        if (low > 0) {
+            std::memcpy(&start, index.data() + (low - 1) * INDEX_ENTRY_SIZE + 8, sizeof(start));
+        }
+    }
+
+    MappedFile file(segment.basePath + ".log", static_cast<size_t>(segment.size));
+    file.sequentialFrom(static_cast<size_t>(start));
+
+    uint64_t offset = start;
+    while (offset + HEADER_SIZE <= segment.size) {
+        uint32_t length;
+        int64_t timestamp;
+        std::memcpy(&length, file.data() + offset, sizeof(length));
+        std::memcpy(&timestamp, file.data() + offset + 8, sizeof(timestamp));
+        if (offset + HEADER_SIZE + length > segment.size) break;
+        if (timestamp > to) return false;
+
+        const auto recordStream = static_cast<containerTypes::LogStream>(file.data()[offset + 4]);
+        if (timestamp >= from && (!stream || *stream == recordStream)) {
+            ++count;
+            if (!callback(StoredLogRecord{timestamp, recordStream, std::string_view(file.data() + offset + HEADER_SIZE, length)})) {
+                return false;
+            }
+        }
+        offset += HEADER_SIZE + length;
+    }
+    return true;
+}
+
+size_t LogStore::query(const std::string &containerId, int64_t from, int64_t to,
+                       std::optional<containerTypes::LogStream> stream, const RecordCallback &callback) {
+    std::vector<Segment> candidates;
+    {
+        std::lock_guard lock(mutex);
+        ContainerLog *log = findLog(containerId);
+        if (!log) return 0;
+        if (log->logFile) std::fflush(log->logFile);
+        if (log->indexFile) std::fflush(log->indexFile);
+        for (const auto &segment : log->segments) {
+            if (segment.lastTimestamp >= from && segment.firstTimestamp <= to) candidates.push_back(segment);
+        }
+    }
+
+    // Segment files are append-only and the copied sizes only cover flushed records,
+    // so they are read without holding the lock
+    size_t count = 0;
+    for (const auto &segment : candidates) {
+        try {
+            if (!querySegment(segment, from, to, stream, callback, count)) break;
+        } catch (const SegmentExpired &) {
+            // Expired since the list was copied; nothing was reported from it yet
+        }
+    }
+    return count;
+}
+
+std::vector<std::string> LogStore::containers() const {
+    std::vector<std::string> ids;
+    for (const auto &entry : std::filesystem::directory_iterator(directory)) {
+        if (entry.is_directory()) ids.push_back(entry.path().filename().string());
+    }
+    return ids;
+}
+
+uint64_t LogStore::diskUsage(const std::string &containerId) {
+    std::lock_guard lock(mutex);
+    const ContainerLog *log = findLog(containerId);
+    return log ? log->totalBytes : 0;
+}
+
+std::pair<int64_t, int64_t> LogStore::timeRange(const std::string &containerId) {
+    std::lock_guard lock(mutex);
+    const ContainerLog *log = findLog(containerId);
+    if (!log || log->segments.empty()) return {0, 0};
+    int64_t last = log->segments.front().lastTimestamp;
+    for (const auto &segment : log->segments) last = std::max(last, segment.lastTimestamp);
+    return {log->segments.front().firstTimestamp, last};
+}
+
+void LogStore::drop(const std::string &containerId) {
+    std::lock_guard lock(mutex);
+    auto it = logs.find(containerId);
+    if (it != logs.end()) {
+        closeSegment(*it->second);
+        logs.erase(it);
+    }
+    if (validContainerId(containerId)) {
+        std::error_code error;
+        std::filesystem::remove_all(std::filesystem::path(directory) / containerId, error);
+    }
+}
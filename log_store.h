@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2025 Nokaji. Tous droits réservés.
+ * Ce fichier fait partie du projet Kernel-James.
+ */
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "types/container_types.h"
+
+class Container;
+
+struct LogStoreOptions {
+    uint64_t maxSegmentBytes = 64ull << 20;             // roll the active segment past this size
+    std::chrono::seconds maxSegmentAge{3600};           // ... or once it has been open this long
+    uint64_t indexInterval = 4096;                      // bytes of records between two index entries
+    uint64_t maxBytesPerContainer = 0;                  // oldest segments are deleted past this, 0 = keep everything
+};
+
+struct StoredLogRecord {
+    int64_t timestamp; // nanoseconds since epoch
+    containerTypes::LogStream stream;
+    std::string_view text; // only valid during the callback
+};
+
+/*
+ * Append-only log history on disk, one directory per container:
+ *   <directory>/<containerId>/<first timestamp>.log   records: u32 length, u8 stream, 3 pad, i64 timestamp, text
+ *   <directory>/<containerId>/<first timestamp>.idx   every indexInterval bytes: i64 max timestamp before, u64 offset
+ * Segments are rolled by size and age. A query picks the segments whose time
+ * span overlaps the range, binary searches their index and maps the log file,
+ * so only the pages holding the requested records are read. Records are
+ * expected in daemon order (non-decreasing timestamps per container).
+ */
+class LogStore
+{
+    public:
+        using RecordCallback = std::function<bool(const StoredLogRecord &record)>; // return false to stop
+
+    private:
+        struct Segment {
+            std::string basePath; // without extension
+            int64_t firstTimestamp = 0;
+            int64_t lastTimestamp = 0;
+            uint64_t size = 0;
+        };
+
+        struct ContainerLog {
+            std::string directory;
+            std::vector<Segment> segments; // oldest first, the last one is active when logFile is open
+            std::FILE *logFile = nullptr;
+            std::FILE *indexFile = nullptr;
+            uint64_t lastIndexedOffset = 0;
+            int64_t maxTimestamp = INT64_MIN;
+            std::chrono::steady_clock::time_point openedAt;
+            uint64_t totalBytes = 0;
+        };
+
+        std::string directory;
+        LogStoreOptions options;
+
+        mutable std::mutex mutex;
+        std::unordered_map<std::string, std::unique_ptr<ContainerLog>> logs;
+
+        ContainerLog &containerLog(const std::string &containerId);
+        // Same lookup for readers: loads a log stored on disk but never creates one; nullptr for unknown ids
+        ContainerLog *findLog(const std::string &containerId);
+        void loadSegments(ContainerLog &log) const;
+        void openSegment(ContainerLog &log, int64_t firstTimestamp);
+        void closeSegment(ContainerLog &log);
+        void enforceRetention(ContainerLog &log);
+        bool querySegment(const Segment &segment, int64_t from, int64_t to,
+                          std::optional<containerTypes::LogStream> stream, const RecordCallback &callback, size_t &count) const;
+
+    public:
+        explicit LogStore(std::string directory, LogStoreOptions options = {});
+        ~LogStore();
+
+        LogStore(const LogStore &) = delete;
+        LogStore &operator=(const LogStore &) = delete;
+
+        // timestamp in nanoseconds since epoch, 0 means now
+        void append(const std::string &containerId, containerTypes::LogStream stream, std::string_view text, int64_t timestamp = 0);
+
+        // Appends the container lines written after cursor (see Container::logsSince);
+        // calling it periodically with the same cursor only transfers new output. Returns the number of lines stored.
+        size_t ingest(Container &container, containerTypes::LogCursor &cursor);
+
+        // Records with from <= timestamp <= to, optionally limited to one stream; returns how many were reported.
+        // Like diskUsage() and timeRange(), creates nothing for a container without stored logs.
+        size_t query(const std::string &containerId, int64_t from, int64_t to,
+                     std::optional<containerTypes::LogStream> stream, const RecordCallback &callback);
+
+        // Makes buffered records visible to queries and durable against a crash of this process
+        void flush();
+
+        [[nodiscard]] std::vector<std::string> containers() const;
+        [[nodiscard]] uint64_t diskUsage(const std::string &containerId);
+
+        // First and last stored timestamps, {0, 0} when nothing is stored
+        [[nodiscard]] std::pair<int64_t, int64_t> timeRange(const std::string &containerId);
+
+        // Closes and deletes the stored history of a container
+        void drop(const std::string &containerId);
+};
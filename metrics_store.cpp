@@ -0,0 +1,388 @@
+/*
+ * Copyright (c) 2025 Nokaji. Tous droits réservés.
+ * Ce fichier fait partie du projet Kernel-James.
+ */
+#include "metrics_store.h"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+namespace {
+    constexpr size_t BLOCK_BYTES = 1024;
+    constexpr uint8_t NO_WINDOW = 0xff;
+    constexpr int64_t NANOSECONDS_PER_MS = 1000000;
+
+    enum Column { MIN, MAX, SUM, COUNT };
+
+    inline uint64_t toBits(double value) {
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+
+    inline double fromBits(uint64_t bits) {
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    int64_t floorTo(int64_t value, int64_t step) {
+        int64_t result = value / step * step;
+        return result > value ? result - step : result;
+    }
+}
+
+MetricsStore::Block::Block(size_t columns) : columns(columns) {
+    previousLeading.fill(NO_WINDOW);
+    words.reserve(BLOCK_BYTES / sizeof(uint64_t) + 4);
+}
+
+void MetricsStore::Block::writeBits(uint64_t value, unsigned bits) {
+    if (bits < 64) value &= (uint64_t(1) << bits) - 1;
+    const unsigned used = static_cast<unsigned>(bitCount & 63);
+    if (used == 0) words.push_back(0);
+    const unsigned free = 64 - used;
+    if (bits <= free) {
+        words.back() |= value << (free - bits);
+    } else {
+        words.back() |= value >> (bits - free);
+        words.push_back(value << (64 - (bits - free)));
+    }
+    bitCount += bits;
+}
+
+void MetricsStore::Block::writeValue(size_t column, double value) {
+    const uint64_t bits = toBits(value);
+    if (count == 0) {
+        writeBits(bits, 64);
+        previousBits[column] = bits;
+        return;
+    }
+
+    const uint64_t delta = bits ^ previousBits[column];
+    previousBits[column] = bits;
+    if (delta == 0) {
+        writeBits(0, 1);
+        return;
+    }
+
+    const unsigned leading = std::min(31, std::countl_zero(delta));
+    const unsigned trailing = static_cast<unsigned>(std::countr_zero(delta));
+    if (previousLeading[column] != NO_WINDOW && leading >= previousLeading[column] && trailing >= previousTrailing[column]) {
+        // Meaningful bits fit in the previous window: no need to repeat its position
+        writeBits(0b10, 2);
+        writeBits(delta >> previousTrailing[column], 64 - previousLeading[column] - previousTrailing[column]);
+    } else {
+        const unsigned length = 64 - leading - trailing;
+        writeBits(0b11, 2);
+        writeBits(leading, 5);
+        writeBits(length - 1, 6);
+        writeBits(delta >> trailing, length);
+        previousLeading[column] = static_cast<uint8_t>(leading);
+        previousTrailing[column] = static_cast<uint8_t>(trailing);
+    }
+}
+
+void MetricsStore::Block::append(int64_t timestamp, const double *values) {
+    if (count == 0) {
+        writeBits(static_cast<uint64_t>(timestamp), 64);
+        firstTimestamp = timestamp;
+    } else {
+        const int64_t delta = timestamp - previousTimestamp;
+        const int64_t deltaOfDelta = delta - previousDelta;
+        previousDelta = delta;
+        if (deltaOfDelta == 0) {
+            writeBits(0, 1);
+        } else if (deltaOfDelta >= -63 && deltaOfDelta <= 64) {
+            writeBits(0b10, 2);
+            writeBits(static_cast<uint64_t>(deltaOfDelta + 63), 7);
+        } else if (deltaOfDelta >= -255 && deltaOfDelta <= 256) {
+            writeBits(0b110, 3);
+            writeBits(static_cast<uint64_t>(deltaOfDelta + 255), 9);
+        } else if (deltaOfDelta >= -2047 && deltaOfDelta <= 2048) {
+            writeBits(0b1110, 4);
+            writeBits(static_cast<uint64_t>(deltaOfDelta + 2047), 12);
+        } else {
+            writeBits(0b1111, 4);
+            writeBits(static_cast<uint64_t>(deltaOfDelta), 64);
+        }
+    }
+    previousTimestamp = timestamp;
+
+    for (size_t column = 0; column < columns; ++column) writeValue(column, values[column]);
+
+    lastTimestamp = std::max(lastTimestamp, timestamp);
+    ++count;
+}
+
+bool MetricsStore::Block::full() const {
+    return words.size() * sizeof(uint64_t) >= BLOCK_BYTES;
+}
+
+template <typename F>
+void MetricsStore::Block::decode(F &&visit) const {
+    size_t position = 0;
+    const uint64_t *data = words.data();
+    auto read = [&position, data](unsigned bits) -> uint64_t {
+        const size_t word = position >> 6;
+        const unsigned offset = static_cast<unsigned>(position & 63);
+        uint64_t result = data[word] << offset;
+        if (offset + bits > 64) result |= data[word + 1] >> (64 - offset);
+        position += bits;
+        return result >> (64 - bits);
+    };
+
+    int64_t timestamp = 0;
+    int64_t delta = 0;
+    std::array<uint64_t, MAX_COLUMNS> bits{};
+    std::array<unsigned, MAX_COLUMNS> leading{};
+    std::array<unsigned, MAX_COLUMNS> trailing{};
+    double values[MAX_COLUMNS];
+
+    for (uint32_t i = 0; i < count; ++i) {
+        if (i == 0) {
+            timestamp = static_cast<int64_t>(read(64));
+        } else {
+            int64_t deltaOfDelta;
+            if (!read(1)) deltaOfDelta = 0;
+            else if (!read(1)) deltaOfDelta = static_cast<int64_t>(read(7)) - 63;
+            else if (!read(1)) deltaOfDelta = static_cast<int64_t>(read(9)) - 255;
+            else if (!read(1)) deltaOfDelta = static_cast<int64_t>(read(12)) - 2047;
+            else deltaOfDelta = static_cast<int64_t>(read(64));
+            delta += deltaOfDelta;
+            timestamp += delta;
+        }
+
+        for (size_t column = 0; column < columns; ++column) {
+            if (i == 0) {
+                bits[column] = read(64);
+            } else if (read(1)) {
+                if (read(1)) {
+                    leading[column] = static_cast<unsigned>(read(5));
+                    const unsigned length = static_cast<unsigned>(read(6)) + 1;
+                    trailing[column] = 64 - leading[column] - length;
+                }
+                const unsigned length = 64 - leading[column] - trailing[column];
+                bits[column] ^= read(length) << trailing[column];
+            }
+            values[column] = fromBits(bits[column]);
+        }
+
+        if (!visit(timestamp, values)) return;
+    }
+}
+
+MetricsStore::MetricsStore(MetricsStoreOptions options) : options(options) {}
+
+std::shared_ptr<MetricsStore::Series> MetricsStore::seriesFor(const std::string &containerId, const std::string &metric) {
+    {
+        std::shared_lock lock(mutex);
+        auto it = series.find({containerId, metric});
+        if (it != series.end()) return it->second;
+    }
+
+    std::unique_lock lock(mutex);
+    auto &slot = series[{containerId, metric}];
+    if (!slot) {
+        slot = std::make_shared<Series>();
+        const auto ms = [](std::chrono::seconds seconds) { return static_cast<int64_t>(seconds.count()) * 1000; };
+        slot->tiers[0].bucket = 0;
+        slot->tiers[0].retention = ms(options.rawRetention);
+        slot->tiers[0].columns = 1;
+        slot->tiers[1].bucket = 10 * 1000;
+        slot->tiers[1].retention = ms(options.tenSecondRetention);
+        slot->tiers[1].columns = MAX_COLUMNS;
+        slot->tiers[2].bucket = 60 * 1000;
+        slot->tiers[2].retention = ms(options.minuteRetention);
+        slot->tiers[2].columns = MAX_COLUMNS;
+    }
+    return slot;
+}
+
+std::shared_ptr<MetricsStore::Series> MetricsStore::find(const std::string &containerId, const std::string &metric) const {
+    std::shared_lock lock(mutex);
+    auto it = series.find({containerId, metric});
+    return it != series.end() ? it->second : nullptr;
+}
+
+void MetricsStore::appendToTier(Series &series, size_t tierIndex, int64_t timestamp, const double *values) {
+    Tier &tier = series.tiers[tierIndex];
+    if (tier.blocks.empty() || tier.blocks.back().full()) {
+        if (!tier.blocks.empty()) tier.blocks.back().seal();
+        tier.blocks.emplace_back(tier.columns);
+    }
+    tier.blocks.back().append(timestamp, values);
+
+    // Whole blocks expire at once, the active one never does
+    const int64_t horizon = timestamp - tier.retention;
+    size_t expired = 0;
+    while (expired + 1 < tier.blocks.size() && tier.blocks[expired].lastTimestamp < horizon) ++expired;
+    tier.blocks.erase(tier.blocks.begin(), tier.blocks.begin() + static_cast<std::ptrdiff_t>(expired));
+}
+
+void MetricsStore::rollup(Series &series, size_t tierIndex, int64_t timestamp, const double *values) {
+    Tier &tier = series.tiers[tierIndex];
+    const int64_t bucket = floorTo(timestamp, tier.bucket);
+
+    if (tier.pendingBucket != INT64_MIN && bucket > tier.pendingBucket) {
+        // The bucket is complete: store it and feed it to the coarser tier
+        const int64_t completed = tier.pendingBucket;
+        const auto pending = tier.pending;
+        appendToTier(series, tierIndex, completed, pending.data());
+        if (tierIndex + 1 < series.tiers.size()) rollup(series, tierIndex + 1, completed, pending.data());
+        tier.pendingBucket = INT64_MIN;
+    }
+
+    if (tier.pendingBucket == INT64_MIN) {
+        tier.pendingBucket = bucket;
+        std::copy(values, values + MAX_COLUMNS, tier.pending.begin());
+    } else {
+        // Same bucket (or a late point, folded into the current one)
+        tier.pending[MIN] = std::min(tier.pending[MIN], values[MIN]);
+        tier.pending[MAX] = std::max(tier.pending[MAX], values[MAX]);
+        tier.pending[SUM] += values[SUM];
+        tier.pending[COUNT] += values[COUNT];
+    }
+}
+
+void MetricsStore::append(const std::string &containerId, const std::string &metric, int64_t timestamp, double value) {
+    auto target = seriesFor(containerId, metric);
+    const int64_t ms = floorTo(timestamp, NANOSECONDS_PER_MS) / NANOSECONDS_PER_MS;
+
+    std::lock_guard lock(target->mutex);
+    appendToTier(*target, 0, ms, &value);
+    const double point[MAX_COLUMNS] = {value, value, value, 1.0};
+    rollup(*target, 1, ms, point);
+}
+
+void MetricsStore::record(const std::string &containerId, const statsTypes::ContainerMetrics &metrics) {
+    const int64_t timestamp = metrics.timestamp;
+    append(containerId, "cpu", timestamp, metrics.cpuPercent);
+    append(containerId, "memory", timestamp, static_cast<double>(metrics.memoryWorkingSet));
+    append(containerId, "memory_percent", timestamp, metrics.memoryPercent);
+    append(containerId, "net_rx", timestamp, metrics.networkRxRate);
+    append(containerId, "net_tx", timestamp, metrics.networkTxRate);
+    append(containerId, "block_read", timestamp, metrics.blockReadRate);
+    append(containerId, "block_write", timestamp, metrics.blockWriteRate);
+    append(containerId, "pids", timestamp, static_cast<double>(metrics.pids));
+}
+
+size_t MetricsStore::chooseTier(const Series &target, Resolution resolution, int64_t from) const {
+    switch (resolution) {
+        case Resolution::Raw: return 0;
+        case Resolution::TenSeconds: return 1;
+        case Resolution::Minute: return 2;
+        case Resolution::Auto: break;
+    }
+    for (size_t tier = 0; tier < target.tiers.size(); ++tier) {
+        const auto &blocks = target.tiers[tier].blocks;
+        if (!blocks.empty() && blocks.front().firstTimestamp <= from) return tier;
+    }
+    // Nothing goes back that far: the coarsest tier holding data goes back the furthest
+    for (size_t tier = target.tiers.size(); tier-- > 0;) {
+        if (!target.tiers[tier].blocks.empty()) return tier;
+    }
+    return 0;
+}
+
+size_t MetricsStore::range(const std::string &containerId, const std::string &metric, int64_t from, int64_t to,
+                           const PointCallback &callback, Resolution resolution) const {
+    auto target = find(containerId, metric);
+    if (!target) return 0;
+
+    const int64_t fromMs = floorTo(from, NANOSECONDS_PER_MS) / NANOSECONDS_PER_MS;
+    const int64_t toMs = floorTo(to, NANOSECONDS_PER_MS) / NANOSECONDS_PER_MS;
+    size_t count = 0;
+
+    std::lock_guard lock(target->mutex);
+    const Tier &tier = target->tiers[chooseTier(*target, resolution, fromMs)];
+    const bool rolled = tier.columns > 1;
+
+    auto emit = [&](int64_t timestamp, const double *values) {
+        if (timestamp < fromMs || timestamp > toMs) return;
+        callback(timestamp * NANOSECONDS_PER_MS, rolled ? values[SUM] / values[COUNT] : values[0]);
+        ++count;
+    };
+
+    for (const auto &block : tier.blocks) {
+        if (block.lastTimestamp < fromMs || block.firstTimestamp > toMs) continue;
+        block.decode([&](int64_t timestamp, const double *values) {
+            if (timestamp > toMs) return false;
+            emit(timestamp, values);
+            return true;
+        });
+    }
+    if (rolled && tier.pendingBucket != INT64_MIN) emit(tier.pendingBucket, tier.pending.data());
+    return count;
+}
+
+MetricAggregate MetricsStore::aggregate(const std::string &containerId, const std::string &metric, int64_t from, int64_t to,
+                                        Resolution resolution) const {
+    MetricAggregate result;
+    auto target = find(containerId, metric);
+    if (!target) return result;
+
+    const int64_t fromMs = floorTo(from, NANOSECONDS_PER_MS) / NANOSECONDS_PER_MS;
+    const int64_t toMs = floorTo(to, NANOSECONDS_PER_MS) / NANOSECONDS_PER_MS;
+
+    std::lock_guard lock(target->mutex);
+    const Tier &tier = target->tiers[chooseTier(*target, resolution, fromMs)];
+    const bool rolled = tier.columns > 1;
+
+    auto add = [&](int64_t timestamp, const double *values) {
+        if (timestamp < fromMs || timestamp > toMs) return;
+        if (rolled) {
+            result.min = std::min(result.min, values[MIN]);
+            result.max = std::max(result.max, values[MAX]);
+            result.sum += values[SUM];
+            result.count += static_cast<uint64_t>(values[COUNT]);
+            result.last = values[SUM] / values[COUNT];
+        } else {
+            result.min = std::min(result.min, values[0]);
+            result.max = std::max(result.max, values[0]);
+            result.sum += values[0];
+            ++result.count;
+            result.last = values[0];
+        }
+        result.lastTimestamp = timestamp * NANOSECONDS_PER_MS;
+    };
+
+    for (const auto &block : tier.blocks) {
+        if (block.lastTimestamp < fromMs || block.firstTimestamp > toMs) continue;
+        block.decode([&](int64_t timestamp, const double *values) {
+            if (timestamp > toMs) return false;
+            add(timestamp, values);
+            return true;
+        });
+    }
+    if (rolled && tier.pendingBucket != INT64_MIN) add(tier.pendingBucket, tier.pending.data());
+    return result;
+}
+
+std::vector<std::string> MetricsStore::metrics(const std::string &containerId) const {
+    std::shared_lock lock(mutex);
+    std::vector<std::string> names;
+    for (auto it = series.lower_bound({containerId, ""}); it != series.end() && it->first.first == containerId; ++it) {
+        names.push_back(it->first.second);
+    }
+    return names;
+}
+
+void MetricsStore::drop(const std::string &containerId) {
+    std::unique_lock lock(mutex);
+    auto it = series.lower_bound({containerId, ""});
+    while (it != series.end() && it->first.first == containerId) it = series.erase(it);
+}
+
+size_t MetricsStore::memoryUsage() const {
+    std::shared_lock lock(mutex);
+    size_t total = 0;
+    for (const auto &[key, target] : series) {
+        std::lock_guard seriesLock(target->mutex);
+        total += sizeof(Series) + key.first.size() + key.second.size();
+        for (const auto &tier : target->tiers) {
+            for (const auto &block : tier.blocks) total += block.memoryUsage();
+        }
+    }
+    return total;
+}
@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2025 Nokaji. Tous droits réservés.
+ * Ce fichier fait partie du projet Kernel-James.
+ */
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+#include "types/stats_types.h"
+
+struct MetricsStoreOptions {
+    std::chrono::seconds rawRetention{3600};                // 1 s points
+    std::chrono::seconds tenSecondRetention{24 * 3600};     // 10 s rollups
+    std::chrono::seconds minuteRetention{7 * 24 * 3600};    // 1 min rollups
+};
+
+struct MetricAggregate {
+    double min = std::numeric_limits<double>::infinity();
+    double max = -std::numeric_limits<double>::infinity();
+    double sum = 0;
+    uint64_t count = 0;
+    double last = 0;
+    int64_t lastTimestamp = 0;
+
+    [[nodiscard]] double average() const { return count ? sum / static_cast<double>(count) : 0; }
+};
+
+/*
+ * Per container and metric time series, compressed as in Facebook's Gorilla:
+ * timestamps as delta of delta, values XORed with the previous one, bit-packed
+ * into ~1 KiB blocks. Points are rolled up into 10 s and 1 min tiers (min, max,
+ * sum, count per bucket) and each tier drops whole blocks past its retention.
+ * Timestamps are nanoseconds since epoch in the API, stored at millisecond
+ * precision; points are expected in time order per series.
+ */
+class MetricsStore
+{
+    public:
+        enum class Resolution {
+            Auto,       // finest tier still holding the start of the range
+            Raw,
+            TenSeconds,
+            Minute
+        };
+
+        using PointCallback = std::function<void(int64_t timestamp, double value)>;
+
+    private:
+        static constexpr size_t MAX_COLUMNS = 4; // rollups keep min, max, sum and count
+
+        class Block
+        {
+            private:
+                std::vector<uint64_t> words;
+                size_t bitCount = 0;
+                size_t columns;
+
+                // Encoder state
+                int64_t previousTimestamp = 0;
+                int64_t previousDelta = 0;
+                std::array<uint64_t, MAX_COLUMNS> previousBits{};
+                std::array<uint8_t, MAX_COLUMNS> previousLeading{};
+                std::array<uint8_t, MAX_COLUMNS> previousTrailing{};
+
+                void writeBits(uint64_t value, unsigned bits);
+                void writeValue(size_t column, double value);
+
+            public:
+                int64_t firstTimestamp = 0;
+                int64_t lastTimestamp = 0;
+                uint32_t count = 0;
+
+                explicit Block(size_t columns);
+
+                void append(int64_t timestamp, const double *values);
+                [[nodiscard]] bool full() const;
+                void seal() { words.shrink_to_fit(); }
+                [[nodiscard]] size_t memoryUsage() const { return sizeof(Block) + words.capacity() * sizeof(uint64_t); }
+
+                // Calls visit(timestamp, values) for every point, in order; return false to stop
+                template <typename F>
+                void decode(F &&visit) const;
+        };
+
+        struct Tier {
+            int64_t bucket;                 // ms, 0 for raw points
+            int64_t retention;              // ms
+            size_t columns;
+            std::vector<Block> blocks;
+
+            // Rollup being accumulated for the current bucket
+            int64_t pendingBucket = INT64_MIN;
+            std::array<double, MAX_COLUMNS> pending{};
+        };
+
+        struct Series {
+            std::mutex mutex;
+            std::array<Tier, 3> tiers;
+        };
+
+        MetricsStoreOptions options;
+        mutable std::shared_mutex mutex;
+        std::map<std::pair<std::string, std::string>, std::shared_ptr<Series>> series;
+
+        std::shared_ptr<Series> seriesFor(const std::string &containerId, const std::string &metric);
+        std::shared_ptr<Series> find(const std::string &containerId, const std::string &metric) const;
+        void appendToTier(Series &series, size_t tier, int64_t timestamp, const double *values);
+        void rollup(Series &series, size_t tier, int64_t timestamp, const double *values);
+        size_t chooseTier(const Series &series, Resolution resolution, int64_t from) const;
+
+    public:
+        explicit MetricsStore(MetricsStoreOptions options = {});
+
+        void append(const std::string &containerId, const std::string &metric, int64_t timestamp, double value);
+
+        // cpu, memory, memory_percent, net_rx, net_tx, block_read, block_write, pids
+        void record(const std::string &containerId, const statsTypes::ContainerMetrics &metrics);
+
+        // Points in [from, to]; rollup tiers report the bucket average
+        size_t range(const std::string &containerId, const std::string &metric, int64_t from, int64_t to,
+                     const PointCallback &callback, Resolution resolution = Resolution::Auto) const;
+
+        [[nodiscard]] MetricAggregate aggregate(const std::string &containerId, const std::string &metric, int64_t from, int64_t to,
+                                                Resolution resolution = Resolution::Auto) const;
+
+        [[nodiscard]] std::vector<std::string> metrics(const std::string &containerId) const;
+        void drop(const std::string &containerId);
+
+        [[nodiscard]] size_t memoryUsage() const;
+};
@@ -11,8 +11,99 @@
 #include <nlohmann/json.hpp>
 #include <iostream>
 #include <algorithm>
+#include <array>
 #include <cctype>
+#include <cstdint>
 #include <functional>
+#include "parallel.h"
+
+namespace {
+    struct Subnet {
+        bool ipv6 = false;
+        std::array<uint8_t, 16> address{};
+        int prefix = 0;
+    };
+
+    bool parseIPv4(const std::string &text, uint8_t *bytes) {
+        int part = 0;
+        size_t position = 0;
+        while (true) {
+            size_t end = text.find('.', position);
+            if (end == std::string::npos) end = text.size();
+            const std::string digits = text.substr(position, end - position);
+            if (part == 4 || digits.empty() || digits.size() > 3 || !std::all_of(digits.begin(), digits.end(), ::isdigit)) return false;
+            const int value = std::stoi(digits);
+            if (value > 255) return false;
+            bytes[part++] = static_cast<uint8_t>(value);
+            if (end == text.size()) return part == 4;
+            position = end + 1;
+        }
+    }
+
+    // Hex groups, with at most one "::"; an embedded IPv4 tail is not supported
+    bool parseIPv6(const std::string &text, uint8_t *bytes) {
+        auto parseGroups = [](const std::string &part, std::vector<uint16_t> &groups) {
+            if (part.empty()) return true;
+            size_t position = 0;
+            while (true) {
+                size_t end = part.find(':', position);
+                if (end == std::string::npos) end = part.size();
+                const std::string digits = part.substr(position, end - position);
+                if (digits.empty() || digits.size() > 4 || !std::all_of(digits.begin(), digits.end(), ::isxdigit)) return false;
+                groups.push_back(static_cast<uint16_t>(std::stoul(digits, nullptr, 16)));
+                if (end == part.size()) return true;
+                position = end + 1;
+            }
+        };
+
+        std::vector<uint16_t> head;
+        std::vector<uint16_t> tail;
+        const size_t gap = text.find("::");
+        if (gap == std::string::npos) {
+            if (!parseGroups(text, head) || head.size() != 8) return false;
+        } else {
+            if (text.find("::", gap + 1) != std::string::npos) return false;
+            if (!parseGroups(text.substr(0, gap), head) || !parseGroups(text.substr(gap + 2), tail) ||
+                head.size() + tail.size() > 7) {
+                return false;
+            }
+        }
+
+        std::array<uint16_t, 8> groups{};
+        std::copy(head.begin(), head.end(), groups.begin());
+        std::copy(tail.begin(), tail.end(), groups.end() - static_cast<std::ptrdiff_t>(tail.size()));
+        for (size_t i = 0; i < groups.size(); ++i) {
+            bytes[2 * i] = static_cast<uint8_t>(groups[i] >> 8);
+            bytes[2 * i + 1] = static_cast<uint8_t>(groups[i]);
+        }
+        return true;
+    }
+
+    // "10.1.0.0/16", "fd00::/64"
+    bool parseSubnet(const std::string &text, Subnet &subnet) {
+        const size_t slash = text.find('/');
+        if (slash == std::string::npos || slash + 1 == text.size()) return false;
+        const std::string address = text.substr(0, slash);
+        const std::string prefix = text.substr(slash + 1);
+        if (prefix.size() > 3 || !std::all_of(prefix.begin(), prefix.end(), ::isdigit)) return false;
+
+        subnet.ipv6 = address.find(':') != std::string::npos;
+        subnet.prefix = std::stoi(prefix);
+        if (subnet.prefix > (subnet.ipv6 ? 128 : 32)) return false;
+        return subnet.ipv6 ? parseIPv6(address, subnet.address.data()) : parseIPv4(address, subnet.address.data());
+    }
+
+    // Two prefixes overlap when they agree on the bits of the shorter one
+    bool subnetsOverlap(const Subnet &a, const Subnet &b) {
+        if (a.ipv6 != b.ipv6) return false;
+        const int bits = std::min(a.prefix, b.prefix);
+        const int bytes = bits / 8;
+        if (!std::equal(a.address.begin(), a.address.begin() + bytes, b.address.begin())) return false;
+        if (bits % 8 == 0) return true;
+        const auto mask = static_cast<uint8_t>(0xff << (8 - bits % 8));
+        return (a.address[bytes] & mask) == (b.address[bytes] & mask);
+    }
+}
 
 NetworkManager::NetworkManager(std::shared_ptr<DockerClient> dockerClient) : dockerClient(dockerClient) {
     if (!this->dockerClient) {
@@ -122,15 +213,75 @@ bool NetworkManager::createFromCompose(const std::string &composeFilePath)
         throw std::runtime_error("No networks found in the compose file.");
     }
 
+    return createFromCompose(networks);
+}
+
+bool NetworkManager::createFromCompose(const std::map<std::string, networkTypes::NetworkCompose> &networks, size_t concurrency)
+{
     try {
+        // One request answers existence for every network and gives the subnets already taken
+        const std::vector<networkTypes::NetworkListResponse> existing = list();
+        std::map<std::string, const networkTypes::NetworkListResponse *> byName;
+        std::vector<std::pair<std::string, Subnet>> taken;     // owner, subnet
+        for (const auto &network : existing) {
+            byName.emplace(network.name, &network);
+            for (const auto &ipamConfig : network.ipam.config) {
+                Subnet subnet;
+                if (parseSubnet(ipamConfig.subnet, subnet)) taken.emplace_back(network.name, subnet);
+            }
+        }
+
+        bool success = true;
+        std::vector<const std::pair<const std::string, networkTypes::NetworkCompose> *> missing;
         for (const auto &networkPair : networks) {
-            if (exists(networkPair.first)) {
+            const bool found = byName.contains(networkPair.first);
+            if (networkPair.second.external) {
+                if (!found) {
+                    std::cerr << "External network does not exist: " << networkPair.first << std::endl;
+                    success = false;
+                }
+                continue; // External networks are never created
+            }
+            if (found) {
                 std::cout << "Network already exists: " << networkPair.first << std::endl;
                 continue; // Skip if the network already exists
             }
-            const std::string &networkName = networkPair.first;
-            const networkTypes::NetworkCompose &networkConfig = networkPair.second;
-            
+            missing.push_back(&networkPair);
+        }
+
+        // Subnets are checked before anything is sent: a conflict creates nothing
+        std::vector<std::string> conflicts;
+        for (const auto *networkPair : missing) {
+            for (const auto &ipamConfig : networkPair->second.ipam.config) {
+                if (ipamConfig.subnet.empty()) continue;
+                Subnet subnet;
+                if (!parseSubnet(ipamConfig.subnet, subnet)) {
+                    conflicts.push_back(fmt::format("invalid subnet {} for network {}", ipamConfig.subnet, networkPair->first));
+                    continue;
+                }
+                const auto overlap = std::find_if(taken.begin(), taken.end(), [&subnet](const auto &other) {
+                    return subnetsOverlap(subnet, other.second);
+                });
+                if (overlap != taken.end()) {
+                    conflicts.push_back(fmt::format("subnet {} of network {} overlaps network {}", ipamConfig.subnet,
+                                                    networkPair->first, overlap->first));
+                    continue;
+                }
+                taken.emplace_back(networkPair->first, subnet);
+            }
+        }
+        if (!conflicts.empty()) {
+            for (const auto &conflict : conflicts) {
+                std::cerr << "Cannot create networks from compose file: " << conflict << std::endl;
+            }
+            return false;
+        }
+
+        std::vector<std::string> errors(missing.size());
+        parallelFor(missing.size(), std::max<size_t>(1, concurrency), [&](size_t index) {
+            const std::string &networkName = missing[index]->first;
+            const networkTypes::NetworkCompose &networkConfig = missing[index]->second;
+
             // Create basic network configuration
             networkTypes::NetworkConfig config;
             config.name = networkName;
@@ -138,27 +289,36 @@ bool NetworkManager::createFromCompose(const std::string &composeFilePath)
             config.internal = networkConfig.internal;
             config.attachable = networkConfig.attachable;
             config.enable_ipv6 = networkConfig.enable_ipv6;
-            
+
             // Basic IPAM configuration
             config.ipam.driver = networkConfig.ipam.driver.empty() ? "default" : networkConfig.ipam.driver;
-            
+
             // If there's IPAM configuration in the compose file, add it to the config array
             if (!networkConfig.ipam.config.empty()) {
                 config.ipam.config = networkConfig.ipam.config;
             }
-            
-            std::map<std::string, std::string> response = create(config);
 
-            if (response.empty()) {
-                std::cerr << "Failed to create network: " << networkName << std::endl;
-                continue; // Skip to next network if creation fails
+            try {
+                std::map<std::string, std::string> response = create(config);
+                if (response.empty()) {
+                    errors[index] = "empty response";
+                }
+            } catch (const std::exception &e) {
+                errors[index] = e.what();
             }
+        });
 
-            std::cout << "Network created: " << networkName << " with ID: " << response["Id"] << std::endl;
+        for (size_t i = 0; i < missing.size(); ++i) {
+            if (errors[i].empty()) {
+                std::cout << "Network created: " << missing[i]->first << std::endl;
+            } else {
+                std::cerr << "Failed to create network " << missing[i]->first << ": " << errors[i] << std::endl;
+                success = false;
+            }
         }
 
-        std::cout << "Networks created successfully from compose file." << std::endl;
-        return true;
+        if (success) std::cout << "Networks created successfully from compose file." << std::endl;
+        return success;
     } catch (const std::exception &e) {
         std::cerr << "Exception while creating networks from compose file: " << e.what() << std::endl;
         return false;
@@ -194,8 +354,8 @@ void NetworkManager::connect(const std::string &networkId, const std::string &co
     request.setHeader("Content-Type: application/json");
 
     nlohmann::json connectJson = {
-        {"Container", containerId,
-        "EndpointConfig", endpointConfig}
+        {"Container", containerId},
+        {"EndpointConfig", endpointConfig}
     };
     request.setBody(connectJson.dump());
 
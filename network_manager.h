@@ -31,6 +31,10 @@ class NetworkManager
 
         std::map<std::string, std::string> create(const networkTypes::NetworkConfig &config);
         bool createFromCompose(const std::string &composeFilePath);
+        // Same from an already parsed compose file. Existence comes from one list(): missing networks are
+        // created concurrently, external ones must already exist. IPAM subnets overlapping each other or an
+        // existing network are refused before anything is created.
+        bool createFromCompose(const std::map<std::string, networkTypes::NetworkCompose> &networks, size_t concurrency = 8);
         void connect(const std::string &networkId, const std::string &containerId, networkTypes::EndpointConfigNetwork &endpointConfig);
         void disconnect(const std::string &networkId, const std::string &containerId, bool force = false);
 
@@ -0,0 +1,364 @@
+/*
+ * Copyright (c) 2025 Nokaji. Tous droits réservés.
+ * Ce fichier fait partie du projet Kernel-James.
+ */
+#include "network_topology.h"
+#include "docker.h"
+#include "network_manager.h"
+#include "container_manager.h"
+#include <algorithm>
+#include <cctype>
+#include <iostream>
+#include <mutex>
+
+namespace {
+    std::string endpointKey(const std::string &networkId, const std::string &containerId) {
+        return networkId + '/' + containerId;
+    }
+
+    // "172.18.0.23/16" -> "172.18.0.23"
+    std::string stripPrefix(const std::string &address) {
+        auto slash = address.find('/');
+        return slash == std::string::npos ? address : address.substr(0, slash);
+    }
+
+    std::string normalizeMac(std::string mac) {
+        std::transform(mac.begin(), mac.end(), mac.begin(), [](unsigned char c) { return std::tolower(c); });
+        return mac;
+    }
+
+    std::string stripSlash(const std::string &name) {
+        return !name.empty() && name[0] == '/' ? name.substr(1) : name;
+    }
+
+    std::string attribute(const nlohmann::json &actor, const char *key) {
+        if (!actor.contains("Attributes") || !actor["Attributes"].is_object()) return "";
+        const auto &attributes = actor["Attributes"];
+        return attributes.contains(key) && attributes[key].is_string() ? attributes[key].get<std::string>() : "";
+    }
+}
+
+void NetworkTopology::Index::insertEndpoint(TopologyEndpoint endpoint) {
+    endpoint.ipv4Address = stripPrefix(endpoint.ipv4Address);
+    endpoint.ipv6Address = stripPrefix(endpoint.ipv6Address);
+    endpoint.macAddress = normalizeMac(endpoint.macAddress);
+
+    eraseEndpoint(endpoint.networkId, endpoint.containerId);
+
+    const std::string key = endpointKey(endpoint.networkId, endpoint.containerId);
+    if (!endpoint.ipv4Address.empty()) byIp[endpoint.ipv4Address] = key;
+    if (!endpoint.ipv6Address.empty()) byIp[endpoint.ipv6Address] = key;
+    if (!endpoint.macAddress.empty()) byMac[endpoint.macAddress] = key;
+
+    networksByContainer[endpoint.containerId].insert(endpoint.networkId);
+    containersByNetwork[endpoint.networkId].insert(endpoint.containerId);
+
+    if (!endpoint.networkName.empty()) {
+        networkNames[endpoint.networkId] = endpoint.networkName;
+        networkIds[endpoint.networkName] = endpoint.networkId;
+    }
+    if (!endpoint.containerName.empty()) {
+        containerNames[endpoint.containerId] = endpoint.containerName;
+        containerIds[endpoint.containerName] = endpoint.containerId;
+    }
+
+    endpoints[key] = std::move(endpoint);
+}
+
+void NetworkTopology::Index::eraseEndpoint(const std::string &networkId, const std::string &containerId) {
+    auto it = endpoints.find(endpointKey(networkId, containerId));
+    if (it == endpoints.end()) return;
+
+    const TopologyEndpoint &old = it->second;
+    // Only drop reverse entries that still point at this endpoint
+    for (const auto &ip : {old.ipv4Address, old.ipv6Address}) {
+        auto ipIt = byIp.find(ip);
+        if (ipIt != byIp.end() && ipIt->second == it->first) byIp.erase(ipIt);
+    }
+    auto macIt = byMac.find(old.macAddress);
+    if (macIt != byMac.end() && macIt->second == it->first) byMac.erase(macIt);
+
+    auto containerIt = networksByContainer.find(containerId);
+    if (containerIt != networksByContainer.end()) {
+        containerIt->second.erase(networkId);
+        if (containerIt->second.empty()) networksByContainer.erase(containerIt);
+    }
+    auto networkIt = containersByNetwork.find(networkId);
+    if (networkIt != containersByNetwork.end()) {
+        networkIt->second.erase(containerId);
+        if (networkIt->second.empty()) containersByNetwork.erase(networkIt);
+    }
+
+    endpoints.erase(it);
+}
+
+void NetworkTopology::Index::eraseNetwork(const std::string &networkId) {
+    auto it = containersByNetwork.find(networkId);
+    if (it != containersByNetwork.end()) {
+        const auto members = it->second;
+        for (const auto &containerId : members) {
+            eraseEndpoint(networkId, containerId);
+        }
+    }
+    auto nameIt = networkNames.find(networkId);
+    if (nameIt != networkNames.end()) {
+        networkIds.erase(nameIt->second);
+        networkNames.erase(nameIt);
+    }
+}
+
+void NetworkTopology::Index::eraseContainer(const std::string &containerId) {
+    auto it = networksByContainer.find(containerId);
+    if (it != networksByContainer.end()) {
+        const auto networks = it->second;
+        for (const auto &networkId : networks) {
+            eraseEndpoint(networkId, containerId);
+        }
+    }
+    auto nameIt = containerNames.find(containerId);
+    if (nameIt != containerNames.end()) {
+        containerIds.erase(nameIt->second);
+        containerNames.erase(nameIt);
+    }
+}
+
+NetworkTopology::NetworkTopology(std::shared_ptr<DockerClient> client) : dockerClient(client) {
+    if (!this->dockerClient) {
+        throw std::runtime_error("Docker client is not initialized.");
+    }
+}
+
+void NetworkTopology::rebuild() {
+    NetworkManager networkManager(dockerClient);
+    ContainerManager containerManager(dockerClient);
+
+    auto networks = networkManager.list();
+    auto containers = containerManager.list(true);
+
+    // Build the new index outside the lock, readers keep using the old one meanwhile
+    Index fresh;
+    for (const auto &network : networks) {
+        fresh.networkNames[network.id] = network.name;
+        fresh.networkIds[network.name] = network.id;
+
+        // /networks only fills Containers for some drivers, take whatever is there
+        for (const auto &[containerId, member] : network.containers) {
+            TopologyEndpoint endpoint;
+            endpoint.networkId = network.id;
+            endpoint.networkName = network.name;
+            endpoint.containerId = containerId;
+            endpoint.containerName = stripSlash(member.name);
+            endpoint.endpointId = member.endpoint_id;
+            endpoint.macAddress = member.mac_address;
+            endpoint.ipv4Address = member.ipv4_address;
+            endpoint.ipv6Address = member.ipv6_address;
+            fresh.insertEndpoint(std::move(endpoint));
+        }
+    }
+
+    for (const auto &container : containers) {
+        fresh.containerNames[container.id] = container.name;
+        fresh.containerIds[container.name] = container.id;
+
+        for (const auto &[networkName, info] : container.networks) {
+            std::string networkId = info.networkId;
+            if (networkId.empty()) {
+                auto idIt = fresh.networkIds.find(networkName);
+                if (idIt == fresh.networkIds.end()) continue;
+                networkId = idIt->second;
+            }
+
+            TopologyEndpoint endpoint;
+            endpoint.networkId = networkId;
+            endpoint.networkName = networkName;
+            endpoint.containerId = container.id;
+            endpoint.containerName = container.name;
+            endpoint.endpointId = info.endpointId;
+            endpoint.macAddress = info.macAddress;
+            endpoint.ipv4Address = info.ipAddress;
+
+            // Keep the IPv6 address the network listing may have given us
+            auto existing = fresh.endpoints.find(endpointKey(networkId, container.id));
+            if (existing != fresh.endpoints.end()) {
+                endpoint.ipv6Address = existing->second.ipv6Address;
+            }
+            fresh.insertEndpoint(std::move(endpoint));
+        }
+    }
+
+    std::unique_lock lock(mutex);
+    index = std::move(fresh);
+}
+
+void NetworkTopology::refreshNetwork(const std::string &networkIdOrName) {
+    NetworkManager networkManager(dockerClient);
+    auto network = networkManager.inspect(networkIdOrName);
+    if (!network) {
+        throw std::runtime_error("Failed to refresh network: " + networkIdOrName);
+    }
+
+    std::unique_lock lock(mutex);
+    index.eraseNetwork(network->id);
+    index.networkNames[network->id] = network->name;
+    index.networkIds[network->name] = network->id;
+
+    for (const auto &[containerId, member] : network->containers) {
+        TopologyEndpoint endpoint;
+        endpoint.networkId = network->id;
+        endpoint.networkName = network->name;
+        endpoint.containerId = containerId;
+        // Inspect gives the container name without the leading '/'
+        endpoint.containerName = stripSlash(member.name);
+        endpoint.endpointId = member.endpoint_id;
+        endpoint.macAddress = member.mac_address;
+        endpoint.ipv4Address = member.ipv4_address;
+        endpoint.ipv6Address = member.ipv6_address;
+        index.insertEndpoint(std::move(endpoint));
+    }
+}
+
+void NetworkTopology::connect(const std::string &networkId, const std::string &containerId, networkTypes::EndpointConfigNetwork &endpointConfig) {
+    NetworkManager networkManager(dockerClient);
+    networkManager.connect(networkId, containerId, endpointConfig);
+    // The daemon picks the address, read it back
+    refreshNetwork(networkId);
+}
+
+void NetworkTopology::disconnect(const std::string &networkId, const std::string &containerId, bool force) {
+    NetworkManager networkManager(dockerClient);
+    networkManager.disconnect(networkId, containerId, force);
+
+    std::unique_lock lock(mutex);
+    index.eraseEndpoint(resolveNetwork(networkId), resolveContainer(containerId));
+}
+
+bool NetworkTopology::applyEvent(const nlohmann::json &event) {
+    if (!event.is_object()) return false;
+
+    const std::string type = event.value("Type", std::string{});
+    const std::string action = event.value("Action", std::string{});
+    if (!event.contains("Actor") || !event["Actor"].is_object()) return false;
+    const auto &actor = event["Actor"];
+    const std::string actorId = actor.value("ID", std::string{});
+
+    if (type == "network") {
+        if (action == "connect") {
+            try {
+                refreshNetwork(actorId);
+                return true;
+            } catch (const std::exception &e) {
+                std::cerr << "Failed to refresh network " << actorId << " after connect: " << e.what() << std::endl;
+                return false;
+            }
+        }
+
+        std::unique_lock lock(mutex);
+        if (action == "disconnect") {
+            index.eraseEndpoint(actorId, attribute(actor, "container"));
+            return true;
+        }
+        if (action == "destroy") {
+            index.eraseNetwork(actorId);
+            return true;
+        }
+        if (action == "create") {
+            const std::string name = attribute(actor, "name");
+            if (name.empty()) return false;
+            index.networkNames[actorId] = name;
+            index.networkIds[name] = actorId;
+            return true;
+        }
+        return false;
+    }
+
+    if (type == "container") {
+        std::unique_lock lock(mutex);
+        if (action == "destroy") {
+            index.eraseContainer(actorId);
+            return true;
+        }
+        if (action == "rename") {
+            const std::string name = stripSlash(attribute(actor, "name"));
+            const std::string oldName = stripSlash(attribute(actor, "oldName"));
+            index.containerIds.erase(oldName);
+            index.containerNames[actorId] = name;
+            index.containerIds[name] = actorId;
+
+            auto it = index.networksByContainer.find(actorId);
+            if (it != index.networksByContainer.end()) {
+                for (const auto &networkId : it->second) {
+                    index.endpoints[endpointKey(networkId, actorId)].containerName = name;
+                }
+            }
+            return true;
+        }
+    }
+
+    return false;
+}
+
+std::string NetworkTopology::resolveNetwork(const std::string &idOrName) const {
+    auto it = index.networkIds.find(idOrName);
+    return it != index.networkIds.end() ? it->second : idOrName;
+}
+
+std::string NetworkTopology::resolveContainer(const std::string &idOrName) const {
+    auto it = index.containerIds.find(stripSlash(idOrName));
+    return it != index.containerIds.end() ? it->second : idOrName;
+}
+
+std::optional<TopologyEndpoint> NetworkTopology::findByIp(const std::string &ip) const {
+    std::shared_lock lock(mutex);
+    auto it = index.byIp.find(stripPrefix(ip));
+    if (it == index.byIp.end()) return std::nullopt;
+    return index.endpoints.at(it->second);
+}
+
+std::optional<TopologyEndpoint> NetworkTopology::findByMac(const std::string &mac) const {
+    std::shared_lock lock(mutex);
+    auto it = index.byMac.find(normalizeMac(mac));
+    if (it == index.byMac.end()) return std::nullopt;
+    return index.endpoints.at(it->second);
+}
+
+std::optional<TopologyEndpoint> NetworkTopology::endpoint(const std::string &network, const std::string &container) const {
+    std::shared_lock lock(mutex);
+    auto it = index.endpoints.find(endpointKey(resolveNetwork(network), resolveContainer(container)));
+    if (it == index.endpoints.end()) return std::nullopt;
+    return it->second;
+}
+
+std::vector<TopologyEndpoint> NetworkTopology::networksOf(const std::string &container) const {
+    std::shared_lock lock(mutex);
+    const std::string containerId = resolveContainer(container);
+    std::vector<TopologyEndpoint> result;
+
+    auto it = index.networksByContainer.find(containerId);
+    if (it == index.networksByContainer.end()) return result;
+
+    result.reserve(it->second.size());
+    for (const auto &networkId : it->second) {
+        result.push_back(index.endpoints.at(endpointKey(networkId, containerId)));
+    }
+    return result;
+}
+
+std::vector<TopologyEndpoint> NetworkTopology::membersOf(const std::string &network) const {
+    std::shared_lock lock(mutex);
+    const std::string networkId = resolveNetwork(network);
+    std::vector<TopologyEndpoint> result;
+
+    auto it = index.containersByNetwork.find(networkId);
+    if (it == index.containersByNetwork.end()) return result;
+
+    result.reserve(it->second.size());
+    for (const auto &containerId : it->second) {
+        result.push_back(index.endpoints.at(endpointKey(networkId, containerId)));
+    }
+    return result;
+}
+
+size_t NetworkTopology::size() const {
+    std::shared_lock lock(mutex);
+    return index.endpoints.size();
+}
@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2025 Nokaji. Tous droits réservés.
+ * Ce fichier fait partie du projet Kernel-James.
+ */
+#pragma once
+#include <memory>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "types/network_types.h"
+
+// Forward declaration
+class DockerClient;
+
+// One container attached to one network
+struct TopologyEndpoint {
+    std::string networkId;
+    std::string networkName;
+    std::string containerId;
+    std::string containerName;
+    std::string endpointId;
+    std::string macAddress;
+    std::string ipv4Address; // sans le suffixe /prefix
+    std::string ipv6Address;
+};
+
+/*
+ * Indexed view of which container sits on which network.
+ * Built once from the network and container listings, then kept up to date
+ * through connect()/disconnect() and the daemon events passed to applyEvent().
+ * Lookups are hash lookups under a shared lock, safe to call from any thread.
+ */
+class NetworkTopology
+{
+    private:
+        std::shared_ptr<DockerClient> dockerClient;
+
+        struct Index {
+            // key: networkId + '/' + containerId
+            std::unordered_map<std::string, TopologyEndpoint> endpoints;
+            std::unordered_map<std::string, std::string> byIp;
+            std::unordered_map<std::string, std::string> byMac;
+            std::unordered_map<std::string, std::unordered_set<std::string>> networksByContainer;
+            std::unordered_map<std::string, std::unordered_set<std::string>> containersByNetwork;
+
+            std::unordered_map<std::string, std::string> networkNames;   // id -> name
+            std::unordered_map<std::string, std::string> networkIds;     // name -> id
+            std::unordered_map<std::string, std::string> containerNames; // id -> name
+            std::unordered_map<std::string, std::string> containerIds;   // name -> id
+
+            void insertEndpoint(TopologyEndpoint endpoint);
+            void eraseEndpoint(const std::string &networkId, const std::string &containerId);
+            void eraseNetwork(const std::string &networkId);
+            void eraseContainer(const std::string &containerId);
+        };
+
+        mutable std::shared_mutex mutex;
+        Index index;
+
+        std::string resolveNetwork(const std::string &idOrName) const;
+        std::string resolveContainer(const std::string &idOrName) const;
+
+    public:
+        explicit NetworkTopology(std::shared_ptr<DockerClient> client);
+
+        // Full rebuild: one network listing and one container listing
+        void rebuild();
+
+        // Re-inspect a single network and replace its members
+        void refreshNetwork(const std::string &networkIdOrName);
+
+        // NetworkManager::connect/disconnect, index updated on success
+        void connect(const std::string &networkId, const std::string &containerId, networkTypes::EndpointConfigNetwork &endpointConfig);
+        void disconnect(const std::string &networkId, const std::string &containerId, bool force = false);
+
+        // Apply one decoded /events message; returns true if the index changed
+        bool applyEvent(const nlohmann::json &event);
+
+        [[nodiscard]] std::optional<TopologyEndpoint> findByIp(const std::string &ip) const;
+        [[nodiscard]] std::optional<TopologyEndpoint> findByMac(const std::string &mac) const;
+        [[nodiscard]] std::optional<TopologyEndpoint> endpoint(const std::string &network, const std::string &container) const;
+        [[nodiscard]] std::vector<TopologyEndpoint> networksOf(const std::string &container) const;
+        [[nodiscard]] std::vector<TopologyEndpoint> membersOf(const std::string &network) const;
+
+        [[nodiscard]] size_t size() const;
+};
@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) 2025 Nokaji. Tous droits réservés.
+ * Ce fichier fait partie du projet Kernel-James.
+ */
+#include "parallel.h"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+void parallelFor(size_t count, size_t concurrency, const std::function<void(size_t index)> &task) {
+    if (count == 0) return;
+    if (concurrency == 0) concurrency = std::max(1u, std::thread::hardware_concurrency());
+    concurrency = std::min(concurrency, count);
+
+    if (concurrency == 1) {
+        for (size_t i = 0; i < count; ++i) task(i);
+        return;
+    }
+
+    std::atomic<size_t> next{0};
+    std::atomic<bool> failed{false};
+    std::exception_ptr error;
+    std::mutex errorMutex;
+
+    auto worker = [&] {
+        for (size_t i = next++; i < count && !failed.load(std::memory_order_relaxed); i = next++) {
+            try {
+                task(i);
+            } catch (...) {
+                std::lock_guard lock(errorMutex);
+                if (!error) error = std::current_exception();
+                failed = true;
+            }
+        }
+    };
+
+    // The calling thread works too
+    std::vector<std::thread> threads;
+    threads.reserve(concurrency - 1);
+    for (size_t i = 1; i < concurrency; ++i) threads.emplace_back(worker);
+    worker();
+    for (auto &thread : threads) thread.join();
+
+    if (error) std::rethrow_exception(error);
+}
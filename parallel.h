@@ -0,0 +1,12 @@
+/*
+ * Copyright (c) 2025 Nokaji. Tous droits réservés.
+ * Ce fichier fait partie du projet Kernel-James.
+ */
+#pragma once
+#include <cstddef>
+#include <functional>
+
+// Runs task(0) .. task(count - 1) on at most concurrency threads (0 = hardware
+// concurrency) and returns once all are done. The first exception thrown by a
+// task is rethrown here; tasks not started yet are skipped.
+void parallelFor(size_t count, size_t concurrency, const std::function<void(size_t index)> &task);
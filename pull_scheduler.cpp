@@ -0,0 +1,203 @@
+/*
+ * Copyright (c) 2025 Nokaji. Tous droits réservés.
+ * Ce fichier fait partie du projet Kernel-James.
+ */
+#include "pull_scheduler.h"
+#include "docker.h"
+#include "image_manager.h"
+#include <algorithm>
+#include <stdexcept>
+
+PullScheduler::PullScheduler(std::shared_ptr<DockerClient> client, PullSchedulerOptions schedulerOptions,
+                             ProgressCallback progress)
+    : dockerClient(std::move(client)), options(schedulerOptions), progressCallback(std::move(progress)) {
+    if (!dockerClient) {
+        throw std::runtime_error("Docker client is not initialized.");
+    }
+    options.concurrency = std::max<size_t>(1, options.concurrency);
+    options.perRegistryLimit = std::max<size_t>(1, options.perRegistryLimit);
+
+    workers.reserve(options.concurrency);
+    for (size_t i = 0; i < options.concurrency; ++i) {
+        workers.emplace_back([this] { workerLoop(); });
+    }
+}
+
+PullScheduler::~PullScheduler() {
+    std::vector<std::shared_ptr<Job>> abandoned;
+    {
+        std::lock_guard lock(mutex);
+        stopping = true;
+        abandoned.swap(queue);
+    }
+    wakeup.notify_all();
+    for (auto &job : abandoned) {
+        job->promise.set_exception(std::make_exception_ptr(std::runtime_error("Pull scheduler stopped before pulling " + job->reference)));
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+}
+
+std::string PullScheduler::normalizeReference(const std::string &reference, std::string *registry) {
+    std::string name = reference;
+    std::string suffix;
+    const size_t at = name.find('@');
+    if (at != std::string::npos) {
+        suffix = name.substr(at);
+        name.resize(at);
+    } else {
+        const size_t colon = name.rfind(':');
+        const size_t slash = name.rfind('/');
+        if (colon != std::string::npos && (slash == std::string::npos || colon > slash)) {
+            suffix = name.substr(colon);
+            name.resize(colon);
+        } else {
+            suffix = ":latest";
+        }
+    }
+
+    // The first component is a registry only if it looks like a host
+    std::string host = "docker.io";
+    const size_t slash = name.find('/');
+    if (slash != std::string::npos) {
+        const std::string first = name.substr(0, slash);
+        if (first.find('.') != std::string::npos || first.find(':') != std::string::npos || first == "localhost") {
+            host = first;
+            name = name.substr(slash + 1);
+        }
+    }
+    if (host == "docker.io" && name.find('/') == std::string::npos) {
+        name = "library/" + name;
+    }
+
+    if (registry) *registry = host;
+    return host + "/" + name + suffix;
+}
+
+std::shared_future<void> PullScheduler::submit(const PullRequest &request) {
+    std::string registry;
+    std::string reference = normalizeReference(request.reference, &registry);
+
+    std::lock_guard lock(mutex);
+    if (stopping) {
+        throw std::runtime_error("Pull scheduler is stopping");
+    }
+    auto existing = jobs.find(reference);
+    if (existing != jobs.end()) {
+        Job &job = *existing->second;
+        if (!job.started) {
+            // Still waiting: the most urgent requester decides when it runs
+            job.request.priority = std::min(job.request.priority, request.priority);
+            if (job.request.registryAuth.empty()) job.request.registryAuth = request.registryAuth;
+        }
+        return job.future;
+    }
+
+    auto job = std::make_shared<Job>();
+    job->reference = reference;
+    job->registry = std::move(registry);
+    job->request = request;
+    job->sequence = nextSequence++;
+    job->future = job->promise.get_future().share();
+    jobs.emplace(std::move(reference), job);
+    queue.push_back(job);
+    wakeup.notify_one();
+    return job->future;
+}
+
+std::map<std::string, std::string> PullScheduler::pullAll(const std::vector<PullRequest> &requests) {
+    std::vector<std::pair<std::string, std::shared_future<void>>> pending;
+    pending.reserve(requests.size());
+    for (const auto &request : requests) {
+        pending.emplace_back(request.reference, submit(request));
+    }
+
+    std::map<std::string, std::string> errors;
+    for (auto &[reference, future] : pending) {
+        try {
+            future.get();
+        } catch (const std::exception &e) {
+            errors.emplace(reference, e.what());
+        }
+    }
+    return errors;
+}
+
+std::shared_ptr<PullScheduler::Job> PullScheduler::takeNextLocked() {
+    auto best = queue.end();
+    for (auto it = queue.begin(); it != queue.end(); ++it) {
+        const auto slot = running.find((*it)->registry);
+        if (slot != running.end() && slot->second >= options.perRegistryLimit) continue;
+        if (best == queue.end() || (*it)->request.priority < (*best)->request.priority ||
+            ((*it)->request.priority == (*best)->request.priority && (*it)->sequence < (*best)->sequence)) {
+            best = it;
+        }
+    }
+    if (best == queue.end()) return nullptr;
+
+    auto job = *best;
+    queue.erase(best);
+    job->started = true;
+    ++running[job->registry];
+    return job;
+}
+
+void PullScheduler::workerLoop() {
+    while (true) {
+        std::shared_ptr<Job> job;
+        {
+            std::unique_lock lock(mutex);
+            wakeup.wait(lock, [this, &job] {
+                if (stopping) return true;
+                job = takeNextLocked();
+                return job != nullptr;
+            });
+            if (!job) return;
+        }
+
+        bool failed = false;
+        try {
+            pull(*job);
+            job->promise.set_value();
+        } catch (...) {
+            failed = true;
+            job->promise.set_exception(std::current_exception());
+        }
+
+        {
+            std::lock_guard lock(mutex);
+            if (--running[job->registry] == 0) running.erase(job->registry);
+            if (failed) {
+                auto entry = jobs.find(job->reference);
+                if (entry != jobs.end() && entry->second == job) jobs.erase(entry);
+            }
+        }
+        // A registry slot was freed: queued pulls blocked on it may start
+        wakeup.notify_all();
+    }
+}
+
+void PullScheduler::pull(const Job &job) {
+    ImageManager images(dockerClient);
+    // Normalized, hence always tagged: an untagged fromImage would pull every tag
+    const std::string &reference = job.reference;
+
+    if (options.skipExisting) {
+        // inspect rather than exists(): quiet, and any failure just means pulling
+        try {
+            images.inspect(reference);
+            return;
+        } catch (const std::exception &) {
+        }
+    }
+
+    ImageManager::PullCallback progress;
+    if (progressCallback) {
+        progress = [this, &reference](const imageTypes::PullEvent &event, const imageTypes::PullProgress &state) {
+            std::lock_guard lock(callbackMutex);
+            progressCallback(reference, event, state);
+        };
+    }
+    images.pull(reference, "", "", "", "", {}, job.request.platform, job.request.registryAuth, progress);
+}
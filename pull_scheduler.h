@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2025 Nokaji. Tous droits réservés.
+ * Ce fichier fait partie du projet Kernel-James.
+ */
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "types/image_types.h"
+
+class DockerClient;
+
+struct PullRequest {
+    std::string reference;              // image[:tag] or image@digest, ":latest" is implied
+    int priority = 0;                   // lower is pulled first, e.g. the start order of the service needing it
+    std::string registryAuth;
+    std::string platform;
+};
+
+struct PullSchedulerOptions {
+    size_t concurrency = 8;             // pulls in flight overall
+    size_t perRegistryLimit = 3;        // pulls in flight against one registry
+    bool skipExisting = true;           // images already present are not pulled again
+};
+
+/*
+ * Runs image pulls on a fixed pool of workers. A request for a reference that
+ * is already queued, in flight or done joins that pull instead of starting
+ * another one (a queued pull takes the most urgent priority of its requesters).
+ * Among queued pulls the lowest priority value whose registry is below its
+ * limit starts next. Failed pulls are forgotten, so a later request retries.
+ */
+class PullScheduler
+{
+    public:
+        // Called for each progress message of each pull, one call at a time
+        using ProgressCallback = std::function<void(const std::string &reference, const imageTypes::PullEvent &event,
+                                                    const imageTypes::PullProgress &progress)>;
+
+    private:
+        struct Job {
+            std::string reference;
+            std::string registry;
+            PullRequest request;
+            uint64_t sequence = 0;
+            bool started = false;       // request is read by the worker from then on
+            std::promise<void> promise;
+            std::shared_future<void> future;
+        };
+
+        std::shared_ptr<DockerClient> dockerClient;
+        PullSchedulerOptions options;
+        ProgressCallback progressCallback;
+
+        std::mutex mutex;
+        std::condition_variable wakeup;
+        std::map<std::string, std::shared_ptr<Job>> jobs;   // by normalized reference
+        std::vector<std::shared_ptr<Job>> queue;
+        std::map<std::string, size_t> running;              // per registry
+        uint64_t nextSequence = 0;
+        bool stopping = false;
+
+        std::mutex callbackMutex;
+        std::vector<std::thread> workers;
+
+        std::shared_ptr<Job> takeNextLocked();
+        void workerLoop();
+        void pull(const Job &job);
+
+    public:
+        PullScheduler(std::shared_ptr<DockerClient> client, PullSchedulerOptions options = {},
+                      ProgressCallback progress = nullptr);
+        // Queued pulls are abandoned (their futures fail), pulls in flight are awaited
+        ~PullScheduler();
+
+        PullScheduler(const PullScheduler &) = delete;
+        PullScheduler &operator=(const PullScheduler &) = delete;
+
+        // Ready once the image is present; get() rethrows the pull error
+        std::shared_future<void> submit(const PullRequest &request);
+
+        // Submits all requests and waits for them; returns the error of each failed reference
+        std::map<std::string, std::string> pullAll(const std::vector<PullRequest> &requests);
+
+        // Fully qualified form used as key, "nginx" -> "docker.io/library/nginx:latest", and its registry host
+        static std::string normalizeReference(const std::string &reference, std::string *registry = nullptr);
+};
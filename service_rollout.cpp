@@ -0,0 +1,321 @@
+/*
+ * Copyright (c) 2025 Nokaji. Tous droits réservés.
+ * Ce fichier fait partie du projet Kernel-James.
+ */
+#include "service_rollout.h"
+#include "compose_deployer.h"
+#include "container.h"
+#include "docker.h"
+#include "parallel.h"
+#include "pull_scheduler.h"
+#include <fmt/format.h>
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+    constexpr const char *SERVICE_LABEL = "com.docker.compose.service";
+    constexpr const char *NUMBER_LABEL = "com.docker.compose.container-number";
+
+    bool isRunning(const ContainerList &container) {
+        return container.state == containerTypes::ContainerStatus::RUNNING;
+    }
+
+    bool isCurrent(const ContainerList &container, const std::string &fingerprint) {
+        const auto hash = container.labels.find(ComposeDeployer::CONFIG_HASH_LABEL);
+        return hash != container.labels.end() && hash->second == fingerprint;
+    }
+
+    // Lowest numbers not in use, which are then reserved
+    std::vector<size_t> takeNumbers(std::set<size_t> &used, size_t count) {
+        std::vector<size_t> numbers;
+        for (size_t number = 1; numbers.size() < count; ++number) {
+            if (used.insert(number).second) numbers.push_back(number);
+        }
+        return numbers;
+    }
+}
+
+ServiceRollout::ServiceRollout(std::shared_ptr<DockerClient> client, std::string projectName)
+    : dockerClient(std::move(client)), project(std::move(projectName)) {
+    if (!dockerClient) {
+        throw std::runtime_error("Docker client is not initialized.");
+    }
+    if (project.empty()) {
+        throw std::runtime_error("Service replicas need a project name");
+    }
+}
+
+size_t ServiceRollout::replicaNumber(const ContainerList &container) {
+    const auto number = container.labels.find(NUMBER_LABEL);
+    if (number == container.labels.end()) return 0;
+    try {
+        return std::stoul(number->second);
+    } catch (const std::logic_error &) {
+        return 0;
+    }
+}
+
+std::vector<ContainerList> ServiceRollout::replicas(const std::string &serviceName) const {
+    const nlohmann::json filters = {{"label", {"com.docker.compose.project=" + project,
+                                               std::string(SERVICE_LABEL) + "=" + serviceName}}};
+    ContainerManager containerManager(dockerClient);
+    auto containers = containerManager.list(true, 0, false, filters.dump());
+    std::sort(containers.begin(), containers.end(), [](const ContainerList &a, const ContainerList &b) {
+        return replicaNumber(a) < replicaNumber(b);
+    });
+    return containers;
+}
+
+void ServiceRollout::waitReady(const std::string &containerId, const RolloutOptions &options) const {
+    ContainerManager containerManager(dockerClient);
+    const auto deadline = std::chrono::steady_clock::now() + options.readyTimeout;
+    std::optional<std::chrono::steady_clock::time_point> runningSince;
+
+    while (true) {
+        const nlohmann::json state = containerManager.inspect(containerId).value("State", nlohmann::json::object());
+        if (!state.value("Running", false)) {
+            throw std::runtime_error(fmt::format("Container {} is {} (exit code {})", containerId.substr(0, 12),
+                                                 state.value("Status", "not running"), state.value("ExitCode", 0)));
+        }
+
+        const auto now = std::chrono::steady_clock::now();
+        if (state.contains("Health") && state["Health"].is_object()) {
+            const std::string health = state["Health"].value("Status", "");
+            if (health == "healthy") return;
+            if (health == "unhealthy") {
+                throw std::runtime_error("Container " + containerId.substr(0, 12) + " is unhealthy");
+            }
+        } else {
+            if (!runningSince) runningSince = now;
+            if (now - *runningSince >= options.minReady) return;
+        }
+
+        if (now >= deadline) {
+            throw std::runtime_error("Container " + containerId.substr(0, 12) + " not ready in time");
+        }
+        std::this_thread::sleep_for(options.pollInterval);
+    }
+}
+
+std::map<size_t, std::string> ServiceRollout::createReplicas(const std::string &serviceName, const Service &service,
+                                                             const std::vector<size_t> &numbers, bool gateOnReady,
+                                                             const RolloutOptions &options, RolloutResult &result,
+                                                             const ProgressCallback &progress) {
+    ContainerManager containerManager(dockerClient);
+    std::vector<std::string> names(numbers.size());
+    std::vector<std::string> ids(numbers.size());
+    std::vector<std::string> errors(numbers.size());
+    std::mutex progressMutex;
+
+    parallelFor(numbers.size(), std::max<size_t>(1, options.concurrency), [&](size_t index) {
+        try {
+            names[index] = ComposeDeployer::containerName(project, serviceName, service, numbers[index]);
+            const std::string id = containerManager.createContainer(names[index],
+                    ComposeDeployer::containerConfig(project, serviceName, service, options.baseDir, numbers[index]));
+            Container container(dockerClient, nlohmann::json{{"Id", id}, {"Name", names[index]}});
+            container.run();
+            if (gateOnReady) waitReady(id, options);
+            ids[index] = id;
+        } catch (const std::exception &e) {
+            errors[index] = e.what();
+        }
+
+        if (progress) {
+            std::lock_guard lock(progressMutex);
+            progress(names[index], true, errors[index]);
+        }
+    });
+
+    std::map<size_t, std::string> created;
+    for (size_t i = 0; i < numbers.size(); ++i) {
+        if (errors[i].empty()) {
+            result.created.push_back(names[i]);
+            created.emplace(numbers[i], ids[i]);
+        } else {
+            result.errors.emplace(names[i].empty() ? serviceName : names[i], errors[i]);
+        }
+    }
+    return created;
+}
+
+void ServiceRollout::removeReplicas(const std::vector<ContainerList> &containers, const RolloutOptions &options,
+                                    RolloutResult &result, const ProgressCallback &progress) {
+    ContainerManager containerManager(dockerClient);
+    std::vector<std::string> errors(containers.size());
+    std::mutex progressMutex;
+
+    parallelFor(containers.size(), std::max<size_t>(1, options.concurrency), [&](size_t index) {
+        const ContainerList &replica = containers[index];
+        try {
+            if (isRunning(replica)) {
+                // Stopped first so it gets SIGTERM and its grace period; if that fails the forced remove kills it
+                Container container(dockerClient, nlohmann::json{{"Id", replica.id}, {"Name", replica.name}});
+                try {
+                    container.stop();
+                } catch (const std::exception &) {
+                }
+            }
+            containerManager.remove(replica.id, true);
+        } catch (const std::exception &e) {
+            errors[index] = e.what();
+        }
+
+        if (progress) {
+            std::lock_guard lock(progressMutex);
+            progress(replica.name, false, errors[index]);
+        }
+    });
+
+    for (size_t i = 0; i < containers.size(); ++i) {
+        if (errors[i].empty()) result.removed.push_back(containers[i].name);
+        else result.errors.emplace(containers[i].name, errors[i]);
+    }
+}
+
+RolloutResult ServiceRollout::scale(const std::string &serviceName, const Service &service, size_t count,
+                                    const RolloutOptions &options, const ProgressCallback &progress) {
+    const auto started = std::chrono::steady_clock::now();
+    if (count > 1 && !service.container_name.empty()) {
+        throw std::runtime_error("Service " + serviceName + " sets container_name and cannot have several replicas");
+    }
+
+    RolloutResult result;
+    auto existing = replicas(serviceName);
+    std::set<size_t> used;
+    for (const auto &container : existing) {
+        used.insert(replicaNumber(container));
+    }
+
+    if (existing.size() < count) {
+        PullScheduler puller(dockerClient);
+        const auto pullErrors = puller.pullAll({{service.image, 0, "", ""}});
+        for (const auto &[image, error] : pullErrors) {
+            result.errors.emplace(image, error);
+        }
+        if (pullErrors.empty()) {
+            createReplicas(serviceName, service, takeNumbers(used, count - existing.size()), options.waitReady, options,
+                           result, progress);
+        }
+        result.batches = 1;
+    } else if (existing.size() > count) {
+        // Outdated or stopped replicas go first, then the highest numbers
+        const std::string fingerprint = ComposeDeployer::fingerprint(service);
+        std::stable_sort(existing.begin(), existing.end(), [&fingerprint](const ContainerList &a, const ContainerList &b) {
+            const bool keepA = isCurrent(a, fingerprint) && isRunning(a);
+            const bool keepB = isCurrent(b, fingerprint) && isRunning(b);
+            if (keepA != keepB) return !keepA;
+            return replicaNumber(a) > replicaNumber(b);
+        });
+        existing.resize(existing.size() - count);
+        removeReplicas(existing, options, result, progress);
+        result.batches = 1;
+    }
+
+    result.duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started);
+    return result;
+}
+
+RolloutResult ServiceRollout::update(const std::string &serviceName, const Service &service, const RolloutOptions &options,
+                                     const ProgressCallback &progress) {
+    const auto started = std::chrono::steady_clock::now();
+    if (options.maxSurge == 0 && options.maxUnavailable == 0) {
+        throw std::runtime_error("A rolling update needs maxSurge or maxUnavailable above 0");
+    }
+    const size_t target = service.replicas;
+    if (target > 1 && !service.container_name.empty()) {
+        throw std::runtime_error("Service " + serviceName + " sets container_name and cannot have several replicas");
+    }
+
+    RolloutResult result;
+    const std::string fingerprint = ComposeDeployer::fingerprint(service);
+    auto existing = replicas(serviceName);
+
+    // Split into up-to-date running replicas and the ones to replace
+    std::vector<ContainerList> current;
+    std::vector<ContainerList> old;
+    std::set<size_t> used;
+    for (auto &container : existing) {
+        used.insert(replicaNumber(container));
+        if (isCurrent(container, fingerprint) && isRunning(container)) current.push_back(std::move(container));
+        else old.push_back(std::move(container));
+    }
+    // Up-to-date replicas beyond the target are retired like old ones, highest numbers first
+    while (current.size() > target) {
+        old.push_back(std::move(current.back()));
+        current.pop_back();
+    }
+    // Stopped replicas first, they serve nothing; then the highest numbers
+    std::stable_sort(old.begin(), old.end(), [](const ContainerList &a, const ContainerList &b) {
+        if (isRunning(a) != isRunning(b)) return !isRunning(a);
+        return replicaNumber(a) > replicaNumber(b);
+    });
+
+    size_t needed = target - current.size();
+    if (needed > 0) {
+        PullScheduler puller(dockerClient);
+        const auto pullErrors = puller.pullAll({{service.image, 0, "", ""}});
+        for (const auto &[image, error] : pullErrors) {
+            result.errors.emplace(image, error);
+        }
+        if (!pullErrors.empty()) {
+            result.duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started);
+            return result;
+        }
+    }
+
+    const size_t minAvailable = target > options.maxUnavailable ? target - options.maxUnavailable : 0;
+    const size_t maxLive = target + options.maxSurge;
+    size_t ready = current.size() + static_cast<size_t>(std::count_if(old.begin(), old.end(), isRunning));
+    size_t live = current.size() + old.size();
+
+    while (!old.empty() || needed > 0) {
+        // Old replicas removable without going under minAvailable (stopped ones are free)
+        std::vector<ContainerList> retiring;
+        size_t budget = ready > minAvailable ? ready - minAvailable : 0;
+        while (!old.empty()) {
+            if (isRunning(old.front())) {
+                if (budget == 0) break;
+                --budget;
+            }
+            retiring.push_back(std::move(old.front()));
+            old.erase(old.begin());
+        }
+        const size_t retiringLive = retiring.size();
+        const size_t retiringReady = static_cast<size_t>(std::count_if(retiring.begin(), retiring.end(), isRunning));
+        const size_t spawn = std::min(needed, maxLive > live - retiringLive ? maxLive - (live - retiringLive) : 0);
+        if (retiring.empty() && spawn == 0) {
+            result.errors.emplace(serviceName, "Rollout cannot progress within maxSurge and maxUnavailable");
+            break;
+        }
+        ++result.batches;
+
+        if (!retiring.empty()) {
+            const size_t failures = result.errors.size();
+            removeReplicas(retiring, options, result, progress);
+            if (result.errors.size() != failures) break;
+            for (const auto &replica : retiring) {
+                used.erase(replicaNumber(replica));
+            }
+            live -= retiringLive;
+            ready -= retiringReady;
+        }
+
+        if (spawn > 0) {
+            const std::vector<size_t> numbers = takeNumbers(used, spawn);
+            const auto created = createReplicas(serviceName, service, numbers, true, options, result, progress);
+            // Replicas that failed stay where they are: they still count as live
+            live += numbers.size();
+            ready += created.size();
+            needed -= created.size();
+            if (created.size() != numbers.size()) break;
+        }
+    }
+
+    result.duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started);
+    return result;
+}
@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2025 Nokaji. Tous droits réservés.
+ * Ce fichier fait partie du projet Kernel-James.
+ */
+#pragma once
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "container_manager.h"
+#include "docker_compose_parser.h"
+
+class DockerClient;
+
+struct RolloutOptions {
+    size_t maxSurge = 1;                            // replicas allowed above the target while updating
+    size_t maxUnavailable = 0;                      // replicas allowed below the target while updating
+    size_t concurrency = 16;                        // creates, starts, readiness checks and removals in flight
+    std::chrono::milliseconds readyTimeout{60000};  // per new replica
+    std::chrono::milliseconds minReady{2000};       // without a healthcheck, running this long counts as ready
+    std::chrono::milliseconds pollInterval{500};
+    bool waitReady = true;                          // scale: also gate new replicas on readiness
+    std::string baseDir;                            // relative bind sources, as for ComposeDeployer
+};
+
+struct RolloutResult {
+    std::vector<std::string> created;               // container names
+    std::vector<std::string> removed;
+    std::map<std::string, std::string> errors;      // container name -> error
+    size_t batches = 0;
+    std::chrono::milliseconds duration{0};
+
+    [[nodiscard]] bool succeeded() const { return errors.empty(); }
+};
+
+/*
+ * Replicas of one compose service, the containers of the project labelled
+ * with the service and numbered by com.docker.compose.container-number.
+ *
+ * scale() creates or removes replicas in parallel. update() replaces the
+ * replicas whose configuration fingerprint is outdated in batches: each
+ * batch removes as many old replicas as maxUnavailable allows and creates as
+ * many new ones as maxSurge allows, and the next batch starts once the new
+ * replicas are ready (healthy, or running for minReady without a
+ * healthcheck). A replica that fails or does not become ready stops the
+ * rollout where it is; it is left in place for inspection.
+ */
+class ServiceRollout
+{
+    public:
+        // Called once per created or removed replica, one call at a time; error is empty on success
+        using ProgressCallback = std::function<void(const std::string &containerName, bool created, const std::string &error)>;
+
+    private:
+        std::shared_ptr<DockerClient> dockerClient;
+        std::string project;
+
+        // Creates and starts the given replica numbers; returns the ids of those that came up (and got ready)
+        std::map<size_t, std::string> createReplicas(const std::string &serviceName, const Service &service,
+                                                     const std::vector<size_t> &numbers, bool gateOnReady,
+                                                     const RolloutOptions &options, RolloutResult &result,
+                                                     const ProgressCallback &progress);
+        void removeReplicas(const std::vector<ContainerList> &containers, const RolloutOptions &options,
+                            RolloutResult &result, const ProgressCallback &progress);
+
+    public:
+        ServiceRollout(std::shared_ptr<DockerClient> client, std::string project);
+
+        // All containers of the service, running or not, by replica number
+        [[nodiscard]] std::vector<ContainerList> replicas(const std::string &serviceName) const;
+
+        static size_t replicaNumber(const ContainerList &container);
+
+        // Blocks until the container is healthy (or running for minReady without a healthcheck);
+        // throws if it exits, turns unhealthy or readyTimeout elapses
+        void waitReady(const std::string &containerId, const RolloutOptions &options) const;
+
+        // Brings the service to replicas containers. Scaling down removes outdated or stopped replicas first,
+        // then the highest numbers.
+        RolloutResult scale(const std::string &serviceName, const Service &service, size_t replicas,
+                            const RolloutOptions &options = {}, const ProgressCallback &progress = nullptr);
+
+        // Rolling update to the current definition, at service.replicas replicas
+        RolloutResult update(const std::string &serviceName, const Service &service,
+                             const RolloutOptions &options = {}, const ProgressCallback &progress = nullptr);
+};
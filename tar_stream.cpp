@@ -0,0 +1,593 @@
+/*
+ * Copyright (c) 2025 Nokaji. Tous droits réservés.
+ * Ce fichier fait partie du projet Kernel-James.
+ */
+#include "tar_stream.h"
+#include <fmt/format.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+
+namespace fs = std::filesystem;
+
+namespace {
+    constexpr size_t BLOCK = 512;
+    constexpr uint64_t MAX_OCTAL_SIZE = 077777777777ULL; // 11 octal digits
+    constexpr size_t MAX_EXTRA_BYTES = 1024 * 1024;
+
+    size_t paddingOf(uint64_t size) {
+        return static_cast<size_t>((BLOCK - size % BLOCK) % BLOCK);
+    }
+
+    // width - 1 zero-padded octal digits and a NUL
+    void writeOctal(char *field, size_t width, uint64_t value) {
+        std::snprintf(field, width, "%0*llo", static_cast<int>(width - 1), static_cast<unsigned long long>(value));
+    }
+
+    uint64_t parseNumeric(const char *field, size_t width) {
+        const auto *bytes = reinterpret_cast<const unsigned char *>(field);
+        uint64_t value = 0;
+        if (bytes[0] & 0x80) {
+            // base-256 (GNU), used for sizes that do not fit the octal field
+            value = bytes[0] & 0x7f;
+            for (size_t i = 1; i < width; ++i) value = (value << 8) | bytes[i];
+            return value;
+        }
+        size_t i = 0;
+        while (i < width && (field[i] == ' ' || field[i] == '\0')) ++i;
+        for (; i < width && field[i] >= '0' && field[i] <= '7'; ++i) value = value * 8 + static_cast<uint64_t>(field[i] - '0');
+        return value;
+    }
+
+    std::string field(const char *data, size_t width) {
+        return {data, strnlen(data, width)};
+    }
+
+    // "<length> <key>=<value>\n", length counting its own digits
+    std::string paxRecord(std::string_view key, std::string_view value) {
+        const size_t base = key.size() + value.size() + 3;
+        size_t length = base + 1;
+        while (std::to_string(length).size() + base != length) length = std::to_string(length).size() + base;
+        return fmt::format("{} {}={}\n", length, key, value);
+    }
+
+    // Splits name into ustar prefix (155) and name (100) at a '/', if possible
+    bool splitUstarName(const std::string &name, std::string &prefix, std::string &rest) {
+        const size_t first = name.size() > 101 ? name.size() - 101 : 0;
+        for (size_t slash = name.find('/', first); slash != std::string::npos && slash <= 155; slash = name.find('/', slash + 1)) {
+            if (slash > 0 && name.size() - slash - 1 <= 100) {
+                prefix = name.substr(0, slash);
+                rest = name.substr(slash + 1);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    std::string headerBlock(const std::string &name, char type, uint64_t size, unsigned mode, int64_t mtime,
+                            const std::string &linkName, const std::string &prefix) {
+        std::string block(BLOCK, '\0');
+        char *header = block.data();
+        std::memcpy(header, name.data(), std::min<size_t>(name.size(), 100));
+        writeOctal(header + 100, 8, mode);
+        writeOctal(header + 108, 8, 0);
+        writeOctal(header + 116, 8, 0);
+        writeOctal(header + 124, 12, size);
+        writeOctal(header + 136, 12, static_cast<uint64_t>(std::max<int64_t>(mtime, 0)));
+        header[156] = type;
+        std::memcpy(header + 157, linkName.data(), std::min<size_t>(linkName.size(), 100));
+        std::memcpy(header + 257, "ustar", 6);
+        std::memcpy(header + 263, "00", 2);
+        std::memcpy(header + 345, prefix.data(), std::min<size_t>(prefix.size(), 155));
+
+        std::memset(header + 148, ' ', 8);
+        unsigned checksum = 0;
+        for (unsigned char byte : block) checksum += byte;
+        std::snprintf(header + 148, 7, "%06o", checksum);
+        header[155] = ' ';
+        return block;
+    }
+
+    // Header blocks of one entry, preceded by a pax header when ustar cannot hold it
+    std::string makeEntry(const std::string &name, char type, uint64_t size, unsigned mode, int64_t mtime,
+                          const std::string &linkName = "") {
+        std::string pax;
+        std::string prefix;
+        std::string ustarName = name;
+        if (name.size() > 100 && !splitUstarName(name, prefix, ustarName)) {
+            pax += paxRecord("path", name);
+            ustarName = name.substr(0, 100);
+        }
+        if (linkName.size() > 100) pax += paxRecord("linkpath", linkName);
+        if (size > MAX_OCTAL_SIZE) pax += paxRecord("size", std::to_string(size));
+
+        std::string blocks;
+        if (!pax.empty()) {
+            blocks = headerBlock("PaxHeaders/" + ustarName.substr(0, 89), 'x', pax.size(), 0644, mtime, "", "");
+            blocks += pax;
+            blocks.append(paddingOf(pax.size()), '\0');
+        }
+        blocks += headerBlock(ustarName, type, size > MAX_OCTAL_SIZE ? 0 : size, mode, mtime, linkName, prefix);
+        return blocks;
+    }
+
+    int64_t modificationTime(const fs::path &path) {
+        std::error_code error;
+        const auto time = fs::last_write_time(path, error);
+        if (error) return 0;
+        return std::chrono::duration_cast<std::chrono::seconds>(
+                std::chrono::file_clock::to_sys(time).time_since_epoch()).count();
+    }
+}
+
+TarWriter::~TarWriter() {
+    if (prefetch) {
+        {
+            std::lock_guard lock(prefetch->mutex);
+            prefetch->stopping = true;
+        }
+        prefetch->space.notify_all();
+        for (auto &worker : prefetch->workers) worker.join();
+    }
+    if (file) std::fclose(file);
+}
+
+TarWriter &TarWriter::add(const fs::path &source, std::string archiveName) {
+    if (archiveName.empty()) {
+        archiveName = source.lexically_normal().filename().generic_string();
+        if (archiveName.empty()) archiveName = source.lexically_normal().parent_path().filename().generic_string();
+    }
+    while (!archiveName.empty() && archiveName.back() == '/') archiveName.pop_back();
+    if (archiveName.empty()) {
+        throw std::runtime_error("No archive name for " + source.string());
+    }
+    roots.push_back({source, std::move(archiveName), true});
+    return *this;
+}
+
+TarWriter &TarWriter::addEntry(const fs::path &source, std::string archiveName) {
+    while (!archiveName.empty() && archiveName.back() == '/') archiveName.pop_back();
+    if (archiveName.empty()) {
+        throw std::runtime_error("No archive name for " + source.string());
+    }
+    roots.push_back({source, std::move(archiveName), false});
+    return *this;
+}
+
+TarWriter &TarWriter::readAhead(size_t threads, size_t maxBytes, size_t maxFileSize) {
+    readAheadThreads = threads;
+    readAheadBytes = maxBytes;
+    readAheadFileLimit = maxFileSize;
+    return *this;
+}
+
+void TarWriter::startPrefetch() {
+    prefetch = std::make_unique<Prefetch>();
+    prefetch->states.assign(roots.size(), Prefetch::State::Pending);
+    prefetch->data.resize(roots.size());
+    const size_t threads = std::min(readAheadThreads, roots.size());
+    for (size_t i = 0; i < threads; ++i) {
+        prefetch->workers.emplace_back([this] { prefetchLoop(); });
+    }
+}
+
+void TarWriter::prefetchLoop() {
+    Prefetch &state = *prefetch;
+    std::unique_lock lock(state.mutex);
+    // Only the entry the reader is blocked on needs a wakeup; the others are picked up as it goes
+    auto publish = [&state](size_t index, Prefetch::State result) {
+        state.states[index] = result;
+        if (state.readerWaiting && index == state.consumed) state.ready.notify_one();
+    };
+
+    while (!state.stopping && state.claimed < roots.size()) {
+        const size_t index = state.claimed++;
+        const Root &root = roots[index];
+        lock.unlock();
+
+        std::error_code error;
+        const auto status = fs::symlink_status(root.source, error);
+        const uint64_t size = !error && status.type() == fs::file_type::regular ? fs::file_size(root.source, error) : 0;
+        if (error || root.recursive || status.type() != fs::file_type::regular || size > readAheadFileLimit) {
+            lock.lock();
+            publish(index, Prefetch::State::Skipped);
+            continue;
+        }
+
+        // The entry the reader waits for always goes through, or the budget could block it forever
+        lock.lock();
+        if (!(index == state.consumed || state.bufferedBytes + size <= readAheadBytes)) {
+            ++state.waitingWorkers;
+            state.space.wait(lock, [&] {
+                return state.stopping || index == state.consumed || state.bufferedBytes + size <= readAheadBytes;
+            });
+            --state.waitingWorkers;
+        }
+        if (state.stopping) break;
+        state.bufferedBytes += size;
+        lock.unlock();
+
+        std::string data;
+        bool loaded = false;
+        if (std::FILE *input = std::fopen(root.source.string().c_str(), "rb")) {
+            data.resize(size);
+            const size_t count = std::fread(data.data(), 1, size, input);
+            loaded = !std::ferror(input);
+            data.resize(count);
+            std::fclose(input);
+        }
+
+        lock.lock();
+        state.bufferedBytes -= size;
+        if (loaded) {
+            state.bufferedBytes += data.size();
+            state.data[index] = std::move(data);
+            publish(index, Prefetch::State::Ready);
+        } else {
+            // The reader opens it itself and reports the error
+            publish(index, Prefetch::State::Skipped);
+        }
+    }
+}
+
+bool TarWriter::queueEntry(const fs::path &source, const std::string &name, std::optional<size_t> root) {
+    std::error_code error;
+    const auto status = fs::symlink_status(source, error);
+    if (error) {
+        throw std::runtime_error(fmt::format("Cannot archive {}: {}", source.string(), error.message()));
+    }
+    const unsigned mode = static_cast<unsigned>(status.permissions()) & 07777;
+    const int64_t mtime = modificationTime(source);
+
+    switch (status.type()) {
+        case fs::file_type::regular: {
+            if (prefetch && root) {
+                std::unique_lock lock(prefetch->mutex);
+                prefetch->consumed = *root;
+                if (prefetch->states[*root] == Prefetch::State::Pending) {
+                    if (prefetch->waitingWorkers > 0) prefetch->space.notify_all();
+                    prefetch->readerWaiting = true;
+                    prefetch->ready.wait(lock, [&] { return prefetch->states[*root] != Prefetch::State::Pending; });
+                    prefetch->readerWaiting = false;
+                }
+                if (prefetch->states[*root] == Prefetch::State::Ready) {
+                    memory = std::move(prefetch->data[*root]);
+                    memoryOffset = 0;
+                    prefetch->bufferedBytes -= memory.size();
+                    if (prefetch->waitingWorkers > 0) prefetch->space.notify_all();
+                    lock.unlock();
+
+                    // Header from what was read, in case the file changed since
+                    pending = makeEntry(name, '0', memory.size(), mode, mtime);
+                    fileRemaining = memory.size();
+                    padding = paddingOf(memory.size());
+                    return true;
+                }
+            }
+
+            const uint64_t size = fs::file_size(source);
+            if (size > 0) {
+                file = std::fopen(source.string().c_str(), "rb");
+                if (!file) {
+                    throw std::runtime_error("Cannot open " + source.string());
+                }
+                // Reads go straight into the caller's buffer, stdio buffering would copy twice
+                std::setvbuf(file, nullptr, _IONBF, 0);
+            }
+            pending = makeEntry(name, '0', size, mode, mtime);
+            fileRemaining = size;
+            padding = paddingOf(size);
+            return true;
+        }
+        case fs::file_type::directory:
+            pending = makeEntry(name + "/", '5', 0, mode, mtime);
+            return true;
+        case fs::file_type::symlink:
+            pending = makeEntry(name, '2', 0, 0777, mtime, fs::read_symlink(source).generic_string());
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool TarWriter::nextEntry() {
+    while (true) {
+        if (walk) {
+            auto &iterator = *walk;
+            if (iterator != fs::recursive_directory_iterator()) {
+                const fs::path source = iterator->path();
+                const std::string name = walkName + "/" + source.lexically_relative(walkSource).generic_string();
+                std::error_code error;
+                iterator.increment(error);
+                if (error) {
+                    throw std::runtime_error(fmt::format("Cannot walk {}: {}", walkSource.string(), error.message()));
+                }
+                if (queueEntry(source, name)) return true;
+                continue;
+            }
+            walk.reset();
+        }
+
+        if (nextRoot >= roots.size()) return false;
+        const size_t index = nextRoot++;
+        const Root &root = roots[index];
+        if (!queueEntry(root.source, root.name, index)) continue;
+        if (root.recursive && fs::is_directory(fs::symlink_status(root.source))) {
+            // Symlinks inside are stored as links, not followed
+            walk.emplace(root.source, fs::directory_options::none);
+            walkSource = root.source;
+            walkName = root.name;
+        }
+        return true;
+    }
+}
+
+size_t TarWriter::read(char *buffer, size_t capacity) {
+    if (readAheadThreads > 0 && !prefetch) startPrefetch();
+
+    size_t written = 0;
+    while (written < capacity) {
+        if (pendingOffset < pending.size()) {
+            const size_t count = std::min(capacity - written, pending.size() - pendingOffset);
+            std::memcpy(buffer + written, pending.data() + pendingOffset, count);
+            pendingOffset += count;
+            written += count;
+            continue;
+        }
+        if (fileRemaining > 0 && memoryOffset < memory.size()) {
+            const size_t count = std::min(capacity - written, memory.size() - memoryOffset);
+            std::memcpy(buffer + written, memory.data() + memoryOffset, count);
+            memoryOffset += count;
+            written += count;
+            fileRemaining -= count;
+            if (fileRemaining == 0) {
+                memory.clear();
+                memoryOffset = 0;
+            }
+            continue;
+        }
+        if (fileRemaining > 0) {
+            const size_t wanted = static_cast<size_t>(std::min<uint64_t>(capacity - written, fileRemaining));
+            size_t count = file ? std::fread(buffer + written, 1, wanted, file) : 0;
+            if (count == 0) {
+                // The file shrank while archived: zeros keep the declared size
+                std::memset(buffer + written, 0, wanted);
+                count = wanted;
+            }
+            written += count;
+            fileRemaining -= count;
+            if (fileRemaining == 0 && file) {
+                std::fclose(file);
+                file = nullptr;
+            }
+            continue;
+        }
+        if (padding > 0) {
+            const size_t count = std::min(capacity - written, padding);
+            std::memset(buffer + written, 0, count);
+            padding -= count;
+            written += count;
+            continue;
+        }
+
+        pending.clear();
+        pendingOffset = 0;
+        if (nextEntry()) continue;
+        if (trailerQueued) break;
+        // End of archive: two zero blocks
+        pending.assign(2 * BLOCK, '\0');
+        trailerQueued = true;
+    }
+    produced += written;
+    return written;
+}
+
+TarReader::TarReader(fs::path destinationPath) : destination(std::move(destinationPath)) {
+    fs::create_directories(destination);
+}
+
+TarReader::~TarReader() {
+    if (file) std::fclose(file);
+}
+
+fs::path TarReader::resolve(const std::string &name) const {
+    const fs::path relative = fs::path(name).lexically_normal();
+    if (relative.has_root_path() || (!relative.empty() && *relative.begin() == "..")) {
+        throw std::runtime_error("Tar entry escapes the destination: " + name);
+    }
+    // A symlink extracted earlier must not redirect later entries outside the destination
+    fs::path current = destination;
+    for (const auto &component : relative.parent_path()) {
+        current /= component;
+        if (fs::is_symlink(fs::symlink_status(current))) {
+            throw std::runtime_error("Tar entry goes through a symlink: " + name);
+        }
+    }
+    return destination / relative;
+}
+
+void TarReader::beginEntry() {
+    if (std::all_of(header, header + BLOCK, [](char byte) { return byte == '\0'; })) {
+        ++zeroBlocks;
+        return;
+    }
+    zeroBlocks = 0;
+
+    unsigned checksum = 0;
+    for (size_t i = 0; i < BLOCK; ++i) {
+        checksum += (i >= 148 && i < 156) ? ' ' : static_cast<unsigned char>(header[i]);
+    }
+    if (checksum != parseNumeric(header + 148, 8)) {
+        throw std::runtime_error("Invalid tar header checksum");
+    }
+
+    std::string name = field(header, 100);
+    if (std::memcmp(header + 257, "ustar", 5) == 0 && header[345] != '\0') {
+        name = field(header + 345, 155) + "/" + name;
+    }
+    if (!longName.empty()) name = longName;
+    const std::string linkName = longLink.empty() ? field(header + 157, 100) : longLink;
+    const uint64_t size = paxSize.value_or(parseNumeric(header + 124, 12));
+    const char type = header[156];
+
+    remaining = size;
+    padding = paddingOf(size);
+    target = Target::None;
+    extra.clear();
+
+    switch (type) {
+        case 'L':
+            target = Target::LongName;
+            break;
+        case 'K':
+            target = Target::LongLink;
+            break;
+        case 'x':
+            target = Target::Pax;
+            break;
+        case 'g':
+            break;
+        case '0':
+        case '\0':
+        case '7': {
+            filePath = resolve(name);
+            fs::create_directories(filePath.parent_path());
+            std::error_code ignored;
+            if (fs::is_symlink(fs::symlink_status(filePath, ignored))) fs::remove(filePath, ignored);
+            file = std::fopen(filePath.string().c_str(), "wb");
+            if (!file) {
+                throw std::runtime_error("Cannot create " + filePath.string());
+            }
+            std::setvbuf(file, nullptr, _IONBF, 0);
+            fileMode = static_cast<unsigned>(parseNumeric(header + 100, 8)) & 07777;
+            fileMtime = static_cast<int64_t>(parseNumeric(header + 136, 12));
+            target = Target::File;
+            break;
+        }
+        case '5':
+            fs::create_directories(resolve(name));
+            ++extracted;
+            break;
+        case '2': {
+            const fs::path path = resolve(name);
+            fs::create_directories(path.parent_path());
+            std::error_code ignored;
+            fs::remove(path, ignored);
+            fs::create_symlink(linkName, path);
+            ++extracted;
+            break;
+        }
+        case '1': {
+            const fs::path path = resolve(name);
+            fs::create_directories(path.parent_path());
+            std::error_code ignored;
+            fs::remove(path, ignored);
+            fs::create_hard_link(resolve(linkName), path);
+            ++extracted;
+            break;
+        }
+        default:
+            // Devices, fifos: skipped
+            break;
+    }
+
+    if (target != Target::LongName && target != Target::LongLink && target != Target::Pax) {
+        longName.clear();
+        longLink.clear();
+        paxSize.reset();
+    }
+    if (remaining == 0) endEntry();
+}
+
+void TarReader::endEntry() {
+    switch (target) {
+        case Target::File: {
+            const bool failed = std::fclose(file) != 0;
+            file = nullptr;
+            if (failed) {
+                throw std::runtime_error("Failed to write " + filePath.string());
+            }
+            std::error_code ignored;
+            fs::permissions(filePath, static_cast<fs::perms>(fileMode), ignored);
+            fs::last_write_time(filePath, std::chrono::file_clock::from_sys(
+                    std::chrono::sys_seconds(std::chrono::seconds(fileMtime))), ignored);
+            ++extracted;
+            break;
+        }
+        case Target::LongName:
+            longName = extra.substr(0, extra.find('\0'));
+            break;
+        case Target::LongLink:
+            longLink = extra.substr(0, extra.find('\0'));
+            break;
+        case Target::Pax: {
+            std::string_view records = extra;
+            while (!records.empty()) {
+                const size_t space = records.find(' ');
+                if (space == std::string_view::npos) break;
+                const size_t length = std::strtoull(std::string(records.substr(0, space)).c_str(), nullptr, 10);
+                if (length <= space + 1 || length > records.size()) break;
+                std::string_view record = records.substr(space + 1, length - space - 2);
+                records.remove_prefix(length);
+
+                const size_t equals = record.find('=');
+                if (equals == std::string_view::npos) continue;
+                const std::string_view key = record.substr(0, equals);
+                const std::string_view value = record.substr(equals + 1);
+                if (key == "path") longName = value;
+                else if (key == "linkpath") longLink = value;
+                else if (key == "size") paxSize = std::strtoull(std::string(value).c_str(), nullptr, 10);
+            }
+            break;
+        }
+        case Target::None:
+            break;
+    }
+    target = Target::None;
+}
+
+void TarReader::feed(const char *data, size_t size) {
+    while (size > 0) {
+        if (remaining > 0) {
+            const size_t count = static_cast<size_t>(std::min<uint64_t>(size, remaining));
+            if (target == Target::File) {
+                if (std::fwrite(data, 1, count, file) != count) {
+                    throw std::runtime_error("Failed to write " + filePath.string());
+                }
+            } else if (target != Target::None) {
+                if (extra.size() + count > MAX_EXTRA_BYTES) {
+                    throw std::runtime_error("Tar extended header too large");
+                }
+                extra.append(data, count);
+            }
+            data += count;
+            size -= count;
+            remaining -= count;
+            if (remaining == 0) endEntry();
+            continue;
+        }
+        if (padding > 0) {
+            const size_t count = std::min(size, padding);
+            data += count;
+            size -= count;
+            padding -= count;
+            continue;
+        }
+
+        const size_t count = std::min(size, BLOCK - headerFill);
+        std::memcpy(header + headerFill, data, count);
+        headerFill += count;
+        data += count;
+        size -= count;
+        if (headerFill < BLOCK) break;
+        headerFill = 0;
+        beginEntry();
+    }
+}
+
+void TarReader::finish() {
+    if (remaining > 0 || padding > 0 || headerFill > 0) {
+        throw std::runtime_error("Truncated tar archive");
+    }
+}
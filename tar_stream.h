@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) 2025 Nokaji. Tous droits réservés.
+ * Ce fichier fait partie du projet Kernel-James.
+ */
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+ * Tar archive produced on the fly from local files and directories, in the
+ * format expected by PUT /containers/{id}/archive and POST /build (ustar, with
+ * pax records for long names and files above 8 GiB). read() is a pull source:
+ * headers are built when an entry is reached and file contents are read
+ * straight into the caller's buffer, so an archive of any size costs one entry
+ * of state. With readAhead(), small explicit entries are loaded by a few
+ * threads ahead of the reader, within a byte budget, which hides per-file
+ * open/read latency on trees of many small files.
+ */
+class TarWriter
+{
+    private:
+        struct Root {
+            std::filesystem::path source;
+            std::string name;
+            bool recursive;
+        };
+
+        // Files loaded ahead of read(), indexed like roots
+        struct Prefetch {
+            enum class State : uint8_t { Pending, Ready, Skipped };
+
+            std::mutex mutex;
+            std::condition_variable ready;      // the reader waits for its entry
+            std::condition_variable space;      // workers wait for the byte budget
+            std::vector<State> states;
+            std::vector<std::string> data;
+            size_t claimed = 0;         // next root a worker takes
+            size_t consumed = 0;        // root the reader is at
+            size_t bufferedBytes = 0;
+            size_t waitingWorkers = 0;
+            bool readerWaiting = false;
+            bool stopping = false;
+            std::vector<std::thread> workers;
+        };
+
+        std::vector<Root> roots;
+        size_t nextRoot = 0;
+        std::optional<std::filesystem::recursive_directory_iterator> walk;
+        std::filesystem::path walkSource;
+        std::string walkName;
+
+        size_t readAheadThreads = 0;
+        size_t readAheadBytes = 0;
+        size_t readAheadFileLimit = 0;
+        std::unique_ptr<Prefetch> prefetch;
+
+        std::string pending;            // header blocks not handed out yet
+        size_t pendingOffset = 0;
+        std::FILE *file = nullptr;
+        std::string memory;             // contents of a prefetched file
+        size_t memoryOffset = 0;
+        uint64_t fileRemaining = 0;
+        size_t padding = 0;
+        bool trailerQueued = false;
+        uint64_t produced = 0;
+
+        // Queues the header (and opens the file) of the next entry; false when there is none
+        bool nextEntry();
+        // False for entries tar cannot hold (sockets, devices)
+        bool queueEntry(const std::filesystem::path &source, const std::string &name, std::optional<size_t> root = std::nullopt);
+        void startPrefetch();
+        void prefetchLoop();
+
+    public:
+        TarWriter() = default;
+        ~TarWriter();
+
+        TarWriter(const TarWriter &) = delete;
+        TarWriter &operator=(const TarWriter &) = delete;
+
+        // A file, symlink or whole directory, stored as archiveName (its file name by default)
+        TarWriter &add(const std::filesystem::path &source, std::string archiveName = "");
+
+        // One entry, not recursed into when it is a directory
+        TarWriter &addEntry(const std::filesystem::path &source, std::string archiveName);
+
+        // Loads explicit entries up to maxFileSize with threads, keeping at most maxBytes
+        // loaded ahead. Entries must all be added before the first read().
+        TarWriter &readAhead(size_t threads, size_t maxBytes = 64 * 1024 * 1024, size_t maxFileSize = 1024 * 1024);
+
+        // Writes up to capacity bytes of the archive, 0 once it is complete
+        size_t read(char *buffer, size_t capacity);
+
+        [[nodiscard]] uint64_t bytesProduced() const { return produced; }
+};
+
+/*
+ * Incremental tar extractor: feed() takes the archive in chunks of any size,
+ * as GET /containers/{id}/archive delivers it, and writes entries under the
+ * destination directory as their data arrives. Entries escaping the
+ * destination (absolute paths, "..") are rejected.
+ */
+class TarReader
+{
+    private:
+        std::filesystem::path destination;
+
+        char header[512];
+        size_t headerFill = 0;
+
+        enum class Target { None, File, LongName, LongLink, Pax };
+        Target target = Target::None;
+        uint64_t remaining = 0;         // data bytes of the current entry
+        size_t padding = 0;
+        std::FILE *file = nullptr;
+        std::filesystem::path filePath;
+        unsigned fileMode = 0;
+        int64_t fileMtime = 0;
+        std::string extra;              // long name, long link or pax records being collected
+
+        // Overrides from GNU long name/link entries or pax records, for the next entry
+        std::string longName;
+        std::string longLink;
+        std::optional<uint64_t> paxSize;
+        int zeroBlocks = 0;
+        uint64_t extracted = 0;
+
+        void beginEntry();
+        void endEntry();
+        [[nodiscard]] std::filesystem::path resolve(const std::string &name) const;
+
+    public:
+        explicit TarReader(std::filesystem::path destination);
+        ~TarReader();
+
+        TarReader(const TarReader &) = delete;
+        TarReader &operator=(const TarReader &) = delete;
+
+        void feed(const char *data, size_t size);
+
+        // Throws if the archive stopped in the middle of an entry
+        void finish();
+
+        [[nodiscard]] uint64_t entries() const { return extracted; }
+};
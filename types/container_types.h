@@ -4,6 +4,8 @@
  */
 #pragma once
 
+#include <chrono>
+#include <cstdint>
 #include <string>
 #include <map>
 #include <vector>
@@ -23,6 +25,20 @@ namespace containerTypes {
         UNKNOWN
     };
 
+    // Stream a log line came from (first byte of each multiplexed frame header)
+    enum class LogStream : uint8_t {
+        STDIN = 0,
+        STDOUT = 1,
+        STDERR = 2
+    };
+
+    // Position reached in a container's logs, so the next read only asks for what came after.
+    // The daemon filters since= inclusively: lines sharing the last timestamp are counted to skip them.
+    struct LogCursor {
+        int64_t lastTimestamp = 0; // nanoseconds since epoch, 0 = from the beginning
+        size_t seenAtLastTimestamp = 0;
+    };
+
     struct Platform {
         std::string architecture;
         std::string os;
@@ -485,4 +501,53 @@ namespace containerTypes {
             return j;
         }
     };
+
+    struct ExecConfig {
+        std::vector<std::string> cmd;
+        std::vector<std::string> env;
+        std::string workingDir;
+        std::string user;
+        bool attachStdin = false;
+        bool attachStdout = true;
+        bool attachStderr = true;
+        bool tty = false;
+        bool privileged = false;
+        std::string detachKeys;
+
+        nlohmann::json toJson() const {
+            nlohmann::json j;
+            j["Cmd"] = cmd;
+            j["AttachStdin"] = attachStdin;
+            j["AttachStdout"] = attachStdout;
+            j["AttachStderr"] = attachStderr;
+            j["Tty"] = tty;
+            j["Privileged"] = privileged;
+            if (!env.empty()) j["Env"] = env;
+            if (!workingDir.empty()) j["WorkingDir"] = workingDir;
+            if (!user.empty()) j["User"] = user;
+            if (!detachKeys.empty()) j["DetachKeys"] = detachKeys;
+            return j;
+        }
+    };
+
+    struct ExecInspect {
+        std::string id;
+        std::string containerId;
+        bool running = false;
+        int exitCode = -1; // -1 while running
+        int pid = 0;
+        bool openStdin = false;
+        bool tty = false;
+    };
+
+    // Outcome of a command run to completion with Container::exec()
+    struct ExecResult {
+        int exitCode = -1;          // meaningful only when exitCodeKnown
+        bool exitCodeKnown = false; // false on timeout, or when the daemon still reported the process running
+        std::string output;         // stdout (everything when Tty)
+        std::string errors;         // stderr
+        bool truncated = false;     // output exceeded the byte limit
+        bool timedOut = false;      // the command was still running at the deadline
+        std::chrono::milliseconds duration{0};
+    };
 };
\ No newline at end of file
@@ -4,6 +4,8 @@
  */
 #pragma once
 
+#include <chrono>
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <map>
@@ -80,7 +82,7 @@ namespace imageTypes
         std::string parentId;
         std::vector<std::string> repoTags;
         std::vector<std::string> repoDigests;
-        int created;
+        int64_t created;
         int64_t size;
         int64_t sharedSize;
         int64_t virtualSize;
@@ -90,6 +92,62 @@ namespace imageTypes
         OCIDescriptor descriptor = {};
     };
 
+    // Progress of an image tarball transfer (save/load)
+    struct TransferProgress
+    {
+        uint64_t bytes = 0;
+        uint64_t total = 0;                 // 0 when unknown, as for save
+        std::chrono::milliseconds elapsed{0};
+    };
+
+    // One message of a pull stream. Layer messages carry the layer id; others
+    // ("Pulling from ...", "Digest: ...") have an empty id.
+    struct PullEvent
+    {
+        std::string id;
+        std::string status;                 // "Downloading", "Extracting", "Pull complete", ...
+        int64_t current = 0;                // bytes, when the status has a progress detail
+        int64_t total = 0;
+    };
+
+    // Whole pull so far, summed over the layers announced by the daemon
+    struct PullProgress
+    {
+        std::string reference;
+        size_t layers = 0;
+        size_t layersComplete = 0;          // extracted or already present
+        int64_t bytesDone = 0;              // downloaded
+        int64_t bytesTotal = 0;             // of the layers whose size is known yet
+        double bytesPerSecond = 0;
+        std::chrono::milliseconds elapsed{0};
+        std::chrono::milliseconds eta{-1};  // -1 until a rate and size are known
+    };
+
+    struct BuildOptions
+    {
+        std::vector<std::string> tags;      // "name:tag", each applied to the result
+        std::string dockerfile = "Dockerfile";  // relative to the context
+        std::map<std::string, std::string> buildArgs;
+        std::map<std::string, std::string> labels;
+        std::string target;                 // multi-stage target
+        std::string platform;
+        std::string networkMode;
+        bool noCache = false;
+        bool pull = false;                  // refresh base images
+        bool removeIntermediate = true;
+        size_t readAheadThreads = 4;        // context packing; used only with several cores
+    };
+
+    // One message of a build stream; only one of stream, status or error is set
+    struct BuildEvent
+    {
+        std::string stream;                 // build output, e.g. "Step 2/5 : RUN make\n"
+        std::string status;                 // base image pull
+        std::string id;
+        std::string imageId;                // once the daemon reports the built image
+        std::string error;
+    };
+
     
 
     
@@ -0,0 +1,43 @@
+/*
+ * Copyright (c) 2025 Nokaji. Tous droits réservés.
+ * Ce fichier fait partie du projet Kernel-James.
+ */
+#pragma once
+
+#include <cstdint>
+
+namespace statsTypes
+{
+    // Raw counters of one /containers/{id}/stats sample, only the fields we derive metrics from
+    struct ContainerStatsSample
+    {
+        int64_t read = 0;                   // sample time, nanoseconds since epoch
+        uint64_t cpuTotal = 0;              // cpu_stats.cpu_usage.total_usage (ns)
+        uint64_t systemCpu = 0;             // cpu_stats.system_cpu_usage (ns)
+        uint64_t previousCpuTotal = 0;      // precpu_stats, the daemon's previous sample
+        uint64_t previousSystemCpu = 0;
+        uint32_t onlineCpus = 0;
+        uint64_t memoryUsage = 0;
+        uint64_t memoryLimit = 0;
+        uint64_t memoryInactiveFile = 0;    // page cache that can be reclaimed
+        uint64_t networkRxBytes = 0;        // summed over interfaces
+        uint64_t networkTxBytes = 0;
+        uint64_t blockReadBytes = 0;
+        uint64_t blockWriteBytes = 0;
+        uint64_t pids = 0;
+    };
+
+    // Values computed from a sample and the one before it; rates are per second
+    struct ContainerMetrics
+    {
+        int64_t timestamp = 0;
+        double cpuPercent = 0;              // 100 = one full CPU
+        uint64_t memoryWorkingSet = 0;      // usage minus inactive file cache
+        double memoryPercent = 0;
+        double networkRxRate = 0;
+        double networkTxRate = 0;
+        double blockReadRate = 0;
+        double blockWriteRate = 0;
+        uint64_t pids = 0;
+    };
+}